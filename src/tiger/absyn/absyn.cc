@@ -24,101 +24,8 @@ AbsynTree::AbsynTree(absyn::Exp *root) : root_(root) {
     throw std::invalid_argument("NULL pointer is not allowed in AbsynTree");
 }
 
-AbsynTree::~AbsynTree() { delete root_; }
-
 void AbsynTree::Print(FILE *out) const { root_->Print(out, 0); }
 
-SimpleVar::~SimpleVar() { delete sym_; }
-
-FieldVar::~FieldVar() {
-  delete var_;
-  delete sym_;
-}
-
-SubscriptVar::~SubscriptVar() {
-  delete var_;
-  delete subscript_;
-}
-
-VarExp::~VarExp() { delete var_; }
-
-NilExp::~NilExp() = default;
-
-IntExp::~IntExp() = default;
-
-StringExp::~StringExp() = default;
-
-CallExp::~CallExp() {
-  delete func_;
-  delete args_;
-}
-
-OpExp::~OpExp() {
-  delete left_;
-  delete right_;
-}
-
-RecordExp::~RecordExp() {
-  delete typ_;
-  delete fields_;
-}
-
-SeqExp::~SeqExp() { delete seq_; }
-
-AssignExp::~AssignExp() {
-  delete var_;
-  delete exp_;
-}
-
-IfExp::~IfExp() {
-  delete test_;
-  delete then_;
-  delete elsee_;
-}
-
-WhileExp::~WhileExp() {
-  delete test_;
-  delete body_;
-}
-
-ForExp::~ForExp() = default;
-
-BreakExp::~BreakExp() = default;
-
-LetExp::~LetExp() {
-  delete decs_;
-  delete body_;
-}
-
-ArrayExp::~ArrayExp() {
-  delete typ_;
-  delete size_;
-  delete init_;
-}
-
-VoidExp::~VoidExp() = default;
-
-EField::~EField() {
-  delete name_;
-  delete exp_;
-}
-
-FunctionDec::~FunctionDec() { delete functions_; }
-
-VarDec::~VarDec() {
-  delete var_;
-  delete typ_;
-  delete init_;
-}
-
-TypeDec::~TypeDec() { delete types_; }
-
-NameTy::~NameTy() { delete name_; }
-
-RecordTy::~RecordTy() { delete record_; }
-
-ArrayTy::~ArrayTy() { delete array_; }
-
 void SimpleVar::Print(FILE *out, int d) const {
   Indent(out, d);
   fprintf(out, "simpleVar(%s)", sym_->Name().data());
@@ -379,7 +286,7 @@ type::TyList *FieldList::MakeFormalTyList(env::TEnvPtr tenv,
 
     if (!ty) {
       errormsg->Error(param->pos_, "undefined type %s",
-                      param->typ_->Name().c_str());
+                      param->typ_->Name().data());
     }
     formal_tylist->Append(ty);
   }
@@ -399,7 +306,7 @@ type::FieldList *FieldList::MakeFieldList(env::TEnvPtr tenv,
     type::Ty *ty = tenv->Look(a_field->typ_);
     if (ty == nullptr) {
       errormsg->Error(a_field->pos_, "undefined type %s",
-                      a_field->typ_->Name().c_str());
+                      a_field->typ_->Name().data());
     }
     ty_field_list->Append(new type::Field(a_field->name_, ty));
   }
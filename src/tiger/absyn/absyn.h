@@ -3,6 +3,7 @@
 
 #include <cstdio>
 #include <list>
+#include <memory_resource>
 #include <string>
 
 #include "tiger/env/env.h"
@@ -11,6 +12,7 @@
 #include "tiger/frame/frame.h"
 #include "tiger/semant/types.h"
 #include "tiger/symbol/symbol.h"
+#include "tiger/util/arena.h"
 
 /**
  * Forward Declarations
@@ -49,7 +51,8 @@ enum Oper {
 };
 
 /**
- * Abstract syntax tree root
+ * Abstract syntax tree root. The nodes own nothing: they are allocated in the
+ * absyn arena current while parsing and are freed when it is released.
  */
 class AbsynTree {
 public:
@@ -60,7 +63,7 @@ public:
   AbsynTree(AbsynTree &&absyn_tree) = delete;
   AbsynTree &operator=(const AbsynTree &absyn_tree) = delete;
   AbsynTree &operator=(AbsynTree &&absyn_tree) = delete;
-  ~AbsynTree();
+  ~AbsynTree() = default;
 
   void Print(FILE *out) const;
   void SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
@@ -78,7 +81,7 @@ private:
  * Variables
  */
 
-class Var {
+class Var : public util::AbsynObject {
 public:
   int pos_;
   virtual ~Var() = default;
@@ -99,7 +102,6 @@ class SimpleVar : public Var {
 public:
   sym::Symbol *sym_;
   SimpleVar(int pos, sym::Symbol *sym) : Var(pos), sym_(sym) {}
-  ~SimpleVar() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -117,7 +119,6 @@ public:
 
   FieldVar(int pos, Var *var, sym::Symbol *sym)
       : Var(pos), var_(var), sym_(sym) {}
-  ~FieldVar() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -135,7 +136,6 @@ public:
 
   SubscriptVar(int pos, Var *var, Exp *exp)
       : Var(pos), var_(var), subscript_(exp) {}
-  ~SubscriptVar() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -150,7 +150,7 @@ public:
  * Expressions
  */
 
-class Exp {
+class Exp : public util::AbsynObject {
 public:
   int pos_;
   virtual ~Exp() = default;
@@ -172,7 +172,6 @@ public:
   Var *var_;
 
   VarExp(int pos, Var *var) : Exp(pos), var_(var) {}
-  ~VarExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -186,7 +185,6 @@ public:
 class NilExp : public Exp {
 public:
   explicit NilExp(int pos) : Exp(pos) {}
-  ~NilExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -202,7 +200,6 @@ public:
   int val_;
 
   IntExp(int pos, int val) : Exp(pos), val_(val) {}
-  ~IntExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -215,10 +212,10 @@ public:
 
 class StringExp : public Exp {
 public:
-  std::string str_;
+  std::pmr::string str_;
 
-  StringExp(int pos, std::string *str) : Exp(pos), str_(*str) {}
-  ~StringExp() override;
+  StringExp(int pos, std::string *str)
+      : Exp(pos), str_(*str, Resource()) {}
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -238,7 +235,6 @@ public:
       : Exp(pos), func_(func), args_(args) {
     assert(args);
   }
-  ~CallExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -256,7 +252,6 @@ public:
 
   OpExp(int pos, Oper oper, Exp *left, Exp *right)
       : Exp(pos), oper_(oper), left_(left), right_(right) {}
-  ~OpExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -274,7 +269,6 @@ public:
 
   RecordExp(int pos, sym::Symbol *typ, EFieldList *fields)
       : Exp(pos), typ_(typ), fields_(fields) {}
-  ~RecordExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -290,7 +284,6 @@ public:
   ExpList *seq_;
 
   SeqExp(int pos, ExpList *seq) : Exp(pos), seq_(seq) {}
-  ~SeqExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -307,7 +300,6 @@ public:
   Exp *exp_;
 
   AssignExp(int pos, Var *var, Exp *exp) : Exp(pos), var_(var), exp_(exp) {}
-  ~AssignExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -324,7 +316,6 @@ public:
 
   IfExp(int pos, Exp *test, Exp *then, Exp *elsee)
       : Exp(pos), test_(test), then_(then), elsee_(elsee) {}
-  ~IfExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -341,7 +332,6 @@ public:
 
   WhileExp(int pos, Exp *test, Exp *body)
       : Exp(pos), test_(test), body_(body) {}
-  ~WhileExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -360,7 +350,6 @@ public:
 
   ForExp(int pos, sym::Symbol *var, Exp *lo, Exp *hi, Exp *body)
       : Exp(pos), var_(var), lo_(lo), hi_(hi), body_(body), escape_(true) {}
-  ~ForExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -374,7 +363,6 @@ public:
 class BreakExp : public Exp {
 public:
   explicit BreakExp(int pos) : Exp(pos) {}
-  ~BreakExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -392,7 +380,6 @@ public:
 
   LetExp(int pos, DecList *decs, Exp *body)
       : Exp(pos), decs_(decs), body_(body) {}
-  ~LetExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -410,7 +397,6 @@ public:
 
   ArrayExp(int pos, sym::Symbol *typ, Exp *size, Exp *init)
       : Exp(pos), typ_(typ), size_(size), init_(init) {}
-  ~ArrayExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -424,7 +410,6 @@ public:
 class VoidExp : public Exp {
 public:
   explicit VoidExp(int pos) : Exp(pos) {}
-  ~VoidExp() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -439,7 +424,7 @@ public:
  * Declarations
  */
 
-class Dec {
+class Dec : public util::AbsynObject {
 public:
   int pos_;
   virtual ~Dec() = default;
@@ -461,7 +446,6 @@ public:
 
   FunctionDec(int pos, FunDecList *functions)
       : Dec(pos), functions_(functions) {}
-  ~FunctionDec() override;
 
   void Print(FILE *out, int d) const override;
   void SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -481,7 +465,6 @@ public:
 
   VarDec(int pos, sym::Symbol *var, sym::Symbol *typ, Exp *init)
       : Dec(pos), var_(var), typ_(typ), init_(init), escape_(true) {}
-  ~VarDec() override;
 
   void Print(FILE *out, int d) const override;
   void SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -497,7 +480,6 @@ public:
   NameAndTyList *types_;
 
   TypeDec(int pos, NameAndTyList *types) : Dec(pos), types_(types) {}
-  ~TypeDec() override;
 
   void Print(FILE *out, int d) const override;
   void SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
@@ -512,7 +494,7 @@ public:
  * Types
  */
 
-class Ty {
+class Ty : public util::AbsynObject {
 public:
   int pos_;
   virtual ~Ty() = default;
@@ -531,7 +513,6 @@ public:
   sym::Symbol *name_;
 
   NameTy(int pos, sym::Symbol *name) : Ty(pos), name_(name) {}
-  ~NameTy() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::TEnvPtr tenv,
@@ -545,7 +526,6 @@ public:
   FieldList *record_;
 
   RecordTy(int pos, FieldList *record) : Ty(pos), record_(record) {}
-  ~RecordTy() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::TEnvPtr tenv,
@@ -559,7 +539,6 @@ public:
   sym::Symbol *array_;
 
   ArrayTy(int pos, sym::Symbol *array) : Ty(pos), array_(array) {}
-  ~ArrayTy() override;
 
   void Print(FILE *out, int d) const override;
   type::Ty *SemAnalyze(env::TEnvPtr tenv,
@@ -572,7 +551,7 @@ public:
  * Linked lists and nodes of lists
  */
 
-class Field {
+class Field : public util::AbsynObject {
 public:
   int pos_;
   sym::Symbol *name_, *typ_;
@@ -584,16 +563,18 @@ public:
   void Print(FILE *out, int d) const;
 };
 
-class FieldList {
+class FieldList : public util::AbsynObject {
 public:
   FieldList() = default;
-  explicit FieldList(Field *field) : field_list_({field}) { assert(field); }
+  explicit FieldList(Field *field) : field_list_({field}, Resource()) {
+    assert(field);
+  }
 
   FieldList *Prepend(Field *field) {
     field_list_.push_front(field);
     return this;
   }
-  [[nodiscard]] const std::list<Field *> &GetList() const {
+  [[nodiscard]] const std::pmr::list<Field *> &GetList() const {
     return field_list_;
   }
   void Print(FILE *out, int d) const;
@@ -603,26 +584,30 @@ public:
                                  err::ErrorMsg *errormsg) const;
 
 private:
-  std::list<Field *> field_list_;
+  std::pmr::list<Field *> field_list_{Resource()};
 };
 
-class ExpList {
+class ExpList : public util::AbsynObject {
 public:
   ExpList() = default;
-  explicit ExpList(Exp *exp) : exp_list_({exp}) { assert(exp); }
+  explicit ExpList(Exp *exp) : exp_list_({exp}, Resource()) {
+    assert(exp);
+  }
 
   ExpList *Prepend(Exp *exp) {
     exp_list_.push_front(exp);
     return this;
   }
-  [[nodiscard]] const std::list<Exp *> &GetList() const { return exp_list_; }
+  [[nodiscard]] const std::pmr::list<Exp *> &GetList() const {
+    return exp_list_;
+  }
   void Print(FILE *out, int d) const;
 
 private:
-  std::list<Exp *> exp_list_;
+  std::pmr::list<Exp *> exp_list_{Resource()};
 };
 
-class FunDec {
+class FunDec : public util::AbsynObject {
 public:
   int pos_;
   sym::Symbol *name_;
@@ -639,9 +624,10 @@ public:
   void Print(FILE *out, int d) const;
 };
 
-class FunDecList {
+class FunDecList : public util::AbsynObject {
 public:
-  explicit FunDecList(FunDec *fun_dec) : fun_dec_list_({fun_dec}) {
+  explicit FunDecList(FunDec *fun_dec)
+      : fun_dec_list_({fun_dec}, Resource()) {
     assert(fun_dec);
   }
 
@@ -649,32 +635,34 @@ public:
     fun_dec_list_.push_front(fun_dec);
     return this;
   }
-  [[nodiscard]] const std::list<FunDec *> &GetList() const {
+  [[nodiscard]] const std::pmr::list<FunDec *> &GetList() const {
     return fun_dec_list_;
   }
   void Print(FILE *out, int d) const;
 
 private:
-  std::list<FunDec *> fun_dec_list_;
+  std::pmr::list<FunDec *> fun_dec_list_{Resource()};
 };
 
-class DecList {
+class DecList : public util::AbsynObject {
 public:
   DecList() = default;
-  explicit DecList(Dec *dec) : dec_list_({dec}) { assert(dec); }
+  explicit DecList(Dec *dec) : dec_list_({dec}, Resource()) { assert(dec); }
 
   DecList *Prepend(Dec *dec) {
     dec_list_.push_front(dec);
     return this;
   }
-  [[nodiscard]] const std::list<Dec *> &GetList() const { return dec_list_; }
+  [[nodiscard]] const std::pmr::list<Dec *> &GetList() const {
+    return dec_list_;
+  }
   void Print(FILE *out, int d) const;
 
 private:
-  std::list<Dec *> dec_list_;
+  std::pmr::list<Dec *> dec_list_{Resource()};
 };
 
-class NameAndTy {
+class NameAndTy : public util::AbsynObject {
 public:
   sym::Symbol *name_;
   Ty *ty_;
@@ -684,25 +672,25 @@ public:
   void Print(FILE *out, int d) const;
 };
 
-class NameAndTyList {
+class NameAndTyList : public util::AbsynObject {
 public:
   explicit NameAndTyList(NameAndTy *name_and_ty)
-      : name_and_ty_list_({name_and_ty}) {}
+      : name_and_ty_list_({name_and_ty}, Resource()) {}
 
   NameAndTyList *Prepend(NameAndTy *name_and_ty) {
     name_and_ty_list_.push_front(name_and_ty);
     return this;
   }
-  [[nodiscard]] const std::list<NameAndTy *> &GetList() const {
+  [[nodiscard]] const std::pmr::list<NameAndTy *> &GetList() const {
     return name_and_ty_list_;
   }
   void Print(FILE *out, int d) const;
 
 private:
-  std::list<NameAndTy *> name_and_ty_list_;
+  std::pmr::list<NameAndTy *> name_and_ty_list_{Resource()};
 };
 
-class EField {
+class EField : public util::AbsynObject {
 public:
   sym::Symbol *name_;
   Exp *exp_;
@@ -712,27 +700,27 @@ public:
   EField(EField &&efield) = delete;
   EField &operator=(const EField &efield) = delete;
   EField &operator=(EField &&efield) = delete;
-  ~EField();
 
   void Print(FILE *out, int d) const;
 };
 
-class EFieldList {
+class EFieldList : public util::AbsynObject {
 public:
   EFieldList() = default;
-  explicit EFieldList(EField *efield) : efield_list_({efield}) {}
+  explicit EFieldList(EField *efield)
+      : efield_list_({efield}, Resource()) {}
 
   EFieldList *Prepend(EField *efield) {
     efield_list_.push_front(efield);
     return this;
   }
-  [[nodiscard]] const std::list<EField *> &GetList() const {
+  [[nodiscard]] const std::pmr::list<EField *> &GetList() const {
     return efield_list_;
   }
   void Print(FILE *out, int d) const;
 
 private:
-  std::list<EField *> efield_list_;
+  std::pmr::list<EField *> efield_list_{Resource()};
 };
 
 }; // namespace absyn
@@ -0,0 +1,22 @@
+#include "tiger/bench/args.h"
+
+#include <climits>
+#include <cstdlib>
+
+namespace bench {
+
+bool ParseSizes(const char *text, int min, std::vector<int> &sizes) {
+  sizes.clear();
+  while (*text) {
+    char *end;
+    long size = strtol(text, &end, 10);
+    if (end == text || size < min || size > INT_MAX ||
+        (*end != ',' && *end != '\0'))
+      return false;
+    sizes.push_back(static_cast<int>(size));
+    text = *end ? end + 1 : end;
+  }
+  return !sizes.empty();
+}
+
+} // namespace bench
@@ -0,0 +1,19 @@
+#ifndef TIGER_BENCH_ARGS_H_
+#define TIGER_BENCH_ARGS_H_
+
+#include <vector>
+
+namespace bench {
+
+/**
+ * Parse a comma-separated list of sizes, the value of --sizes
+ * @param min smallest size allowed
+ * @param sizes the sizes in the order given
+ * @return false if an entry is no number in [min, INT_MAX] or the list is
+ * empty
+ */
+bool ParseSizes(const char *text, int min, std::vector<int> &sizes);
+
+} // namespace bench
+
+#endif // TIGER_BENCH_ARGS_H_
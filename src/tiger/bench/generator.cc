@@ -0,0 +1,212 @@
+#include "tiger/bench/generator.h"
+
+#include <vector>
+
+namespace {
+
+/* splitmix64, the same on every platform unlike the <random> distributions */
+class Random {
+public:
+  explicit Random(uint64_t seed) : state_(seed) {}
+
+  uint64_t Next() {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+  /* in [0, n) */
+  int Below(int n) { return static_cast<int>(Next() % n); }
+  bool Percent(int p) { return Below(100) < p; }
+
+private:
+  uint64_t state_;
+};
+
+/**
+ * Writes the program. Names carry the nesting level, so nested functions
+ * can read and write the variables of the functions around them.
+ */
+class Generator {
+public:
+  explicit Generator(const bench::ProgramShape &shape)
+      : shape_(shape), random_(shape.seed_) {}
+
+  std::string Program();
+
+private:
+  const bench::ProgramShape &shape_;
+  Random random_;
+  std::string text_;
+  int indent_ = 0;
+  /* int variables visible in the function being written */
+  std::vector<std::string> visible_;
+  /* ones it declares itself, the only ones it assigns */
+  std::vector<std::string> own_;
+
+  int ArraySize() const { return 16 + 3 * shape_.loops_; }
+
+  void Line(const std::string &line) {
+    text_.append(indent_ * 2, ' ');
+    text_ += line;
+    text_ += '\n';
+  }
+
+  const std::string &Pick(const std::vector<std::string> &names) {
+    return names[random_.Below(static_cast<int>(names.size()))];
+  }
+
+  std::string Expression(int depth);
+  std::string Statement(int level, const std::vector<std::string> &loop_vars);
+  void Function(const std::string &name, int level, int nested,
+                const std::string &callee);
+  void LoopNest(int level);
+};
+
+std::string Generator::Program() {
+  text_ = "/* generated: functions " + std::to_string(shape_.functions_) +
+          ", depth " + std::to_string(shape_.depth_) + ", vars " +
+          std::to_string(shape_.vars_) + ", loops " +
+          std::to_string(shape_.loops_) + ", records " +
+          std::to_string(shape_.records_) + "%, arrays " +
+          std::to_string(shape_.arrays_) + "%, block " +
+          std::to_string(shape_.block_) + ", seed " +
+          std::to_string(shape_.seed_) + " */\n";
+  Line("let");
+  indent_++;
+  Line("type rec = {a: int, b: int, next: rec}");
+  Line("type arr = array of int");
+  for (int i = 0; i < shape_.functions_; i++)
+    Function("f" + std::to_string(i), 0, shape_.depth_,
+             i > 0 ? "f" + std::to_string(i - 1) : "");
+  indent_--;
+  Line("in");
+  Line("  printi(f" + std::to_string(shape_.functions_ - 1) + "(1, 2));");
+  Line("  print(\"\\n\")");
+  Line("end");
+  return std::move(text_);
+}
+
+std::string Generator::Expression(int depth) {
+  if (depth == 0 || random_.Percent(30)) {
+    if (random_.Percent(25))
+      return std::to_string(1 + random_.Below(99));
+    return Pick(visible_);
+  }
+  static const char *const kOps[] = {" + ", " - ", " * "};
+  return "(" + Expression(depth - 1) + kOps[random_.Below(3)] +
+         Expression(depth - 1) + ")";
+}
+
+std::string Generator::Statement(int level,
+                                 const std::vector<std::string> &loop_vars) {
+  std::string lv = std::to_string(level);
+  const std::string &dst = Pick(own_);
+  int kind = random_.Below(100);
+  if (kind < shape_.records_) {
+    if (random_.Percent(50))
+      return "r" + lv + " := rec{a = " + Expression(1) +
+             ", b = " + Expression(1) + ", next = r" + lv + "}";
+    return dst + " := r" + lv + ".a + r" + lv + ".b";
+  }
+  if (kind < shape_.records_ + shape_.arrays_) {
+    std::string index;
+    for (const auto &var : loop_vars)
+      index += (index.empty() ? "" : " + ") + var;
+    if (index.empty())
+      index = std::to_string(random_.Below(ArraySize()));
+    if (random_.Percent(50))
+      return "a" + lv + "[" + index + "] := " + Expression(2);
+    return dst + " := a" + lv + "[" + index + "] + " + Expression(1);
+  }
+  if (random_.Percent(15))
+    return "if " + Expression(1) + " > " + Expression(1) + " then " + dst +
+           " := " + Expression(1) + " else " + Pick(own_) +
+           " := " + Expression(1);
+  return dst + " := " + Expression(2);
+}
+
+void Generator::LoopNest(int level) {
+  std::vector<std::string> loop_vars;
+  for (int i = 0; i < shape_.loops_; i++) {
+    loop_vars.push_back("i" + std::to_string(level) + "_" +
+                        std::to_string(i));
+    Line("for " + loop_vars.back() + " := 0 to 3 do");
+    indent_++;
+  }
+  // Loop variables can be read but not assigned
+  size_t visible = visible_.size();
+  visible_.insert(visible_.end(), loop_vars.begin(), loop_vars.end());
+  Line("(" + Statement(level, loop_vars) + ";");
+  Line(" " + Pick(own_) + " := " + Expression(2) + ";");
+  Line(" " + Statement(level, loop_vars) + ");");
+  visible_.resize(visible);
+  indent_ -= shape_.loops_;
+}
+
+void Generator::Function(const std::string &name, int level, int nested,
+                         const std::string &callee) {
+  std::string lv = std::to_string(level);
+  std::string p0 = "p" + lv + "_0", p1 = "p" + lv + "_1";
+  Line("function " + name + "(" + p0 + ": int, " + p1 + ": int): int =");
+  indent_++;
+  Line("let");
+  indent_++;
+
+  size_t visible = visible_.size();
+  std::vector<std::string> outer_own = std::move(own_);
+  own_.clear();
+  visible_.push_back(p0);
+  visible_.push_back(p1);
+  for (int i = 0; i < shape_.vars_ || i == 0; i++) {
+    std::string var = "v" + lv + "_" + std::to_string(i);
+    Line("var " + var + " := " + Expression(1));
+    visible_.push_back(var);
+    own_.push_back(var);
+  }
+  Line("var r" + lv + " := rec{a = " + p0 + ", b = " + p1 + ", next = nil}");
+  Line("var a" + lv + " := arr [" + std::to_string(ArraySize()) + "] of " +
+       p0);
+  std::string inner;
+  if (nested > 0) {
+    inner = name + "_" + std::to_string(level + 1);
+    Function(inner, level + 1, nested - 1, "");
+  }
+  indent_--;
+  Line("in");
+  indent_++;
+
+  if (!callee.empty())
+    Line(Pick(own_) + " := " + callee + "(" + Expression(1) + ", " +
+         Expression(1) + ");");
+  if (!inner.empty())
+    Line(Pick(own_) + " := " + inner + "(" + Expression(1) + ", " +
+         Expression(1) + ");");
+  for (int i = 0; i < shape_.block_; i++) {
+    if (i == shape_.block_ / 2 && shape_.loops_ > 0)
+      LoopNest(level);
+    Line(Statement(level, {}) + ";");
+  }
+  if (shape_.block_ == 0 && shape_.loops_ > 0)
+    LoopNest(level);
+  std::string result = "r" + lv + ".a";
+  for (const auto &var : own_)
+    result += " + " + var;
+  Line(result);
+
+  indent_--;
+  Line("end");
+  indent_--;
+  visible_.resize(visible);
+  own_ = std::move(outer_own);
+}
+
+} // namespace
+
+namespace bench {
+
+std::string GenerateProgram(const ProgramShape &shape) {
+  return Generator(shape).Program();
+}
+
+} // namespace bench
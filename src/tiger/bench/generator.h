@@ -0,0 +1,32 @@
+#ifndef TIGER_BENCH_GENERATOR_H_
+#define TIGER_BENCH_GENERATOR_H_
+
+#include <cstdint>
+#include <string>
+
+namespace bench {
+
+/**
+ * Shape of a generated program
+ */
+struct ProgramShape {
+  int functions_ = 16;   // top-level functions
+  int depth_ = 2;        // functions nested in each of them
+  int vars_ = 6;         // variables declared by each let
+  int loops_ = 2;        // depth of the loop nest in every function
+  int records_ = 20;     // percent of statements working on records
+  int arrays_ = 20;      // percent of statements working on arrays
+  int block_ = 24;       // straight-line statements in every function
+  uint64_t seed_ = 1;
+};
+
+/**
+ * Generate a well-typed Tiger program of the given shape. The same shape
+ * always gives the same text. The program terminates and prints one
+ * number, so it can be run as well as compiled.
+ */
+std::string GenerateProgram(const ProgramShape &shape);
+
+} // namespace bench
+
+#endif // TIGER_BENCH_GENERATOR_H_
@@ -0,0 +1,263 @@
+#include "tiger/bench/json.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+/* recursive descent over the text, positions are byte offsets */
+class JsonParser {
+public:
+  explicit JsonParser(std::string_view text) : text_(text) {}
+
+  bool Document(bench::JsonValue &value) {
+    if (!Value(value, 0))
+      return false;
+    SkipSpace();
+    return pos_ == text_.size();
+  }
+
+private:
+  /* deeper documents are rejected rather than overflowing the stack */
+  static constexpr int kMaxDepth = 256;
+
+  std::string_view text_;
+  size_t pos_ = 0;
+
+  void SkipSpace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' ||
+            text_[pos_] == '\n' || text_[pos_] == '\r'))
+      pos_++;
+  }
+
+  bool Consume(char c) {
+    SkipSpace();
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      pos_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool Literal(std::string_view word) {
+    if (text_.substr(pos_, word.size()) != word)
+      return false;
+    pos_ += word.size();
+    return true;
+  }
+
+  bool Value(bench::JsonValue &value, int depth);
+  bool String(std::string &str);
+  bool Number(double &number);
+};
+
+bool JsonParser::Value(bench::JsonValue &value, int depth) {
+  if (depth > kMaxDepth)
+    return false;
+  SkipSpace();
+  if (pos_ == text_.size())
+    return false;
+  switch (text_[pos_]) {
+  case '{':
+    pos_++;
+    value.kind_ = bench::JsonValue::OBJECT;
+    if (Consume('}'))
+      return true;
+    do {
+      std::pair<std::string, bench::JsonValue> member;
+      SkipSpace();
+      if (!String(member.first) || !Consume(':') ||
+          !Value(member.second, depth + 1))
+        return false;
+      value.object_.push_back(std::move(member));
+    } while (Consume(','));
+    return Consume('}');
+  case '[':
+    pos_++;
+    value.kind_ = bench::JsonValue::ARRAY;
+    if (Consume(']'))
+      return true;
+    do {
+      value.array_.emplace_back();
+      if (!Value(value.array_.back(), depth + 1))
+        return false;
+    } while (Consume(','));
+    return Consume(']');
+  case '"':
+    value.kind_ = bench::JsonValue::STRING;
+    return String(value.string_);
+  case 't':
+    value.kind_ = bench::JsonValue::BOOL;
+    value.bool_ = true;
+    return Literal("true");
+  case 'f':
+    value.kind_ = bench::JsonValue::BOOL;
+    return Literal("false");
+  case 'n':
+    return Literal("null");
+  default:
+    value.kind_ = bench::JsonValue::NUMBER;
+    return Number(value.number_);
+  }
+}
+
+bool JsonParser::String(std::string &str) {
+  if (pos_ == text_.size() || text_[pos_] != '"')
+    return false;
+  pos_++;
+  while (pos_ < text_.size() && text_[pos_] != '"') {
+    char c = text_[pos_++];
+    if (c != '\\') {
+      str += c;
+      continue;
+    }
+    if (pos_ == text_.size())
+      return false;
+    switch (char escape = text_[pos_++]) {
+    case 'b': str += '\b'; break;
+    case 'f': str += '\f'; break;
+    case 'n': str += '\n'; break;
+    case 'r': str += '\r'; break;
+    case 't': str += '\t'; break;
+    case 'u': {
+      if (pos_ + 4 > text_.size())
+        return false;
+      std::string hex(text_.substr(pos_, 4));
+      char *end;
+      unsigned long code = strtoul(hex.data(), &end, 16);
+      if (end != hex.data() + 4)
+        return false;
+      pos_ += 4;
+      // UTF-8, surrogate pairs are kept as they are
+      if (code < 0x80) {
+        str += static_cast<char>(code);
+      } else if (code < 0x800) {
+        str += static_cast<char>(0xc0 | code >> 6);
+        str += static_cast<char>(0x80 | (code & 0x3f));
+      } else {
+        str += static_cast<char>(0xe0 | code >> 12);
+        str += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+        str += static_cast<char>(0x80 | (code & 0x3f));
+      }
+      break;
+    }
+    default:
+      if (escape != '"' && escape != '\\' && escape != '/')
+        return false;
+      str += escape;
+    }
+  }
+  return pos_++ < text_.size();
+}
+
+bool JsonParser::Number(double &number) {
+  size_t start = pos_;
+  while (pos_ < text_.size() && text_[pos_] != '\0' &&
+         strchr("+-.0123456789eE", text_[pos_]))
+    pos_++;
+  std::string token(text_.substr(start, pos_ - start));
+  char *end;
+  number = strtod(token.data(), &end);
+  return !token.empty() && end == token.data() + token.size();
+}
+
+} // namespace
+
+namespace bench {
+
+const JsonValue *JsonValue::Find(std::string_view key) const {
+  for (const auto &[name, value] : object_) {
+    if (name == key)
+      return &value;
+  }
+  return nullptr;
+}
+
+bool ParseJson(std::string_view text, JsonValue &value) {
+  value = JsonValue();
+  return JsonParser(text).Document(value);
+}
+
+JsonWriter &JsonWriter::Key(std::string_view key) {
+  String(key);
+  fputs(": ", out_);
+  after_key_ = true;
+  return *this;
+}
+
+void JsonWriter::String(std::string_view value) {
+  Separate();
+  fputc('"', out_);
+  for (char c : value) {
+    if (c == '"' || c == '\\')
+      fprintf(out_, "\\%c", c);
+    else if (static_cast<unsigned char>(c) < 0x20)
+      fprintf(out_, "\\u%04x", c);
+    else
+      fputc(c, out_);
+  }
+  fputc('"', out_);
+}
+
+void JsonWriter::Int(int64_t value) {
+  Separate();
+  fprintf(out_, "%lld", static_cast<long long>(value));
+}
+
+void JsonWriter::Double(double value) {
+  Separate();
+  // JSON has no infinities or NaNs
+  if (std::isfinite(value))
+    fprintf(out_, "%.6g", value);
+  else
+    fputs("null", out_);
+}
+
+void JsonWriter::Bool(bool value) {
+  Separate();
+  fputs(value ? "true" : "false", out_);
+}
+
+void JsonWriter::Null() {
+  Separate();
+  fputs("null", out_);
+}
+
+void JsonWriter::Open(char bracket) {
+  Separate();
+  fputc(bracket, out_);
+  empty_.push_back(true);
+}
+
+void JsonWriter::Close(char bracket) {
+  bool empty = empty_.back();
+  empty_.pop_back();
+  if (!empty) {
+    fputc('\n', out_);
+    Indent();
+  }
+  fputc(bracket, out_);
+  if (empty_.empty())
+    fputc('\n', out_);
+}
+
+void JsonWriter::Separate() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (empty_.empty())
+    return;
+  fputs(empty_.back() ? "\n" : ",\n", out_);
+  empty_.back() = false;
+  Indent();
+}
+
+void JsonWriter::Indent() {
+  for (size_t i = 0; i < empty_.size(); i++)
+    fputs("  ", out_);
+}
+
+} // namespace bench
@@ -0,0 +1,78 @@
+#ifndef TIGER_BENCH_JSON_H_
+#define TIGER_BENCH_JSON_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+/**
+ * Streaming writer of the JSON reports of the benchmarks. Commas and
+ * indentation are taken care of, values must follow a Key() in objects.
+ */
+class JsonWriter {
+public:
+  explicit JsonWriter(FILE *out) : out_(out) {}
+  JsonWriter(const JsonWriter &writer) = delete;
+  JsonWriter &operator=(const JsonWriter &writer) = delete;
+
+  void BeginObject() { Open('{'); }
+  void EndObject() { Close('}'); }
+  void BeginArray() { Open('['); }
+  void EndArray() { Close(']'); }
+
+  JsonWriter &Key(std::string_view key);
+
+  void String(std::string_view value);
+  void Int(int64_t value);
+  void Double(double value);
+  void Bool(bool value);
+  void Null();
+
+private:
+  FILE *out_;
+  /* whether the container at each level is still empty */
+  std::vector<bool> empty_;
+  bool after_key_ = false;
+
+  void Open(char bracket);
+  void Close(char bracket);
+  /* comma and new line before a value */
+  void Separate();
+  void Indent();
+};
+
+/**
+ * Parsed JSON document, as read back by the comparisons of the benchmarks
+ */
+struct JsonValue {
+  enum Kind { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+  Kind kind_ = NUL;
+  bool bool_ = false;
+  double number_ = 0;
+  std::string string_;
+  std::vector<JsonValue> array_;
+  /* members in the order of the document */
+  std::vector<std::pair<std::string, JsonValue>> object_;
+
+  /* member of an object, nullptr if there is none */
+  const JsonValue *Find(std::string_view key) const;
+  bool IsNumber() const { return kind_ == NUMBER; }
+};
+
+/**
+ * Parse a JSON document
+ * @param text the whole document
+ * @param value where the document is stored
+ * @return false on a syntax error
+ */
+bool ParseJson(std::string_view text, JsonValue &value);
+
+} // namespace bench
+
+#endif // TIGER_BENCH_JSON_H_
@@ -0,0 +1,134 @@
+#include "tiger/bench/process.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+/* counter of the user mode events of `pid`, started when it calls exec */
+int OpenCounter(pid_t pid, uint64_t config) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.enable_on_exec = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, pid, -1, -1,
+                                  PERF_FLAG_FD_CLOEXEC));
+}
+
+/* value of a counter, scaled up if it had to share the hardware */
+std::optional<uint64_t> ReadCounter(int fd) {
+  if (fd < 0)
+    return std::nullopt;
+  uint64_t values[3]; // count, time enabled, time running
+  ssize_t size = read(fd, values, sizeof(values));
+  close(fd);
+  if (size != sizeof(values) || values[2] == 0)
+    return std::nullopt;
+  if (values[2] < values[1])
+    return static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] /
+                                 values[2]);
+  return values[0];
+}
+
+uint64_t Nanoseconds(const timeval &time) {
+  return time.tv_sec * 1000000000ULL + time.tv_usec * 1000ULL;
+}
+
+/* point fd at a file, in the child between fork and exec */
+bool Redirect(const char *path, int flags, int fd) {
+  int file = open(path ? path : "/dev/null", flags, 0644);
+  if (file < 0)
+    return false;
+  if (file != fd) {
+    if (dup2(file, fd) < 0)
+      return false;
+    close(file);
+  }
+  return true;
+}
+
+} // namespace
+
+namespace bench {
+
+bool RunProgram(const std::vector<std::string> &argv, const char *input,
+                const char *output, RunResult &result) {
+  result = RunResult();
+  std::vector<char *> args;
+  for (const auto &arg : argv)
+    args.push_back(const_cast<char *>(arg.data()));
+  args.push_back(nullptr);
+
+  // The child waits on `start` until its counters are open, and reports a
+  // failed exec through `failure`; both close on exec
+  int start[2], failure[2];
+  if (pipe2(start, O_CLOEXEC) != 0)
+    return false;
+  if (pipe2(failure, O_CLOEXEC) != 0) {
+    close(start[0]);
+    close(start[1]);
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    char go;
+    close(start[1]);
+    close(failure[0]);
+    int error = 0;
+    if (read(start[0], &go, 1) < 0 || !Redirect(input, O_RDONLY, 0) ||
+        !Redirect(output, O_WRONLY | O_CREAT | O_TRUNC, 1))
+      error = errno;
+    else
+      execvp(args[0], args.data());
+    error = error ? error : errno;
+    (void)!write(failure[1], &error, sizeof(error));
+    _exit(127);
+  }
+  close(start[0]);
+  close(failure[1]);
+  if (pid < 0) {
+    close(start[1]);
+    close(failure[0]);
+    return false;
+  }
+
+  int instructions = OpenCounter(pid, PERF_COUNT_HW_INSTRUCTIONS);
+  int cycles = OpenCounter(pid, PERF_COUNT_HW_CPU_CYCLES);
+  auto begin = std::chrono::steady_clock::now();
+  close(start[1]);
+  int error = 0;
+  bool started = read(failure[0], &error, sizeof(error)) <= 0;
+  close(failure[0]);
+
+  rusage usage;
+  while (wait4(pid, &result.status_, 0, &usage) < 0 && errno == EINTR)
+    ;
+  result.wall_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - begin)
+                        .count();
+  result.user_ns_ = Nanoseconds(usage.ru_utime);
+  result.sys_ns_ = Nanoseconds(usage.ru_stime);
+  result.max_rss_kb_ = usage.ru_maxrss;
+  result.instructions_ = ReadCounter(instructions);
+  result.cycles_ = ReadCounter(cycles);
+  if (!started)
+    errno = error;
+  return started;
+}
+
+} // namespace bench
@@ -0,0 +1,40 @@
+#ifndef TIGER_BENCH_PROCESS_H_
+#define TIGER_BENCH_PROCESS_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/**
+ * Measurements of one run of a program
+ */
+struct RunResult {
+  int status_ = 0;        // as returned by waitpid
+  uint64_t wall_ns_ = 0;  // from exec to exit
+  uint64_t user_ns_ = 0;
+  uint64_t sys_ns_ = 0;
+  long max_rss_kb_ = 0;
+  /* hardware counters of user mode, unset where perf events are unavailable,
+   * e.g. in most virtual machines or with a strict perf_event_paranoid */
+  std::optional<uint64_t> instructions_;
+  std::optional<uint64_t> cycles_;
+};
+
+/**
+ * Run a program to completion and measure it
+ * @param argv program, looked up in PATH, and its arguments
+ * @param input file read as standard input, nullptr for /dev/null
+ * @param output file receiving standard output, nullptr for /dev/null;
+ * standard error is inherited
+ * @param result measurements of the run
+ * @return false if the program cannot be started
+ */
+bool RunProgram(const std::vector<std::string> &argv, const char *input,
+                const char *output, RunResult &result);
+
+} // namespace bench
+
+#endif // TIGER_BENCH_PROCESS_H_
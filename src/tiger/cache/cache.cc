@@ -0,0 +1,387 @@
+#include "tiger/cache/cache.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/* bump when the layout of keys or entries changes */
+constexpr int kFormatVersion = 1;
+constexpr char kMagic[] = "tiger-asm-cache";
+
+const char *const kBinOpNames[] = {"+", "-", "*", "/", "&", "|",
+                                   "<<", ">>", "a>>", "^"};
+const char *const kRelOpNames[] = {"==", "!=", "<", ">", "<=",
+                                   ">=", "u<", "u<=", "u>", "u>="};
+
+/**
+ * Write an IR body as text, naming temps by rank and anonymous labels by
+ * first occurrence
+ */
+class KeyWriter {
+public:
+  KeyWriter(frame::RegManager *reg_manager,
+            std::vector<temp::Label *> &body_labels)
+      : reg_manager_(reg_manager), body_labels_(body_labels) {}
+
+  std::string Write(tree::Stm *body) {
+    /* the first walk only collects the temps */
+    collecting_ = true;
+    Stm(body);
+    int rank = 0;
+    for (auto &[num, index] : temps_)
+      index = rank++;
+    collecting_ = false;
+    out_.clear();
+    Stm(body);
+    return std::move(out_);
+  }
+
+private:
+  frame::RegManager *reg_manager_;
+  std::vector<temp::Label *> &body_labels_;
+  std::map<int, int> temps_;
+  std::map<temp::Label *, int> labels_;
+  std::string out_;
+  bool collecting_ = false;
+
+  void Put(std::string_view s) {
+    if (!collecting_)
+      out_.append(s).push_back(' ');
+  }
+
+  void Temp(temp::Temp *t) {
+    std::string *reg = reg_manager_->temp_map_->Look(t);
+    if (reg) {
+      Put(*reg);
+    } else if (collecting_) {
+      temps_.emplace(t->Int(), 0);
+    } else {
+      Put("t" + std::to_string(temps_[t->Int()]));
+    }
+  }
+
+  void Label(temp::Label *label) {
+    if (collecting_)
+      return;
+    std::string_view name = label->Name();
+    if (!temp::LabelFactory::IsAnonymous(name)) {
+      Put(name);
+      return;
+    }
+    auto [it, inserted] =
+        labels_.emplace(label, static_cast<int>(body_labels_.size()));
+    if (inserted)
+      body_labels_.push_back(label);
+    Put("L" + std::to_string(it->second));
+  }
+
+  void Stm(tree::Stm *stm) {
+    if (auto seq = dynamic_cast<tree::SeqStm *>(stm)) {
+      Put("SEQ");
+      Stm(seq->left_);
+      Stm(seq->right_);
+    } else if (auto label = dynamic_cast<tree::LabelStm *>(stm)) {
+      Put("LABEL");
+      Label(label->label_);
+    } else if (auto jump = dynamic_cast<tree::JumpStm *>(stm)) {
+      Put("JUMP");
+      Exp(jump->exp_);
+      for (auto target : *jump->jumps_)
+        Label(target);
+      Put(";");
+    } else if (auto cjump = dynamic_cast<tree::CjumpStm *>(stm)) {
+      Put("CJUMP");
+      Put(kRelOpNames[cjump->op_]);
+      Exp(cjump->left_);
+      Exp(cjump->right_);
+      Label(cjump->true_label_);
+      Label(cjump->false_label_);
+    } else if (auto move = dynamic_cast<tree::MoveStm *>(stm)) {
+      Put("MOVE");
+      Exp(move->dst_);
+      Exp(move->src_);
+    } else {
+      Put("EXP");
+      Exp(static_cast<tree::ExpStm *>(stm)->exp_);
+    }
+  }
+
+  void Exp(tree::Exp *exp) {
+    if (auto binop = dynamic_cast<tree::BinopExp *>(exp)) {
+      Put(kBinOpNames[binop->op_]);
+      Exp(binop->left_);
+      Exp(binop->right_);
+    } else if (auto mem = dynamic_cast<tree::MemExp *>(exp)) {
+      Put("MEM");
+      Exp(mem->exp_);
+    } else if (auto temp = dynamic_cast<tree::TempExp *>(exp)) {
+      Temp(temp->temp_);
+    } else if (auto eseq = dynamic_cast<tree::EseqExp *>(exp)) {
+      Put("ESEQ");
+      Stm(eseq->stm_);
+      Exp(eseq->exp_);
+    } else if (auto name = dynamic_cast<tree::NameExp *>(exp)) {
+      Put("NAME");
+      Label(name->name_);
+    } else if (auto constant = dynamic_cast<tree::ConstExp *>(exp)) {
+      Put("#" + std::to_string(constant->consti_));
+    } else {
+      auto call = static_cast<tree::CallExp *>(exp);
+      Put("CALL");
+      Exp(call->fun_);
+      for (auto arg : call->args_->GetList())
+        Exp(arg);
+      Put(";");
+    }
+  }
+};
+
+/* FNV-1a with the final mix of splitmix64 */
+uint64_t Hash(std::string_view s, uint64_t seed) {
+  uint64_t h = seed;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+bool IsIdentChar(char c) {
+  return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+/* number of an anonymous label, the part after its scope if any */
+int LabelNumber(std::string_view name) {
+  size_t start = name.rfind('_');
+  start = start == std::string_view::npos ? 1 : start + 1;
+  return atoi(std::string(name.substr(start)).data());
+}
+
+} // namespace
+
+namespace cache {
+
+FunctionKey::FunctionKey(frame::Frame *frame, tree::Stm *body,
+                         frame::RegManager *reg_manager,
+                         const ra::Options &ra_options) {
+  std::string text = std::string(kMagic) + " " +
+                     std::to_string(kFormatVersion) + " " TIGER_VERSION "\n";
+  text += frame->Name()->Name();
+  text += "\n";
+  text += frame->Layout() + "\n";
+  text += "ra " + std::to_string(static_cast<int>(ra_options.allocator)) +
+          " " + std::to_string(ra_options.max_graph_nodes) + "\n";
+  text += KeyWriter(reg_manager, body_labels_).Write(body);
+
+  char buf[33];
+  snprintf(buf, sizeof(buf), "%016llx%016llx",
+           static_cast<unsigned long long>(Hash(text, 0xcbf29ce484222325ULL)),
+           static_cast<unsigned long long>(Hash(text, 0x84222325cbf29ce4ULL)));
+  digest_ = buf;
+}
+
+AssemCache::AssemCache(std::string dir, uint64_t capacity)
+    : dir_(std::move(dir)), capacity_(capacity) {
+  std::error_code ec;
+  fs::create_directories(dir_, ec);
+
+  std::vector<std::pair<fs::file_time_type, Entry>> found;
+  for (auto &file : fs::directory_iterator(dir_, ec)) {
+    if (!file.is_regular_file(ec) || file.path().extension() != ".s")
+      continue;
+    std::string digest = file.path().stem().string();
+    if (digest.size() != 32)
+      continue;
+    found.push_back({file.last_write_time(ec), {digest, file.file_size(ec)}});
+  }
+  std::sort(found.begin(), found.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+  for (auto &[time, entry] : found)
+    Insert(entry.digest_, entry.size_);
+  Evict();
+}
+
+bool AssemCache::Lookup(const FunctionKey &key, std::string &text) {
+  std::string path = PathOf(key.Digest());
+  FILE *in = fopen(path.data(), "r");
+  char magic[64], labels_line[64];
+  int version = 0, label_count = -1;
+  /* read the header line by line, the text may start with blanks */
+  if (!in || !fgets(magic, sizeof(magic), in) ||
+      !fgets(labels_line, sizeof(labels_line), in) ||
+      sscanf(magic, "tiger-asm-cache %d", &version) != 1 ||
+      sscanf(labels_line, "labels %d", &label_count) != 1 ||
+      version != kFormatVersion || label_count < 0) {
+    if (in)
+      fclose(in);
+    misses_++;
+    return false;
+  }
+  std::string stored;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    stored.append(buf, n);
+  fclose(in);
+
+  /* {B<k>} is the k-th body label, {N<k>} the k-th one of the backend; the
+   * whole entry is checked before any label is made */
+  const std::vector<temp::Label *> &body_labels = key.BodyLabels();
+  struct LabelRef {
+    size_t begin_, end_;
+    bool body_;
+    size_t k_;
+  };
+  std::vector<LabelRef> refs;
+  for (size_t i = stored.find('{'); i != std::string::npos;
+       i = stored.find('{', i)) {
+    size_t end = stored.find('}', i);
+    bool ok = end != std::string::npos && end > i + 2 &&
+              (stored[i + 1] == 'B' || stored[i + 1] == 'N');
+    size_t k = 0;
+    if (ok) {
+      const char *last = stored.data() + end;
+      auto [ptr, error] = std::from_chars(stored.data() + i + 2, last, k);
+      size_t count = stored[i + 1] == 'B' ? body_labels.size()
+                                          : static_cast<size_t>(label_count);
+      ok = error == std::errc() && ptr == last && k < count;
+    }
+    if (!ok) {
+      misses_++;
+      return false;
+    }
+    refs.push_back({i, end + 1, stored[i + 1] == 'B', k});
+    i = end + 1;
+  }
+
+  std::vector<temp::Label *> made;
+  for (int i = 0; i < label_count; i++)
+    made.push_back(temp::LabelFactory::NewLabel());
+  text.clear();
+  size_t pos = 0;
+  for (const auto &ref : refs) {
+    text.append(stored, pos, ref.begin_ - pos);
+    text += (ref.body_ ? body_labels : made)[ref.k_]->Name();
+    pos = ref.end_;
+  }
+  text.append(stored, pos, std::string::npos);
+
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  Touch(key.Digest());
+  hits_++;
+  return true;
+}
+
+void AssemCache::Store(const FunctionKey &key, std::string_view text,
+                       int first_label, int label_count) {
+  /* braces mark labels in the stored text */
+  if (text.find('{') != std::string_view::npos)
+    return;
+
+  std::map<std::string, int> body_labels;
+  for (size_t i = 0; i < key.BodyLabels().size(); i++)
+    body_labels.emplace(key.BodyLabels()[i]->Name(), static_cast<int>(i));
+
+  std::string stored = std::string(kMagic) + " " +
+                       std::to_string(kFormatVersion) + "\nlabels " +
+                       std::to_string(label_count) + "\n";
+  for (size_t i = 0; i < text.size();) {
+    if (!IsIdentChar(text[i]) || isdigit(static_cast<unsigned char>(text[i]))) {
+      stored.push_back(text[i++]);
+      continue;
+    }
+    size_t end = i;
+    while (end < text.size() && IsIdentChar(text[end]))
+      end++;
+    std::string_view token = text.substr(i, end - i);
+    i = end;
+    if (!temp::LabelFactory::IsAnonymous(token)) {
+      stored.append(token);
+      continue;
+    }
+    auto body_label = body_labels.find(std::string(token));
+    if (body_label != body_labels.end()) {
+      stored += "{B" + std::to_string(body_label->second) + "}";
+      continue;
+    }
+    int k = LabelNumber(token) - first_label;
+    if (k < 0 || k >= label_count)
+      return; // refers to a label of another function, do not cache
+    stored += "{N" + std::to_string(k) + "}";
+  }
+
+  /* write to a private file first, so readers never see half an entry */
+  std::string path = PathOf(key.Digest());
+  std::string tmp_path =
+      path + ".tmp." + std::to_string(getpid()) + "." +
+      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  FILE *out = fopen(tmp_path.data(), "w");
+  if (!out)
+    return;
+  bool written = fwrite(stored.data(), 1, stored.size(), out) == stored.size();
+  written = fclose(out) == 0 && written;
+  if (!written || rename(tmp_path.data(), path.data()) != 0) {
+    unlink(tmp_path.data());
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Insert(key.Digest(), stored.size());
+  Evict();
+}
+
+void AssemCache::Report(FILE *out) const {
+  fprintf(out, "assembly cache: %llu hits, %llu misses, %llu evictions\n",
+          static_cast<unsigned long long>(hits_.load()),
+          static_cast<unsigned long long>(misses_.load()),
+          static_cast<unsigned long long>(evictions_.load()));
+}
+
+std::string AssemCache::PathOf(std::string_view digest) const {
+  return dir_ + "/" + std::string(digest) + ".s";
+}
+
+void AssemCache::Touch(const std::string &digest) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(digest);
+  if (it != entries_.end())
+    lru_.splice(lru_.end(), lru_, it->second);
+}
+
+void AssemCache::Insert(const std::string &digest, uint64_t size) {
+  auto it = entries_.find(digest);
+  if (it != entries_.end()) {
+    size_ -= it->second->size_;
+    lru_.erase(it->second);
+  }
+  lru_.push_back({digest, size});
+  entries_[digest] = std::prev(lru_.end());
+  size_ += size;
+}
+
+void AssemCache::Evict() {
+  while (size_ > capacity_ && !lru_.empty()) {
+    Entry &victim = lru_.front();
+    unlink(PathOf(victim.digest_).data());
+    size_ -= victim.size_;
+    entries_.erase(victim.digest_);
+    lru_.pop_front();
+    evictions_++;
+  }
+}
+
+} // namespace cache
@@ -0,0 +1,119 @@
+#ifndef TIGER_CACHE_CACHE_H_
+#define TIGER_CACHE_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tiger/frame/frame.h"
+#include "tiger/frame/temp.h"
+#include "tiger/regalloc/options.h"
+#include "tiger/translate/tree.h"
+
+namespace cache {
+
+/**
+ * What the assembly of one function depends on: its IR body, the layout of
+ * its frame, the register allocator and the compiler version. Temps and
+ * anonymous labels are numbered canonically, so the same function gets the
+ * same key in any program and at any position.
+ */
+class FunctionKey {
+public:
+  /**
+   * Must be made before the body is canonicalized
+   */
+  FunctionKey(frame::Frame *frame, tree::Stm *body,
+              frame::RegManager *reg_manager, const ra::Options &ra_options);
+
+  /* 32 hex digits naming the cache entry */
+  [[nodiscard]] const std::string &Digest() const { return digest_; }
+
+  /* anonymous labels of the body, in canonical order */
+  [[nodiscard]] const std::vector<temp::Label *> &BodyLabels() const {
+    return body_labels_;
+  }
+
+private:
+  std::string digest_;
+  std::vector<temp::Label *> body_labels_;
+};
+
+/**
+ * Content-addressed on-disk cache of function assembly, one file per
+ * function under the cache directory. The least recently used entries are
+ * removed once the directory grows over its size cap. It may be shared by
+ * every thread of a process.
+ */
+class AssemCache {
+public:
+  /**
+   * Index the entries already in the directory, creating it if needed
+   * @param dir cache directory
+   * @param capacity size cap of the entries in bytes
+   */
+  AssemCache(std::string dir, uint64_t capacity);
+  AssemCache(const AssemCache &cache) = delete;
+  AssemCache &operator=(const AssemCache &cache) = delete;
+
+  /**
+   * Find the assembly of a function. Labels the backend made when the entry
+   * was stored are made again by the current label factory.
+   * @param key key of the function
+   * @param text where the assembly is written on a hit
+   * @return whether the entry is found
+   */
+  bool Lookup(const FunctionKey &key, std::string &text);
+
+  /**
+   * Store the assembly of a function
+   * @param key key of the function
+   * @param text assembly of the function
+   * @param first_label number of the first label made by the backend for it
+   * @param label_count number of labels made by the backend for it
+   */
+  void Store(const FunctionKey &key, std::string_view text, int first_label,
+             int label_count);
+
+  [[nodiscard]] uint64_t Hits() const { return hits_; }
+  [[nodiscard]] uint64_t Misses() const { return misses_; }
+  [[nodiscard]] uint64_t Evictions() const { return evictions_; }
+
+  /**
+   * Print the counters of the cache
+   */
+  void Report(FILE *out) const;
+
+private:
+  struct Entry {
+    std::string digest_;
+    uint64_t size_;
+  };
+
+  std::string dir_;
+  uint64_t capacity_;
+  uint64_t size_ = 0;
+  /* least recently used first */
+  std::list<Entry> lru_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> entries_;
+  std::mutex mutex_;
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> evictions_{0};
+
+  [[nodiscard]] std::string PathOf(std::string_view digest) const;
+  void Touch(const std::string &digest);
+  void Insert(const std::string &digest, uint64_t size);
+  void Evict();
+};
+
+} // namespace cache
+
+#endif // TIGER_CACHE_CACHE_H_
@@ -54,8 +54,8 @@ struct ExpRefList {
     refs.push_back(exp1);
     refs.push_back(exp2);
   }
-  ExpRefList(tree::Exp *&head, std::list<tree::Exp *>::iterator begin,
-             std::list<tree::Exp *>::iterator end)
+  ExpRefList(tree::Exp *&head, std::pmr::list<tree::Exp *>::iterator begin,
+             std::pmr::list<tree::Exp *>::iterator end)
       : refs(begin, end) {
     refs.push_front(head);
   }
@@ -102,7 +102,7 @@ ExpRefList *GetCallRlist(tree::Exp *exp) {
 
 namespace canon {
 
-void Canon::Trace(std::list<tree::Stm *> &stms) {
+void Canon::Trace(std::pmr::list<tree::Stm *> &stms) {
   tree::Stm *last = stms.back();
 
   auto lab = dynamic_cast<tree::LabelStm *>(stms.front());
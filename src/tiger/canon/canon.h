@@ -22,19 +22,19 @@ class ProcFrag;
 
 namespace canon {
 
-class StmListList {
+class StmListList : public util::ProcObject {
   friend class Canon;
 
 public:
   StmListList() = default;
 
   void Append(tree::StmList *stmlist) { stmlist_list_.push_back(stmlist); }
-  [[nodiscard]] const std::list<tree::StmList *> &GetList() const {
+  [[nodiscard]] const std::pmr::list<tree::StmList *> &GetList() const {
     return stmlist_list_;
   }
 
 private:
-  std::list<tree::StmList *> stmlist_list_;
+  std::pmr::list<tree::StmList *> stmlist_list_{Resource()};
 };
 
 class Block {
@@ -149,7 +149,7 @@ private:
    */
   tree::StmList *GetNext();
 
-  void Trace(std::list<tree::Stm *> &stms);
+  void Trace(std::pmr::list<tree::Stm *> &stms);
 };
 
 } // namespace canon
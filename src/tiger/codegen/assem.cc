@@ -5,102 +5,160 @@
 namespace temp {
 
 Temp *TempList::NthTemp(int i) const {
-  for (auto it : temp_list_)
-    if (i-- == 0)
-      return it;
-  assert(0);
+  assert(i >= 0 && static_cast<size_t>(i) < temp_list_.size());
+  return temp_list_[i];
 }
 } // namespace temp
 
 namespace assem {
+
+namespace {
+
+/* mnemonics and flags of the opcodes, in the order of Opcode */
+struct OpcodeInfo {
+  std::string_view name_;
+  bool jump_;
+  bool direct_jump_;
+  bool call_;
+};
+
+constexpr OpcodeInfo kOpcodes[] = {
+    {"movq", false, false, false},  {"leaq", false, false, false},
+    {"addq", false, false, false},  {"subq", false, false, false},
+    {"imulq", false, false, false}, {"idivq", false, false, false},
+    {"cqto", false, false, false},  {"cmpq", false, false, false},
+    {"jmp", true, true, false},     {"je", true, false, false},
+    {"jne", true, false, false},    {"jl", true, false, false},
+    {"jle", true, false, false},    {"jg", true, false, false},
+    {"jge", true, false, false},    {"callq", false, false, true},
+    {"", false, false, false},
+};
+static_assert(sizeof(kOpcodes) / sizeof(kOpcodes[0]) ==
+                  static_cast<size_t>(Opcode::OPCODE_COUNT),
+              "an entry for every opcode");
+
+const OpcodeInfo &Info(Opcode op) { return kOpcodes[static_cast<int>(op)]; }
+
+void PutOperand(output::AsmWriter &out, const Operand &operand,
+                temp::TempList *dst, temp::TempList *src, Targets *jumps,
+                temp::Map *m) {
+  switch (operand.kind_) {
+  case Operand::SRC:
+    out.Put(*m->Look(src->NthTemp(operand.index_)));
+    break;
+  case Operand::DST:
+    out.Put(*m->Look(dst->NthTemp(operand.index_)));
+    break;
+  case Operand::IMM:
+    out.Put('$');
+    out.PutInt(operand.disp_);
+    break;
+  case Operand::MEM:
+    if (operand.disp_ != 0)
+      out.PutInt(operand.disp_);
+    out.Put('(');
+    out.Put(*m->Look(src->NthTemp(operand.index_)));
+    out.Put(')');
+    break;
+  case Operand::FRAME:
+    /* the frame size is only known once the function is allocated */
+    if (operand.disp_ != 0)
+      out.Put('(');
+    out.Put(operand.label_->Name());
+    out.Put("_framesize");
+    if (operand.disp_ != 0) {
+      out.Put(operand.disp_ > 0 ? " + " : " - ");
+      out.PutInt(operand.disp_ > 0 ? operand.disp_
+                                   : -static_cast<int64_t>(operand.disp_));
+      out.Put(')');
+    }
+    out.Put('(');
+    out.Put(*m->Look(src->NthTemp(operand.index_)));
+    out.Put(')');
+    break;
+  case Operand::RIP:
+    out.Put(operand.label_->Name());
+    out.Put("(%rip)");
+    break;
+  case Operand::LABEL:
+    out.Put(operand.label_->Name());
+    break;
+  case Operand::JUMP:
+    assert(jumps);
+    out.Put(jumps->labels_->at(operand.index_)->Name());
+    break;
+  case Operand::NONE:
+    assert(0);
+  }
+}
+
 /**
- * First param is string created by this function by reading 'assem' string
- * and replacing `d `s and `j stuff.
- * Last param is function to use to determine what to do with each temp.
- * @param assem assembly string
- * @param dst dst_ temp
- * @param src src temp
- * @param jumps jump labels_
- * @param m temp map
- * @return formatted assembly string
+ * Write an instruction as `\t<mnemonic> <operand>, <operand>\n`
+ * @param dst dst_ temps, which DST operands refer to
+ * @param src src temps, which SRC, MEM and FRAME operands refer to
  */
-static std::string Format(std::string_view assem, temp::TempList *dst,
-                          temp::TempList *src, Targets *jumps, temp::Map *m) {
-  std::string result;
-  for (std::string::size_type i = 0; i < assem.size(); i++) {
-    char ch = assem.at(i);
-    if (ch == '`') {
-      i++;
-      switch (assem.at(i)) {
-      case 's': {
-        i++;
-        int n = assem.at(i) - '0';
-        std::string *s = m->Look(src->NthTemp(n));
-        result += *s;
-      } break;
-      case 'd': {
-        i++;
-        int n = assem.at(i) - '0';
-        std::string *s = m->Look(dst->NthTemp(n));
-        result += *s;
-      } break;
-      case 'j': {
-        i++;
-        assert(jumps);
-        std::string::size_type n = assem.at(i) - '0';
-        std::string s = temp::LabelFactory::LabelString(jumps->labels_->at(n));
-        result += s;
-      } break;
-      case '`': {
-        result += '`';
-      } break;
-      default:
-        assert(0);
-      }
-    } else {
-      result += ch;
-    }
+void PutInstr(output::AsmWriter &out, Opcode op, const Operand *operands,
+              temp::TempList *dst, temp::TempList *src, Targets *jumps,
+              temp::Map *m) {
+  out.Put('\t');
+  out.Put(Info(op).name_);
+  for (int i = 0; i < 2 && operands[i].kind_ != Operand::NONE; i++) {
+    out.Put(i == 0 ? " " : ", ");
+    PutOperand(out, operands[i], dst, src, jumps, m);
   }
-  return result;
+  out.Put('\n');
 }
 
-void OperInstr::Print(FILE *out, temp::Map *m) const {
-  std::string result = Format(assem_, dst_, src_, jumps_, m);
-  fprintf(out, "\t%s\n", result.data());
+} // namespace
+
+OperInstr::OperInstr(Opcode op, Operand first, Operand second,
+                     temp::TempList *dst, temp::TempList *src, Targets *jumps)
+    : op_(op), operands_{first, second}, dst_(dst), src_(src), jumps_(jumps) {
+  const OpcodeInfo &info = Info(op);
+  if (info.jump_ && jumps_ && !jumps_->labels_->empty())
+    flags_ |= JUMP;
+  if (info.direct_jump_)
+    flags_ |= DIRECT_JUMP;
+  if (info.call_)
+    flags_ |= CALL;
 }
 
-void LabelInstr::Print(FILE *out, temp::Map *m) const {
-  std::string result = Format(assem_, nullptr, nullptr, nullptr, m);
-  fprintf(out, "%s:\n", result.data());
+MoveInstr::MoveInstr(Opcode op, Operand first, Operand second,
+                     temp::TempList *dst, temp::TempList *src)
+    : op_(op), operands_{first, second}, dst_(dst), src_(src) {
+  if (op == Opcode::MOVQ && first.kind_ == Operand::SRC &&
+      second.kind_ == Operand::DST)
+    flags_ |= MOVE;
 }
 
-void MoveInstr::Print(FILE *out, temp::Map *m) const {
-  if (!dst_ && !src_) {
-    std::size_t srcpos = assem_.find_first_of('%');
-    if (srcpos != std::string::npos) {
-      std::size_t dstpos = assem_.find_first_of('%', srcpos + 1);
-      if (dstpos != std::string::npos) {
-        if ((assem_[srcpos + 1] == assem_[dstpos + 1]) &&
-            (assem_[srcpos + 2] == assem_[dstpos + 2]) &&
-            (assem_[srcpos + 3] == assem_[dstpos + 3]))
-          return;
-      }
-    }
-  }
-  std::string result = Format(assem_, dst_, src_, nullptr, m);
-  fprintf(out, "\t%s\n", result.data());
+void OperInstr::Print(output::AsmWriter &out, temp::Map *m) const {
+  PutInstr(out, op_, operands_, dst_, src_, jumps_, m);
 }
 
-void InstrList::Print(FILE *out, temp::Map *m) const {
+void LabelInstr::Print(output::AsmWriter &out, temp::Map *m) const {
+  out.Put(label_->Name());
+  out.Put(":\n");
+}
+
+void MoveInstr::Print(output::AsmWriter &out, temp::Map *m) const {
+  PutInstr(out, op_, operands_, dst_, src_, nullptr, m);
+}
+
+void InstrList::Print(output::AsmWriter &out, temp::Map *m) const {
   for (auto instr : instr_list_)
     instr->Print(out, m);
-  fprintf(out, "\n");
+  out.Put('\n');
+}
+
+void InstrList::Print(FILE *out, temp::Map *m) const {
+  output::AsmWriter writer(out);
+  Print(writer, m);
 }
 
 InstrList *InstrList::Compressed(temp::Map *m) {
   instr_list_.remove_if([m] (Instr *i) {
     return (i->IsMove() && 
-      m->Look(i->Def()->GetList().front()) == m->Look(i->Use()->GetList().front()));
+      m->Look(i->Def()[0]) == m->Look(i->Use()[0]));
   });
   return this;
 }
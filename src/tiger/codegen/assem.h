@@ -1,105 +1,172 @@
 #ifndef TIGER_CODEGEN_ASSEM_H_
 #define TIGER_CODEGEN_ASSEM_H_
 
+#include <cstdint>
 #include <cstdio>
+#include <list>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
 #include "tiger/frame/temp.h"
+#include "tiger/output/writer.h"
+#include "tiger/util/arena.h"
 
 namespace assem {
 
-class Targets {
+class Targets : public util::ProcObject {
 public:
   std::vector<temp::Label *> *labels_;
 
   explicit Targets(std::vector<temp::Label *> *labels) : labels_(labels) {}
 };
 
-class Instr {
+/* x86-64 instructions the code generator emits */
+enum class Opcode : uint8_t {
+  MOVQ,
+  LEAQ,
+  ADDQ,
+  SUBQ,
+  IMULQ,
+  IDIVQ,
+  CQTO,
+  CMPQ,
+  JMP,
+  JE,
+  JNE,
+  JL,
+  JLE,
+  JG,
+  JGE,
+  CALLQ,
+  SINK, // no code, keeps its sources live to the end of the function
+  OPCODE_COUNT,
+};
+
+/**
+ * Operand of an instruction. Registers are named by their position in the
+ * src or dst list of the instruction, so register allocation only rewrites
+ * those lists.
+ */
+struct Operand {
+  enum Kind : uint8_t {
+    NONE,
+    SRC,   // src[index_]
+    DST,   // dst[index_]
+    IMM,   // $disp_
+    MEM,   // disp_(src[index_])
+    FRAME, // (<label_>_framesize + disp_)(src[index_])
+    RIP,   // label_(%rip)
+    LABEL, // label_, the callee of a call
+    JUMP,  // jump target index_
+  };
+
+  Kind kind_ = NONE;
+  uint8_t index_ = 0;
+  int32_t disp_ = 0;
+  temp::Label *label_ = nullptr;
+
+  static Operand Src(int index) { return {SRC, uint8_t(index), 0, nullptr}; }
+  static Operand Dst(int index) { return {DST, uint8_t(index), 0, nullptr}; }
+  static Operand Imm(int value) { return {IMM, 0, value, nullptr}; }
+  static Operand Mem(int disp, int base) {
+    return {MEM, uint8_t(base), disp, nullptr};
+  }
+  /* relative to the frame size of the function named frame */
+  static Operand Frame(temp::Label *frame, int disp, int base) {
+    return {FRAME, uint8_t(base), disp, frame};
+  }
+  static Operand Rip(temp::Label *label) { return {RIP, 0, 0, label}; }
+  static Operand Name(temp::Label *label) { return {LABEL, 0, 0, label}; }
+  static Operand Jump(int index) { return {JUMP, uint8_t(index), 0, nullptr}; }
+};
+
+class Instr : public util::ProcObject {
 public:
   virtual ~Instr() = default;
-  virtual bool IsDirectJmp() const = 0;
-  virtual bool IsJmp() const = 0;
-  virtual bool IsMove() const = 0;
-
-  virtual void Print(FILE *out, temp::Map *m) const = 0;
-  [[nodiscard]] virtual temp::TempList *Def() const = 0;
-  [[nodiscard]] virtual temp::TempList *Use() const = 0;
+  [[nodiscard]] bool IsDirectJmp() const { return flags_ & DIRECT_JUMP; }
+  [[nodiscard]] bool IsJmp() const { return flags_ & JUMP; }
+  /* a move from one temp to another, which may be coalesced */
+  [[nodiscard]] bool IsMove() const { return flags_ & MOVE; }
+  [[nodiscard]] bool IsCall() const { return flags_ & CALL; }
+
+  virtual void Print(output::AsmWriter &out, temp::Map *m) const = 0;
+  /* the temps written and read, viewed in place */
+  [[nodiscard]] virtual temp::TempSpan Def() const = 0;
+  [[nodiscard]] virtual temp::TempSpan Use() const = 0;
+
+protected:
+  enum Flag : uint8_t { MOVE = 1, JUMP = 2, DIRECT_JUMP = 4, CALL = 8 };
+  uint8_t flags_ = 0;
 };
 
 class OperInstr : public Instr {
 public:
-  std::string assem_;
+  Opcode op_;
+  /* in the order they are written, the destination last */
+  Operand operands_[2];
   temp::TempList *dst_, *src_;
   Targets *jumps_;
 
-  OperInstr(std::string assem, temp::TempList *dst, temp::TempList *src,
-            Targets *jumps)
-      : assem_(std::move(assem)), dst_(dst), src_(src), jumps_(jumps) {}
-
-  bool IsDirectJmp() const override { 
-    return assem_.find("jmp") != std::string::npos; 
-  }
-  bool IsJmp() const override { return jumps_ != nullptr && jumps_->labels_->size(); }
-  bool IsMove() const override { return false; }
+  OperInstr(Opcode op, Operand first, Operand second, temp::TempList *dst,
+            temp::TempList *src, Targets *jumps);
 
-  void Print(FILE *out, temp::Map *m) const override;
-  [[nodiscard]] temp::TempList *Def() const override;
-  [[nodiscard]] temp::TempList *Use() const override;
+  void Print(output::AsmWriter &out, temp::Map *m) const override;
+  [[nodiscard]] temp::TempSpan Def() const override;
+  [[nodiscard]] temp::TempSpan Use() const override;
 };
 
 class LabelInstr : public Instr {
 public:
-  std::string assem_;
   temp::Label *label_;
 
-  LabelInstr(std::string assem, temp::Label *label)
-      : assem_(std::move(assem)), label_(label) {}
+  explicit LabelInstr(temp::Label *label) : label_(label) {}
 
-  bool IsDirectJmp() const override { return false; }
-  bool IsJmp() const override { return false; }
-  bool IsMove() const override { return false; }
-
-  void Print(FILE *out, temp::Map *m) const override;
-  [[nodiscard]] temp::TempList *Def() const override;
-  [[nodiscard]] temp::TempList *Use() const override;
+  void Print(output::AsmWriter &out, temp::Map *m) const override;
+  [[nodiscard]] temp::TempSpan Def() const override;
+  [[nodiscard]] temp::TempSpan Use() const override;
 };
 
+/* movq and leaq, with at most one temp written */
 class MoveInstr : public Instr {
 public:
-  std::string assem_;
+  Opcode op_;
+  Operand operands_[2];
   temp::TempList *dst_, *src_;
 
-  MoveInstr(std::string assem, temp::TempList *dst, temp::TempList *src)
-      : assem_(std::move(assem)), dst_(dst), src_(src) {}
-
-  bool IsDirectJmp() const override { return false; }
-  bool IsJmp() const override { return false; }
-  bool IsMove() const override { return !assem_.compare("movq `s0, `d0"); }
+  MoveInstr(Opcode op, Operand first, Operand second, temp::TempList *dst,
+            temp::TempList *src);
 
-  void Print(FILE *out, temp::Map *m) const override;
-  [[nodiscard]] temp::TempList *Def() const override;
-  [[nodiscard]] temp::TempList *Use() const override;
+  void Print(output::AsmWriter &out, temp::Map *m) const override;
+  [[nodiscard]] temp::TempSpan Def() const override;
+  [[nodiscard]] temp::TempSpan Use() const override;
 };
 
-class InstrList {
+class InstrList : public util::ProcObject {
 public:
   InstrList() = default;
 
+  void Print(output::AsmWriter &out, temp::Map *m) const;
   void Print(FILE *out, temp::Map *m) const;
   void Append(assem::Instr *instr) { instr_list_.push_back(instr); }
   void Remove(assem::Instr *instr) { instr_list_.remove(instr); }
-  void Insert(std::list<Instr *>::const_iterator pos, assem::Instr *instr) {
-    instr_list_.insert(pos, instr);
+  /* the position of the inserted instruction */
+  std::pmr::list<Instr *>::const_iterator
+  Insert(std::pmr::list<Instr *>::const_iterator pos, assem::Instr *instr) {
+    return instr_list_.insert(pos, instr);
+  }
+  /* the position after the erased instruction */
+  std::pmr::list<Instr *>::const_iterator
+  Erase(std::pmr::list<Instr *>::const_iterator pos) {
+    return instr_list_.erase(pos);
   }
-  [[nodiscard]] const std::list<Instr *> &GetList() const {
+  [[nodiscard]] const std::pmr::list<Instr *> &GetList() const {
     return instr_list_;
   }
   InstrList *Compressed(temp::Map *m);
 
 private:
-  std::list<Instr *> instr_list_;
+  std::pmr::list<Instr *> instr_list_{Resource()};
 };
 
 class Proc {
@@ -3,8 +3,6 @@
 #include <cassert>
 #include <sstream>
 
-extern frame::RegManager *reg_manager;
-
 namespace {
 
 constexpr int maxlen = 1024;
@@ -17,71 +15,75 @@ namespace cg {
 void CodeGen::Codegen() {
   auto list = new assem::InstrList();
   for (auto stm :traces_->GetStmList()->GetList())
-    stm->Munch(*list, fs_);
+    stm->Munch(*list, fs_, context_->GetRegManager());
 
   assem_instr_ = 
-    std::make_unique<AssemInstr>(frame::ProcEntryExit2(list));
+    std::make_unique<AssemInstr>(frame::ProcEntryExit2(frame_, list));
 }
 
 void AssemInstr::Print(FILE *out, temp::Map *map) const {
-  for (auto instr : instr_list_->GetList())
-    instr->Print(out, map);
-  fprintf(out, "\n");
+  instr_list_->Print(out, map);
 }
 } // namespace cg
 
 namespace tree {
 
+using assem::Operand;
+
 std::string fsPlaceHolder(std::string_view fs) {
   return std::string(fs) + "_framesize";
 }
 
-void SeqStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  left_->Munch(instr_list, fs);
-  right_->Munch(instr_list, fs);
+void SeqStm::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                   frame::RegManager *rm) {
+  left_->Munch(instr_list, fs, rm);
+  right_->Munch(instr_list, fs, rm);
 }
 
-void LabelStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  instr_list.Append(new assem::LabelInstr(
-    temp::LabelFactory::LabelString(label_), label_));
+void LabelStm::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                     frame::RegManager *rm) {
+  instr_list.Append(new assem::LabelInstr(label_));
 }
 
-void JumpStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
+void JumpStm::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) {
   assem::Instr *jmpInstr = new assem::OperInstr(
-    "jmp `j0", 
+    assem::Opcode::JMP, Operand::Jump(0), {},
     nullptr, nullptr, new assem::Targets(jumps_));
 
   instr_list.Append(jmpInstr);
 }
 
-void CjumpStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  temp::Temp *leftTemp = left_->Munch(instr_list, fs);
-  temp::Temp *rightTemp = right_->Munch(instr_list, fs);
+void CjumpStm::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                     frame::RegManager *rm) {
+  temp::Temp *leftTemp = left_->Munch(instr_list, fs, rm);
+  temp::Temp *rightTemp = right_->Munch(instr_list, fs, rm);
 
   assem::Instr *cmpInstr = new assem::OperInstr(
-    "cmpq `s0, `s1", 
+    assem::Opcode::CMPQ, Operand::Src(0), Operand::Src(1),
     nullptr, new temp::TempList({rightTemp, leftTemp}), nullptr);
 
-  std::string cjumpAssem;
+  assem::Opcode cjumpOp;
   switch (op_) {
-    case EQ_OP: cjumpAssem = "je `j0"; break;
-    case NE_OP: cjumpAssem = "jne `j0"; break;
-    case LT_OP: cjumpAssem = "jl `j0"; break;
-    case LE_OP: cjumpAssem = "jle `j0"; break;
-    case GT_OP: cjumpAssem = "jg `j0"; break;
-    case GE_OP: cjumpAssem = "jge `j0"; break;
+    case EQ_OP: cjumpOp = assem::Opcode::JE; break;
+    case NE_OP: cjumpOp = assem::Opcode::JNE; break;
+    case LT_OP: cjumpOp = assem::Opcode::JL; break;
+    case LE_OP: cjumpOp = assem::Opcode::JLE; break;
+    case GT_OP: cjumpOp = assem::Opcode::JG; break;
+    case GE_OP: cjumpOp = assem::Opcode::JGE; break;
     default: assert(0);
   }
   assem::Instr *cjumpInstr = new assem::OperInstr(
-    /* Example: "jle `j0" or "jg `j0"... */
-    cjumpAssem, nullptr, nullptr, 
+    /* Example: jle or jg... to the true label */
+    cjumpOp, Operand::Jump(0), {}, nullptr, nullptr, 
     new assem::Targets(new std::vector<temp::Label*>({true_label_})));
 
   instr_list.Append(cmpInstr);
   instr_list.Append(cjumpInstr);
 }
 
-void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
+void MoveStm::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) {
   /* these cases are insane, i need to handle fp here */
   if (typeid(*dst_) == typeid(tree::MemExp)) {
     tree::MemExp *memDst = static_cast<tree::MemExp*>(dst_);
@@ -94,41 +96,37 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
       if (typeid(*binopExp->left_) == typeid(tree::ConstExp)) {
         /* MOVE(MEM(BINOP(PLUS, CONST(i), e1)), e2) */
         consti = static_cast<tree::ConstExp*>(binopExp->left_)->consti_;
-        t1 = binopExp->right_->Munch(instr_list, fs);
-        t2 = src_->Munch(instr_list, fs);
+        t1 = binopExp->right_->Munch(instr_list, fs, rm);
+        t2 = src_->Munch(instr_list, fs, rm);
       } else 
 
       if (typeid(*binopExp->right_) == typeid(tree::ConstExp)) {
         /* MOVE(MEM(BINOP(PLUS, CONST(i), e1)), e2) */
         consti = static_cast<tree::ConstExp*>(binopExp->right_)->consti_;
         if (typeid(*binopExp->left_) == typeid(tree::TempExp) && 
-          static_cast<tree::TempExp*>(binopExp->left_)->temp_ == reg_manager->FramePointer()) {
-          t2 = src_->Munch(instr_list, fs);
-          char store[77];
-          if (consti >= 0) {
-            sprintf(store, "movq `s0, (%s + %d)(`s1)", fsPlaceHolder(fs).c_str(), consti);
-          } else {
-            sprintf(store, "movq `s0, (%s - %d)(`s1)", fsPlaceHolder(fs).c_str(), -consti);
-          }
+          static_cast<tree::TempExp*>(binopExp->left_)->temp_ == rm->FramePointer()) {
+          t2 = src_->Munch(instr_list, fs, rm);
           assem::Instr *frameStore = new assem::MoveInstr(
-            std::string(store), nullptr, new temp::TempList({t2, reg_manager->StackPointer()}));
+            assem::Opcode::MOVQ, Operand::Src(0), Operand::Frame(fs, consti, 1),
+            nullptr, new temp::TempList({t2, rm->StackPointer()}));
           instr_list.Append(frameStore); return;
         }
 
-        t1 = binopExp->left_->Munch(instr_list, fs);
-        t2 = src_->Munch(instr_list, fs);
+        t1 = binopExp->left_->Munch(instr_list, fs, rm);
+        t2 = src_->Munch(instr_list, fs, rm);
       } else 
 
       /* fall through to normal condition: MOVE(MEM(e1), e2) */ {
-        t1 = memDst->exp_->Munch(instr_list, fs);
-        t2 = src_->Munch(instr_list, fs);
+        t1 = memDst->exp_->Munch(instr_list, fs, rm);
+        t2 = src_->Munch(instr_list, fs, rm);
         assem::Instr *store = new assem::MoveInstr(
-          "movq `s0, (`s1)",nullptr, new temp::TempList({t2, t1}));
+          assem::Opcode::MOVQ, Operand::Src(0), Operand::Mem(0, 1),
+          nullptr, new temp::TempList({t2, t1}));
         instr_list.Append(store); return;
       }
 
       assem::Instr *binMemDstMove = new assem::MoveInstr(
-        "movq `s0, " + std::to_string(consti) + "(`s1)",
+        assem::Opcode::MOVQ, Operand::Src(0), Operand::Mem(consti, 1),
         nullptr, new temp::TempList({t2, t1}));
       instr_list.Append(binMemDstMove);
     } else 
@@ -137,12 +135,14 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
       /* MOVE(MEM(e1), MEM(e2)) */
       tree::MemExp *memSrc = static_cast<tree::MemExp*>(src_);
       temp::Temp *t = temp::TempFactory::NewTemp();
-      temp::Temp *t1 = memDst->exp_->Munch(instr_list, fs);
-      temp::Temp *t2 = memSrc->exp_->Munch(instr_list, fs);
+      temp::Temp *t1 = memDst->exp_->Munch(instr_list, fs, rm);
+      temp::Temp *t2 = memSrc->exp_->Munch(instr_list, fs, rm);
       assem::Instr *loadFrom = new assem::MoveInstr(
-        "movq (`s0), `d0", new temp::TempList(t), new temp::TempList(t2));
+        assem::Opcode::MOVQ, Operand::Mem(0, 0), Operand::Dst(0),
+        new temp::TempList(t), new temp::TempList(t2));
       assem::Instr *storeTo = new assem::MoveInstr(
-        "movq `s0, (`s1)", nullptr, new temp::TempList({t, t1}));
+        assem::Opcode::MOVQ, Operand::Src(0), Operand::Mem(0, 1),
+        nullptr, new temp::TempList({t, t1}));
       instr_list.Append(loadFrom); 
       instr_list.Append(storeTo);
     } else 
@@ -150,26 +150,27 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
     if (typeid(*src_) == typeid(tree::ConstExp)) {
       /* MOVE(MEM(e1), CONST(i)) */
       int consti = static_cast<tree::ConstExp*>(src_)->consti_;
-      temp::Temp *t1 = memDst->exp_->Munch(instr_list, fs);
+      temp::Temp *t1 = memDst->exp_->Munch(instr_list, fs, rm);
       assem::Instr *storeImm = new assem::MoveInstr(
-        "movq $" + std::to_string(consti) + ", (`s0)",
+        assem::Opcode::MOVQ, Operand::Imm(consti), Operand::Mem(0, 0),
         nullptr, new temp::TempList(t1));
       instr_list.Append(storeImm);
     } else 
     
     /* all other conditions */ {
       /* MOVE(MEM(e1), e2) */
-      temp::Temp *t1 = memDst->exp_->Munch(instr_list, fs);
-      temp::Temp *t2 = src_->Munch(instr_list, fs);
+      temp::Temp *t1 = memDst->exp_->Munch(instr_list, fs, rm);
+      temp::Temp *t2 = src_->Munch(instr_list, fs, rm);
       assem::Instr *store = new assem::MoveInstr(
-        "movq `s0, (`s1)",nullptr, new temp::TempList({t2, t1}));
+        assem::Opcode::MOVQ, Operand::Src(0), Operand::Mem(0, 1),
+        nullptr, new temp::TempList({t2, t1}));
       instr_list.Append(store);
     }
   } else {
     /* dst must be temp, and can't be fp */
     assert(typeid(*dst_) == typeid(tree::TempExp));
-    assert(static_cast<tree::TempExp*>(dst_)->temp_ != reg_manager->FramePointer());
-    temp::Temp *dstTemp = dst_->Munch(instr_list, fs);
+    assert(static_cast<tree::TempExp*>(dst_)->temp_ != rm->FramePointer());
+    temp::Temp *dstTemp = dst_->Munch(instr_list, fs, rm);
     /* handle fs */
     if (typeid(*src_) == typeid(tree::MemExp)) {
       auto memSrc = static_cast<tree::MemExp*>(src_);
@@ -180,59 +181,53 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
 
         if (typeid(*binopExp->left_) == typeid(tree::ConstExp)) {
           consti = static_cast<tree::ConstExp*>(binopExp->left_)->consti_;
-          srcTemp = binopExp->right_->Munch(instr_list, fs);
+          srcTemp = binopExp->right_->Munch(instr_list, fs, rm);
         } else 
 
         if (typeid(*binopExp->right_) == typeid(tree::ConstExp)) {
           consti = static_cast<tree::ConstExp*>(binopExp->right_)->consti_;
           if (typeid(*binopExp->left_) == typeid(tree::TempExp) && 
-          static_cast<tree::TempExp*>(binopExp->left_)->temp_ == reg_manager->FramePointer()) {
-            char load[77];
-            if (consti >= 0) {
-              sprintf(load, "movq (%s + %d)(`s0), `d0", fsPlaceHolder(fs).c_str(), consti);
-            } else {
-              sprintf(load, "movq (%s - %d)(`s0), `d0", fsPlaceHolder(fs).c_str(), -consti);
-            }
+          static_cast<tree::TempExp*>(binopExp->left_)->temp_ == rm->FramePointer()) {
             assem::Instr *frameLoad = new assem::MoveInstr(
-              std::string(load), 
-              new temp::TempList(dstTemp), new temp::TempList(reg_manager->StackPointer()));
+              assem::Opcode::MOVQ, Operand::Frame(fs, consti, 0), Operand::Dst(0),
+              new temp::TempList(dstTemp), new temp::TempList(rm->StackPointer()));
             instr_list.Append(frameLoad); return;
           }
-          srcTemp = binopExp->left_->Munch(instr_list, fs);
+          srcTemp = binopExp->left_->Munch(instr_list, fs, rm);
         } else 
         
         /* fall through */ {
-          srcTemp = memSrc->exp_->Munch(instr_list, fs);
+          srcTemp = memSrc->exp_->Munch(instr_list, fs, rm);
           assem::Instr *move = new assem::MoveInstr(
-            "movq (`s0), `d0",
+            assem::Opcode::MOVQ, Operand::Mem(0, 0), Operand::Dst(0),
             new temp::TempList(dstTemp), new temp::TempList(srcTemp));
           instr_list.Append(move); return;
         }
 
         assem::Instr *binMemSrcMove = new assem::MoveInstr(
-          "movq " + std::to_string(consti) + "(`s0), `d0",
+          assem::Opcode::MOVQ, Operand::Mem(consti, 0), Operand::Dst(0),
           new temp::TempList(dstTemp), new temp::TempList(srcTemp));
         instr_list.Append(binMemSrcMove);
       } else 
 
       /* all other conditions */ {
-      temp::Temp *srcTemp = memSrc->exp_->Munch(instr_list, fs);
+      temp::Temp *srcTemp = memSrc->exp_->Munch(instr_list, fs, rm);
       assem::Instr *move = new assem::MoveInstr(
-        "movq (`s0), `d0",
+        assem::Opcode::MOVQ, Operand::Mem(0, 0), Operand::Dst(0),
         new temp::TempList(dstTemp), new temp::TempList(srcTemp));
       instr_list.Append(move);    
       }
     } else if (typeid(*src_) == typeid(tree::ConstExp)) {
       int consti = static_cast<tree::ConstExp*>(src_)->consti_;
       assem::Instr *moveImm = new assem::MoveInstr(
-        "movq $" + std::to_string(consti) + ", `d0",
+        assem::Opcode::MOVQ, Operand::Imm(consti), Operand::Dst(0),
         new temp::TempList(dstTemp), nullptr);
       instr_list.Append(moveImm);
     } else {
       /* fall through */
-      temp::Temp *srcTemp = src_->Munch(instr_list, fs);
+      temp::Temp *srcTemp = src_->Munch(instr_list, fs, rm);
       assem::Instr *move = new assem::MoveInstr(
-        "movq `s0, `d0",
+        assem::Opcode::MOVQ, Operand::Src(0), Operand::Dst(0),
         new temp::TempList(dstTemp), new temp::TempList(srcTemp));
       instr_list.Append(move);    
     }
@@ -240,59 +235,58 @@ void MoveStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
 
 }
 
-void ExpStm::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  exp_->Munch(instr_list, fs);
+void ExpStm::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                   frame::RegManager *rm) {
+  exp_->Munch(instr_list, fs, rm);
 }
 
-temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  temp::Temp *lt = left_->Munch(instr_list, fs);
-  temp::Temp *rt = right_->Munch(instr_list, fs);
+temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                            frame::RegManager *rm) {
+  temp::Temp *lt = left_->Munch(instr_list, fs, rm);
+  temp::Temp *rt = right_->Munch(instr_list, fs, rm);
   temp::Temp *res = temp::TempFactory::NewTemp();
 
   if (op_ == tree::PLUS_OP || op_ == tree::MINUS_OP) {
-    std::string binopAssem;
-    switch (op_) {
-      case tree::PLUS_OP: binopAssem = "addq `s0, `d0"; break;
-      case tree::MINUS_OP: binopAssem = "subq `s0, `d0"; break;
-    }
+    assem::Opcode binop = 
+      op_ == tree::PLUS_OP ? assem::Opcode::ADDQ : assem::Opcode::SUBQ;
     /* move e1 to res first: no side-effect */
     assem::Instr *move = new assem::MoveInstr(
-      "movq `s0, `d0",
+      assem::Opcode::MOVQ, Operand::Src(0), Operand::Dst(0),
       new temp::TempList(res), new temp::TempList(lt));
     assem::Instr *op = new assem::OperInstr(
-      binopAssem,
+      binop, Operand::Src(0), Operand::Dst(0),
       new temp::TempList(res), new temp::TempList({rt, res}), nullptr);
     instr_list.Append(move);
     instr_list.Append(op);
   } else if (op_ == tree::MUL_OP) {
     assem::Instr *move1 = new assem::MoveInstr(
-      "movq `s0, `d0",
+      assem::Opcode::MOVQ, Operand::Src(0), Operand::Dst(0),
       new temp::TempList(frame::X64RegManager::rax), new temp::TempList(lt));
     assem::Instr *imul = new assem::OperInstr(
-      "imulq `s0",
+      assem::Opcode::IMULQ, Operand::Src(0), {},
       new temp::TempList({frame::X64RegManager::rax, frame::X64RegManager::rdx}), 
       new temp::TempList({rt, frame::X64RegManager::rax}), nullptr);
     assem::Instr *move2 = new assem::MoveInstr(
-      "movq `s0, `d0",
+      assem::Opcode::MOVQ, Operand::Src(0), Operand::Dst(0),
       new temp::TempList(res), new temp::TempList(frame::X64RegManager::rax));
     instr_list.Append(move1);
     instr_list.Append(imul);
     instr_list.Append(move2);
   } else if (op_ == tree::DIV_OP) {
     assem::Instr *move1 = new assem::MoveInstr(
-      "movq `s0, `d0",
+      assem::Opcode::MOVQ, Operand::Src(0), Operand::Dst(0),
       new temp::TempList(frame::X64RegManager::rax), new temp::TempList(lt));
     assem::Instr *cqto = new assem::OperInstr(
-      "cqto", 
+      assem::Opcode::CQTO, {}, {},
       new temp::TempList({frame::X64RegManager::rax, frame::X64RegManager::rdx}), 
       new temp::TempList(frame::X64RegManager::rax), nullptr);
     assem::Instr *idiv = new assem::OperInstr(
-      "idivq `s0",
+      assem::Opcode::IDIVQ, Operand::Src(0), {},
       new temp::TempList({frame::X64RegManager::rax, frame::X64RegManager::rdx}),
       new temp::TempList({rt, frame::X64RegManager::rax, frame::X64RegManager::rdx}),
       nullptr);
     assem::Instr *move2 = new assem::MoveInstr(
-      "movq `s0, `d0",
+      assem::Opcode::MOVQ, Operand::Src(0), Operand::Dst(0),
       new temp::TempList(res), new temp::TempList(frame::X64RegManager::rax));
     instr_list.Append(move1);
     instr_list.Append(cqto);
@@ -303,7 +297,8 @@ temp::Temp *BinopExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
   return res;
 }
 
-temp::Temp *MemExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
+temp::Temp *MemExp::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                          frame::RegManager *rm) {
   temp::Temp *resReg = temp::TempFactory::NewTemp();
   if (typeid(*exp_) == typeid(tree::BinopExp) && 
       static_cast<tree::BinopExp*>(exp_)->op_ == tree::PLUS_OP) {
@@ -311,31 +306,31 @@ temp::Temp *MemExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
     temp::Temp *t; int consti;
     if (typeid(*binopExp->left_) == typeid(tree::ConstExp)) {
       consti = static_cast<tree::ConstExp*>(binopExp->left_)->consti_;
-      t = binopExp->right_->Munch(instr_list, fs);
+      t = binopExp->right_->Munch(instr_list, fs, rm);
     } else 
 
     if (typeid(*binopExp->right_) == typeid(tree::ConstExp)) {
       consti = static_cast<tree::ConstExp*>(binopExp->right_)->consti_;
-      t = binopExp->left_->Munch(instr_list, fs);
+      t = binopExp->left_->Munch(instr_list, fs, rm);
     } else
 
     /* noconst, dont use goto statement */ {
-      t = exp_->Munch(instr_list, fs);
+      t = exp_->Munch(instr_list, fs, rm);
       assem::Instr *load = new assem::MoveInstr(
-        "movq (`s0), `d0",
+        assem::Opcode::MOVQ, Operand::Mem(0, 0), Operand::Dst(0),
         new temp::TempList(resReg), new temp::TempList(t));
       instr_list.Append(load); 
       return resReg;
     }
 
     assem::Instr *offsetLoad = new assem::MoveInstr(
-      "movq " + std::to_string(consti) + "(`s0), `d0",
+      assem::Opcode::MOVQ, Operand::Mem(consti, 0), Operand::Dst(0),
       new temp::TempList(resReg), new temp::TempList(t));
     instr_list.Append(offsetLoad);
   } else {
-    temp::Temp *t = exp_->Munch(instr_list, fs);
+    temp::Temp *t = exp_->Munch(instr_list, fs, rm);
     assem::Instr *load = new assem::MoveInstr(
-      "movq (`s0), `d0",
+      assem::Opcode::MOVQ, Operand::Mem(0, 0), Operand::Dst(0),
       new temp::TempList(resReg), new temp::TempList(t));
     instr_list.Append(load);
   }
@@ -343,12 +338,13 @@ temp::Temp *MemExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
   return resReg;
 }
 
-temp::Temp *TempExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  if (temp_ == reg_manager->FramePointer()) {
+temp::Temp *TempExp::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                           frame::RegManager *rm) {
+  if (temp_ == rm->FramePointer()) {
     temp::Temp *res = temp::TempFactory::NewTemp();
     assem::Instr *leaqInstr = new assem::MoveInstr(
-      "leaq " + fsPlaceHolder(fs) + "(`s0), `d0", 
-      new temp::TempList(res), new temp::TempList(reg_manager->StackPointer()));
+      assem::Opcode::LEAQ, Operand::Frame(fs, 0, 0), Operand::Dst(0),
+      new temp::TempList(res), new temp::TempList(rm->StackPointer()));
 
     instr_list.Append(leaqInstr);
     return res;
@@ -356,65 +352,70 @@ temp::Temp *TempExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
   return temp_;
 }
 
-temp::Temp *EseqExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  stm_->Munch(instr_list, fs);
-  return exp_->Munch(instr_list, fs);
+temp::Temp *EseqExp::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                           frame::RegManager *rm) {
+  stm_->Munch(instr_list, fs, rm);
+  return exp_->Munch(instr_list, fs, rm);
 }
 
-temp::Temp *NameExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
+temp::Temp *NameExp::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                           frame::RegManager *rm) {
   temp::Temp *res = temp::TempFactory::NewTemp();
   assem::Instr *name = new assem::OperInstr(
-    "leaq " + name_->Name() + "(%rip), `d0",
+    assem::Opcode::LEAQ, Operand::Rip(name_), Operand::Dst(0),
     new temp::TempList(res), nullptr, nullptr);
 
   instr_list.Append(name);
   return res;
 }
 
-temp::Temp *ConstExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
+temp::Temp *ConstExp::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                            frame::RegManager *rm) {
   temp::Temp *res = temp::TempFactory::NewTemp();
   assem::Instr *moveImmInstr = new assem::MoveInstr(
-    "movq $" + std::to_string(consti_) + ", `d0",
+    assem::Opcode::MOVQ, Operand::Imm(consti_), Operand::Dst(0),
     new temp::TempList(res), nullptr);
 
   instr_list.Append(moveImmInstr);
   return res;
 }
 
-temp::Temp *CallExp::Munch(assem::InstrList &instr_list, std::string_view fs) {
-  temp::TempList *usedRegs = args_->MunchArgs(instr_list, fs);
+temp::Temp *CallExp::Munch(assem::InstrList &instr_list, temp::Label *fs,
+                           frame::RegManager *rm) {
+  temp::TempList *usedRegs = args_->MunchArgs(instr_list, fs, rm);
   temp::Temp *resReg = temp::TempFactory::NewTemp();
-  std::string funcName = temp::LabelFactory::LabelString(static_cast<tree::NameExp*>(fun_)->name_);
+  temp::Label *funcName = static_cast<tree::NameExp*>(fun_)->name_;
   assem::Instr *call = new assem::OperInstr(
-    "callq " + funcName,
-    reg_manager->CallerSaves(), usedRegs, nullptr);
+    assem::Opcode::CALLQ, Operand::Name(funcName), {},
+    rm->CallerSaves(), usedRegs, nullptr);
   assem::Instr *moveRet = new assem::MoveInstr(
-    "movq `s0, `d0",
-    new temp::TempList(resReg), new temp::TempList(reg_manager->ReturnValue()));
+    assem::Opcode::MOVQ, Operand::Src(0), Operand::Dst(0),
+    new temp::TempList(resReg), new temp::TempList(rm->ReturnValue()));
 
   instr_list.Append(call);
   instr_list.Append(moveRet);
   return resReg;
 }
 
-temp::TempList *ExpList::MunchArgs(assem::InstrList &instr_list, std::string_view fs) {
-  auto argRegs = reg_manager->ArgRegs()->GetList();
+temp::TempList *ExpList::MunchArgs(assem::InstrList &instr_list, temp::Label *fs,
+                                   frame::RegManager *rm) {
+  auto argRegs = rm->ArgRegs()->GetList();
   auto regItr = argRegs.begin();
   temp::TempList *usedRegs = new temp::TempList();
   int offset = 0;
   for (auto exp : exp_list_) {
-    temp::Temp *expRes = exp->Munch(instr_list, fs);
+    temp::Temp *expRes = exp->Munch(instr_list, fs, rm);
     if (regItr != argRegs.end()) {
       assem::Instr *moveToReg = new assem::MoveInstr(
-        "movq `s0, `d0",
+        assem::Opcode::MOVQ, Operand::Src(0), Operand::Dst(0),
         new temp::TempList(*regItr), new temp::TempList(expRes));
       instr_list.Append(moveToReg);
       usedRegs->Append(*regItr);
       regItr++; 
     } else {
       assem::Instr *moveToFrame = new assem::MoveInstr(
-        "movq `s0, " + std::to_string(offset) + "(`s1)",
-        nullptr, new temp::TempList({expRes, reg_manager->StackPointer()}));
+        assem::Opcode::MOVQ, Operand::Src(0), Operand::Mem(offset, 1),
+        nullptr, new temp::TempList({expRes, rm->StackPointer()}));
       instr_list.Append(moveToFrame);
       offset += frame::WORD_SIZE;
     }
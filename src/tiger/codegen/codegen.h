@@ -3,6 +3,7 @@
 
 #include "tiger/canon/canon.h"
 #include "tiger/codegen/assem.h"
+#include "tiger/context/context.h"
 #include "tiger/frame/x64frame.h"
 #include "tiger/translate/tree.h"
 
@@ -39,8 +40,10 @@ private:
 
 class CodeGen {
 public:
-  CodeGen(frame::Frame *frame, std::unique_ptr<canon::Traces> traces)
-      : frame_(frame), traces_(std::move(traces)), fs_(frame->Name()->Name()) {}
+  CodeGen(ctx::CompilerContext *context, frame::Frame *frame,
+          std::unique_ptr<canon::Traces> traces)
+      : context_(context), frame_(frame), traces_(std::move(traces)),
+        fs_(frame->Name()) {}
 
   void Codegen();
   std::unique_ptr<AssemInstr> TransferAssemInstr() {
@@ -48,8 +51,9 @@ public:
   }
 
 private:
+  ctx::CompilerContext *context_;
   frame::Frame *frame_;
-  std::string fs_; // Frame size label_
+  temp::Label *fs_; // Frame size label_
   std::unique_ptr<canon::Traces> traces_;
   std::unique_ptr<AssemInstr> assem_instr_;
 };
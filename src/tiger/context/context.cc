@@ -0,0 +1,19 @@
+#include "tiger/context/context.h"
+
+namespace ctx {
+
+thread_local CompilerContext *CompilerContext::current_ = nullptr;
+
+CompilerContext::CompilerContext(frame::RegManager *reg_manager)
+    : reg_manager_(reg_manager),
+      temp_factory_(temp::TempFactory::NextGlobalId()) {}
+
+CompilerContext *CompilerContext::Current() { return current_; }
+
+CompilerContext::Scope::Scope(CompilerContext *context) : prev_(current_) {
+  current_ = context;
+}
+
+CompilerContext::Scope::~Scope() { current_ = prev_; }
+
+} // namespace ctx
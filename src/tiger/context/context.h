@@ -0,0 +1,98 @@
+#ifndef TIGER_CONTEXT_CONTEXT_H_
+#define TIGER_CONTEXT_CONTEXT_H_
+
+#include <cstdio>
+
+#include "tiger/frame/frame.h"
+#include "tiger/frame/temp.h"
+#include "tiger/regalloc/options.h"
+#include "tiger/symbol/symbol.h"
+
+namespace cache {
+class AssemCache;
+} // namespace cache
+
+namespace ctx {
+
+/**
+ * All the state of compiling one Tiger program: fragments, symbols, temps and
+ * labels. Contexts share nothing but the register manager, so several
+ * programs can be compiled in one process at the same time.
+ */
+class CompilerContext {
+public:
+  explicit CompilerContext(frame::RegManager *reg_manager);
+  CompilerContext(const CompilerContext &context) = delete;
+  CompilerContext &operator=(const CompilerContext &context) = delete;
+  ~CompilerContext() = default;
+
+  [[nodiscard]] frame::RegManager *GetRegManager() const {
+    return reg_manager_;
+  }
+  [[nodiscard]] frame::Frags *GetFrags() { return &frags_; }
+  [[nodiscard]] sym::SymbolPool *GetSymbolPool() { return &symbol_pool_; }
+  [[nodiscard]] temp::TempFactory *GetTempFactory() { return &temp_factory_; }
+  [[nodiscard]] temp::LabelFactory *GetLabelFactory() {
+    return &label_factory_;
+  }
+
+  /**
+   * Stream receiving the diagnostics of this compilation, stderr by default
+   */
+  [[nodiscard]] FILE *GetDiagnostics() const { return diagnostics_; }
+  void SetDiagnostics(FILE *diagnostics) { diagnostics_ = diagnostics; }
+
+  /**
+   * Cache of function assembly, shared like the register manager; nullptr
+   * if every function is compiled
+   */
+  [[nodiscard]] cache::AssemCache *GetAssemCache() const { return cache_; }
+  void SetAssemCache(cache::AssemCache *cache) { cache_ = cache; }
+
+  /**
+   * Register allocator of every function, coloring by default
+   */
+  [[nodiscard]] const ra::Options &GetRegAllocOptions() const {
+    return ra_options_;
+  }
+  void SetRegAllocOptions(const ra::Options &options) {
+    ra_options_ = options;
+  }
+
+  /**
+   * Context of the calling thread
+   * @return current context, nullptr outside of any compilation
+   */
+  static CompilerContext *Current();
+
+  /**
+   * Make a context current for the calling thread while the scope is alive.
+   * Every thread working on a program must open one.
+   */
+  class Scope {
+  public:
+    explicit Scope(CompilerContext *context);
+    Scope(const Scope &scope) = delete;
+    Scope &operator=(const Scope &scope) = delete;
+    ~Scope();
+
+  private:
+    CompilerContext *prev_;
+  };
+
+private:
+  frame::RegManager *reg_manager_;
+  frame::Frags frags_;
+  sym::SymbolPool symbol_pool_;
+  temp::TempFactory temp_factory_;
+  temp::LabelFactory label_factory_;
+  FILE *diagnostics_ = stderr;
+  cache::AssemCache *cache_ = nullptr;
+  ra::Options ra_options_;
+
+  static thread_local CompilerContext *current_;
+};
+
+} // namespace ctx
+
+#endif // TIGER_CONTEXT_CONTEXT_H_
@@ -0,0 +1,189 @@
+#include "tiger/driver/driver.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "tiger/absyn/absyn.h"
+#include "tiger/context/context.h"
+#include "tiger/elf/object.h"
+#include "tiger/escape/escape.h"
+#include "tiger/output/logger.h"
+#include "tiger/output/output.h"
+#include "tiger/parse/parser.h"
+#include "tiger/semant/semant.h"
+#include "tiger/stats/stats.h"
+#include "tiger/translate/translate.h"
+#include "tiger/util/arena.h"
+#include "tiger/util/thread_pool.h"
+
+namespace driver {
+
+namespace {
+
+/**
+ * Run the front end of the compiler, leaving the fragments in the context
+ * @return whether the program is free of errors
+ */
+bool Translate(ctx::CompilerContext *context, std::string_view fname) {
+  // The syntax tree is released as soon as the program is translated
+  util::Arena absyn_arena;
+  util::AbsynObject::Scope absyn_scope(&absyn_arena);
+  std::unique_ptr<absyn::AbsynTree> absyn_tree;
+
+  try {
+    std::unique_ptr<err::ErrorMsg> errormsg;
+
+    {
+      // Lab 3: parsing
+      TigerLog("-------====Parse=====-----\n");
+      stats::PassTimer timer("Parse");
+      Parser parser(fname, std::cerr);
+      if (parser.parse() != 0)
+        return false;
+      absyn_tree = parser.TransferAbsynTree();
+      errormsg = parser.TransferErrormsg();
+    }
+
+    {
+      // Lab 4: semantic analysis
+      TigerLog("-------====Semantic analysis=====-----\n");
+      stats::PassTimer timer("Semantic");
+      sem::ProgSem prog_sem(std::move(absyn_tree), std::move(errormsg));
+      prog_sem.SemAnalyze();
+      absyn_tree = prog_sem.TransferAbsynTree();
+      errormsg = prog_sem.TransferErrormsg();
+    }
+
+    {
+      // Lab 5: escape analysis
+      TigerLog("-------====Escape analysis=====-----\n");
+      stats::PassTimer timer("Escape");
+      esc::EscFinder esc_finder(std::move(absyn_tree));
+      esc_finder.FindEscape();
+      absyn_tree = esc_finder.TransferAbsynTree();
+    }
+
+    {
+      // Lab 5: translate IR tree
+      TigerLog("-------====Translate=====-----\n");
+      stats::PassTimer timer("Translate");
+      tr::ProgTr prog_tr(context, std::move(absyn_tree), std::move(errormsg));
+      prog_tr.Translate();
+      errormsg = prog_tr.TransferErrormsg();
+    }
+
+    // Don't continue if error occurrs
+    return !errormsg->AnyErrors();
+  } catch (const std::invalid_argument &e) {
+    fprintf(context->GetDiagnostics(), "%s: %s\n", std::string(fname).data(),
+            e.what());
+    return false;
+  }
+}
+
+/**
+ * Assemble the program in process and write `<fname>.o`
+ * @return whether the object is written
+ */
+bool EmitObject(ctx::CompilerContext *context, std::string_view fname,
+                int jobs) {
+  output::AsmWriter assem;
+  {
+    output::AssemGen assem_gen(context, &assem);
+    if (!assem_gen.GenAssem(true, jobs))
+      return false;
+  }
+
+  stats::PassTimer timer("Assemble");
+  elf::ObjectFile object;
+  bool ok = object.Assemble(assem.Text());
+  if (ok) {
+    std::string outfile = std::string(fname) + ".o";
+    FILE *out = fopen(outfile.data(), "wb");
+    ok = out && object.Write(out);
+    if (out)
+      ok = fclose(out) == 0 && ok;
+    else
+      perror(outfile.data());
+  }
+  if (!ok && !object.Error().empty())
+    fprintf(context->GetDiagnostics(), "%s: %s\n", std::string(fname).data(),
+            object.Error().data());
+  return ok;
+}
+
+} // namespace
+
+int Compile(frame::RegManager *reg_manager, std::string_view fname,
+            const Options &options) {
+  ctx::CompilerContext context(reg_manager);
+  ctx::CompilerContext::Scope scope(&context);
+  context.SetAssemCache(options.assem_cache);
+  context.SetRegAllocOptions(options.ra);
+
+  if (!Translate(&context, fname))
+    return 1;
+
+  if (options.emit_obj)
+    return EmitObject(&context, fname, options.jobs) ? 0 : 1;
+
+  // Output assembly
+  output::AssemGen assem_gen(&context, fname, options.mmap_output);
+  return assem_gen.GenAssem(true, options.jobs) ? 0 : 1;
+}
+
+int Compile(frame::RegManager *reg_manager, std::string_view fname,
+            FILE *out, FILE *diagnostics, const Options &options) {
+  ctx::CompilerContext context(reg_manager);
+  ctx::CompilerContext::Scope scope(&context);
+  context.SetDiagnostics(diagnostics);
+  context.SetAssemCache(options.assem_cache);
+  context.SetRegAllocOptions(options.ra);
+
+  if (!Translate(&context, fname))
+    return 1;
+
+  // Output assembly
+  output::AssemGen assem_gen(&context, out);
+  return assem_gen.GenAssem(true, options.jobs) ? 0 : 1;
+}
+
+int CompileBatch(frame::RegManager *reg_manager,
+                 const std::vector<std::string> &fnames,
+                 const Options &options) {
+  std::atomic<int> failures{0};
+  // Programs run in parallel already, keep each backend serial
+  Options serial = options;
+  serial.jobs = 1;
+
+  util::ThreadPool pool(options.jobs);
+  for (const auto &fname : fnames) {
+    pool.Submit([reg_manager, &fname, &failures, &serial] {
+      if (Compile(reg_manager, fname, serial) != 0)
+        failures++;
+    });
+  }
+  pool.Wait();
+
+  return failures;
+}
+
+bool ReadFileList(std::string_view list_name,
+                  std::vector<std::string> &fnames) {
+  std::ifstream list(std::string(list_name).data());
+  if (!list.good())
+    return false;
+
+  std::string line;
+  while (std::getline(list, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (!line.empty())
+      fnames.push_back(line);
+  }
+  return true;
+}
+
+} // namespace driver
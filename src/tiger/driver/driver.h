@@ -0,0 +1,73 @@
+#ifndef TIGER_DRIVER_DRIVER_H_
+#define TIGER_DRIVER_DRIVER_H_
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tiger/cache/cache.h"
+#include "tiger/frame/frame.h"
+#include "tiger/regalloc/options.h"
+
+namespace driver {
+
+/**
+ * Settings shared by the compilations of one process
+ */
+struct Options {
+  /* threads running the backend of a program, or in batch and server modes
+   * the number of programs compiled at the same time */
+  int jobs = 1;
+  /* cache of function assembly, nullptr to compile every function */
+  cache::AssemCache *assem_cache = nullptr;
+  /* write an ELF object `<fname>.o` instead of `<fname>.s`, see -c; streams
+   * given by the caller always receive assembly */
+  bool emit_obj = false;
+  /* write `<fname>.s` through a memory mapping */
+  bool mmap_output = false;
+  /* register allocator, see -O0 and --ra */
+  ra::Options ra;
+};
+
+/**
+ * Compile a Tiger program into `<fname>.s`, or `<fname>.o` with emit_obj,
+ * within a context of its own
+ * @param reg_manager register manager, may be shared by concurrent calls
+ * @param fname source file
+ * @param options jobs and cache
+ * @return 0 on success, 1 if the program has errors
+ */
+int Compile(frame::RegManager *reg_manager, std::string_view fname,
+            const Options &options);
+
+/**
+ * Compile a Tiger program, writing assembly and diagnostics to streams owned
+ * by the caller. Nothing is written to `out` if the program has errors.
+ * @return 0 on success, 1 if the program has errors
+ */
+int Compile(frame::RegManager *reg_manager, std::string_view fname,
+            FILE *out, FILE *diagnostics, const Options &options);
+
+/**
+ * Compile many programs concurrently in one process
+ * @param reg_manager register manager shared by every program
+ * @param fnames source files
+ * @param options jobs and cache, every program runs a serial backend
+ * @return number of programs which fail to compile
+ */
+int CompileBatch(frame::RegManager *reg_manager,
+                 const std::vector<std::string> &fnames,
+                 const Options &options);
+
+/**
+ * Read a file list for batch mode, one source file per line
+ * @param list_name path of the list
+ * @param fnames where the source files are appended
+ * @return false if the list cannot be read
+ */
+bool ReadFileList(std::string_view list_name, std::vector<std::string> &fnames);
+
+} // namespace driver
+
+#endif // TIGER_DRIVER_DRIVER_H_
@@ -0,0 +1,323 @@
+#include "tiger/driver/server.h"
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "tiger/driver/driver.h"
+#include "tiger/util/thread_pool.h"
+
+namespace {
+
+/* a client silent this long is dropped, so it cannot hold a thread */
+constexpr int kTimeoutSeconds = 30;
+/* largest source sent inline */
+constexpr size_t kMaxInlineSize = 64 << 20;
+
+bool MakeAddress(std::string_view socket_path, sockaddr_un &addr) {
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "socket path too long: %s\n",
+            std::string(socket_path).data());
+    return false;
+  }
+  memcpy(addr.sun_path, socket_path.data(), socket_path.size());
+  return true;
+}
+
+int Connect(std::string_view socket_path) {
+  sockaddr_un addr;
+  if (!MakeAddress(socket_path, addr))
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool WriteAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool ReadLine(FILE *in, std::string &line) {
+  line.clear();
+  int c;
+  while ((c = fgetc(in)) != EOF && c != '\n')
+    line.push_back(static_cast<char>(c));
+  return c != EOF || !line.empty();
+}
+
+bool ReadBytes(FILE *in, size_t size, std::string &bytes) {
+  bytes.resize(size);
+  return fread(bytes.data(), 1, size, in) == size;
+}
+
+/**
+ * Read a `<keyword> <n>` line followed by n bytes
+ */
+bool ReadBlock(FILE *in, std::string_view keyword, std::string &bytes) {
+  std::string line;
+  if (!ReadLine(in, line) || line.compare(0, keyword.size(), keyword) != 0 ||
+      line.size() <= keyword.size() + 1)
+    return false;
+  return ReadBytes(in, strtoul(line.data() + keyword.size() + 1, nullptr, 10),
+                   bytes);
+}
+
+bool StartsWith(const std::string &line, std::string_view prefix) {
+  return line.compare(0, prefix.size(), prefix) == 0;
+}
+
+void Respond(int fd, int status, const std::string &diag,
+             const std::string &assem) {
+  std::string response = "STATUS " + std::to_string(status) + "\n";
+  response += "DIAG " + std::to_string(diag.size()) + "\n" + diag;
+  response += "ASSEM " + std::to_string(assem.size()) + "\n" + assem;
+  WriteAll(fd, response.data(), response.size());
+}
+
+/**
+ * Handle one connection
+ * @return whether the client asks the server to stop
+ */
+bool HandleRequest(frame::RegManager *reg_manager,
+                   const driver::Options &options, int fd) {
+  FILE *in = fdopen(dup(fd), "r");
+  std::string line, source_path, source_text, out_path;
+  bool has_inline = false, shutdown = false, well_formed = false;
+  const char *error = "malformed request\n";
+
+  while (ReadLine(in, line)) {
+    if (line == "END") {
+      well_formed = !source_path.empty() || has_inline;
+      break;
+    } else if (line == "SHUTDOWN") {
+      shutdown = well_formed = true;
+      break;
+    } else if (StartsWith(line, "SOURCE ")) {
+      source_path = line.substr(7);
+    } else if (StartsWith(line, "INLINE ")) {
+      size_t size = strtoul(line.data() + 7, nullptr, 10);
+      if (size > kMaxInlineSize) {
+        error = "inline source too large\n";
+        break;
+      }
+      if (!ReadBytes(in, size, source_text))
+        break;
+      has_inline = true;
+    } else if (StartsWith(line, "OUTPUT ")) {
+      out_path = line.substr(7);
+    } else {
+      break;
+    }
+  }
+  if (ferror(in) && (errno == EAGAIN || errno == EWOULDBLOCK))
+    error = "request timed out\n";
+  fclose(in);
+
+  if (!well_formed) {
+    Respond(fd, 2, error, "");
+    return false;
+  }
+  if (shutdown) {
+    Respond(fd, 0, "", "");
+    return true;
+  }
+
+  // Inline source goes through a temporary file, as the scanner reads files
+  char tmp_name[] = "/tmp/tiger-XXXXXX.tig";
+  if (has_inline) {
+    int tmp_fd = mkstemps(tmp_name, 4);
+    if (tmp_fd < 0 ||
+        write(tmp_fd, source_text.data(), source_text.size()) !=
+            static_cast<ssize_t>(source_text.size())) {
+      if (tmp_fd >= 0) {
+        close(tmp_fd);
+        unlink(tmp_name);
+      }
+      Respond(fd, 2, "cannot store inline source\n", "");
+      return false;
+    }
+    close(tmp_fd);
+    source_path = tmp_name;
+  }
+
+  char *assem_buf = nullptr, *diag_buf = nullptr;
+  size_t assem_size = 0, diag_size = 0;
+  FILE *assem_out = open_memstream(&assem_buf, &assem_size);
+  FILE *diag_out = open_memstream(&diag_buf, &diag_size);
+  int status =
+      driver::Compile(reg_manager, source_path, assem_out, diag_out, options);
+  fclose(assem_out);
+  fclose(diag_out);
+  std::string assem(assem_buf, assem_size), diag(diag_buf, diag_size);
+  free(assem_buf);
+  free(diag_buf);
+  if (has_inline)
+    unlink(tmp_name);
+
+  if (status == 0 && !out_path.empty()) {
+    FILE *out = fopen(out_path.data(), "w");
+    if (out && fwrite(assem.data(), 1, assem.size(), out) == assem.size()) {
+      fclose(out);
+    } else {
+      if (out)
+        fclose(out);
+      diag += "cannot write " + out_path + "\n";
+      status = 1;
+    }
+  }
+
+  Respond(fd, status, diag, assem);
+  return false;
+}
+
+/**
+ * Send a request and wait for the response
+ * @return status of the response, -1 if the server cannot be reached
+ */
+int Exchange(std::string_view socket_path, const std::string &request,
+             std::string &diag, std::string &assem) {
+  int fd = Connect(socket_path);
+  if (fd < 0) {
+    fprintf(stderr, "cannot connect to %s: %s\n",
+            std::string(socket_path).data(), strerror(errno));
+    return -1;
+  }
+  if (!WriteAll(fd, request.data(), request.size())) {
+    close(fd);
+    return -1;
+  }
+
+  FILE *in = fdopen(fd, "r");
+  std::string line;
+  int status = -1;
+  if (ReadLine(in, line) && StartsWith(line, "STATUS ") &&
+      ReadBlock(in, "DIAG", diag) && ReadBlock(in, "ASSEM", assem))
+    status = atoi(line.data() + 7);
+  fclose(in);
+
+  if (status < 0)
+    fprintf(stderr, "bad response from %s\n", std::string(socket_path).data());
+  return status;
+}
+
+} // namespace
+
+namespace driver {
+
+int Serve(frame::RegManager *reg_manager, std::string_view socket_path,
+          const Options &options) {
+  sockaddr_un addr;
+  if (!MakeAddress(socket_path, addr))
+    return 1;
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(addr.sun_path);
+  if (listen_fd < 0 ||
+      bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      listen(listen_fd, SOMAXCONN) < 0) {
+    perror("tiger-compiler: cannot listen");
+    return 1;
+  }
+
+  std::atomic<bool> stop{false};
+  {
+    // Requests run in parallel already, keep each backend serial
+    Options serial = options;
+    serial.jobs = 1;
+    util::ThreadPool pool(options.jobs);
+    while (!stop) {
+      int fd = accept(listen_fd, nullptr, nullptr);
+      if (fd < 0) {
+        if (errno == EINTR || errno == ECONNABORTED)
+          continue;
+        break; // closed by a shutdown request
+      }
+      timeval timeout{kTimeoutSeconds, 0};
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+      pool.Submit([reg_manager, &serial, fd, listen_fd, &stop] {
+        if (HandleRequest(reg_manager, serial, fd)) {
+          stop = true;
+          shutdown(listen_fd, SHUT_RDWR); // wake up accept()
+        }
+        close(fd);
+      });
+    }
+    pool.Wait();
+  }
+
+  close(listen_fd);
+  unlink(addr.sun_path);
+  return 0;
+}
+
+int RunClient(std::string_view socket_path, std::string_view fname,
+              std::string_view out_path) {
+  std::string request;
+  if (fname == "-") {
+    std::string source;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), stdin)) > 0)
+      source.append(buf, n);
+    request = "INLINE " + std::to_string(source.size()) + "\n" + source;
+  } else {
+    // The server may run in another directory
+    char resolved[PATH_MAX];
+    std::string path(fname);
+    if (realpath(path.data(), resolved))
+      path = resolved;
+    request = "SOURCE " + path + "\n";
+  }
+  request += "END\n";
+
+  std::string diag, assem;
+  int status = Exchange(socket_path, request, diag, assem);
+  if (status < 0)
+    return 1;
+
+  fwrite(diag.data(), 1, diag.size(), stderr);
+  if (status != 0)
+    return status;
+
+  FILE *out = out_path == "-" ? stdout : fopen(std::string(out_path).data(), "w");
+  if (!out) {
+    fprintf(stderr, "cannot write %s\n", std::string(out_path).data());
+    return 1;
+  }
+  fwrite(assem.data(), 1, assem.size(), out);
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
+
+int StopServer(std::string_view socket_path) {
+  std::string diag, assem;
+  return Exchange(socket_path, "SHUTDOWN\n", diag, assem) == 0 ? 0 : 1;
+}
+
+} // namespace driver
@@ -0,0 +1,55 @@
+#ifndef TIGER_DRIVER_SERVER_H_
+#define TIGER_DRIVER_SERVER_H_
+
+#include <string_view>
+
+#include "tiger/driver/driver.h"
+#include "tiger/frame/frame.h"
+
+namespace driver {
+
+/**
+ * Compile server protocol, one request per connection over a Unix socket.
+ *
+ * Request, a header of text lines closed by END:
+ *   SOURCE <path>          compile a file visible to the server, or
+ *   INLINE <n>\n<n bytes>  compile the source text that follows
+ *   OUTPUT <path>          optional, the server also writes the assembly here
+ *   END
+ * A request made of the single line SHUTDOWN stops the server. Inline
+ * sources are limited to 64 MiB, and a client sending nothing for 30
+ * seconds gets an error.
+ *
+ * Response:
+ *   STATUS <code>          0 on success, 1 if the program has errors
+ *   DIAG <n>\n<n bytes>    diagnostics
+ *   ASSEM <n>\n<n bytes>   assembly, empty on errors
+ */
+
+/**
+ * Serve compile requests until a SHUTDOWN request comes
+ * @param reg_manager register manager shared by every request
+ * @param socket_path path of the Unix socket, replaced if it exists
+ * @param options jobs is the number of requests handled at the same time
+ * @return exit status of the process
+ */
+int Serve(frame::RegManager *reg_manager, std::string_view socket_path,
+          const Options &options);
+
+/**
+ * Send one file to a compile server, print its diagnostics to stderr and
+ * write the assembly to `out_path`
+ * @param fname source file, "-" to send standard input inline
+ * @return exit status of the process
+ */
+int RunClient(std::string_view socket_path, std::string_view fname,
+              std::string_view out_path);
+
+/**
+ * Ask a compile server to stop
+ */
+int StopServer(std::string_view socket_path);
+
+} // namespace driver
+
+#endif // TIGER_DRIVER_SERVER_H_
@@ -0,0 +1,346 @@
+#include "tiger/elf/object.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+
+namespace {
+
+std::string_view Trim(std::string_view s) {
+  while (!s.empty() && isspace(static_cast<unsigned char>(s.front())))
+    s.remove_prefix(1);
+  while (!s.empty() && isspace(static_cast<unsigned char>(s.back())))
+    s.remove_suffix(1);
+  return s;
+}
+
+bool ParseInt(std::string_view text, int64_t &value) {
+  std::string digits(Trim(text));
+  char *end;
+  value = strtoll(digits.data(), &end, 0);
+  return !digits.empty() && *end == '\0';
+}
+
+/**
+ * Decode the quoted operand of .string the way the GNU assembler does
+ */
+bool DecodeString(std::string_view quoted, std::vector<uint8_t> &out) {
+  quoted = Trim(quoted);
+  if (quoted.size() < 2 || quoted.front() != '"' || quoted.back() != '"')
+    return false;
+  std::string_view s = quoted.substr(1, quoted.size() - 2);
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] != '\\') {
+      out.push_back(s[i]);
+      continue;
+    }
+    if (++i == s.size())
+      return false;
+    switch (s[i]) {
+    case 'b': out.push_back('\b'); break;
+    case 'f': out.push_back('\f'); break;
+    case 'n': out.push_back('\n'); break;
+    case 'r': out.push_back('\r'); break;
+    case 't': out.push_back('\t'); break;
+    case 'x': {
+      int value = 0;
+      while (i + 1 < s.size() && isxdigit(static_cast<unsigned char>(s[i + 1])))
+        value = value * 16 + (isdigit(s[++i]) ? s[i] - '0'
+                                              : tolower(s[i]) - 'a' + 10);
+      out.push_back(value);
+    } break;
+    default:
+      if (s[i] >= '0' && s[i] <= '7') {
+        int value = s[i] - '0';
+        for (int n = 1; n < 3 && i + 1 < s.size() && s[i + 1] >= '0' &&
+                        s[i + 1] <= '7';
+             n++)
+          value = value * 8 + (s[++i] - '0');
+        out.push_back(value);
+      } else {
+        out.push_back(s[i]);
+      }
+    }
+  }
+  out.push_back('\0');
+  return true;
+}
+
+/* string table under construction */
+class StringTable {
+public:
+  StringTable() : data_(1, '\0') {}
+  uint32_t Add(std::string_view s) {
+    auto offset = static_cast<uint32_t>(data_.size());
+    data_.insert(data_.end(), s.begin(), s.end());
+    data_.push_back('\0');
+    return offset;
+  }
+  [[nodiscard]] const std::vector<char> &Data() const { return data_; }
+
+private:
+  std::vector<char> data_;
+};
+
+} // namespace
+
+namespace elf {
+
+bool ObjectFile::Assemble(std::string_view assem) {
+  while (!assem.empty()) {
+    size_t end = assem.find('\n');
+    std::string_view line = assem.substr(0, end);
+    assem.remove_prefix(end == std::string_view::npos ? assem.size()
+                                                      : end + 1);
+    if (!AssembleLine(line)) {
+      if (error_.empty())
+        error_ = "unsupported line";
+      error_ += ": " + std::string(Trim(line));
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ObjectFile::AssembleLine(std::string_view line) {
+  line = Trim(line);
+  if (line.empty())
+    return true;
+
+  if (line.back() == ':' &&
+      line.find_first_of(" \t\"") == std::string_view::npos) {
+    std::string name(line.substr(0, line.size() - 1));
+    Symbol &symbol = symbols_[name];
+    if (symbol.section_ != UNDEF) {
+      error_ = "symbol defined twice";
+      return false;
+    }
+    symbol.section_ = section_;
+    symbol.value_ = Current().size();
+    return true;
+  }
+
+  size_t space = line.find_first_of(" \t");
+  std::string_view name = line.substr(0, space);
+  std::string_view args =
+      space == std::string_view::npos ? "" : Trim(line.substr(space + 1));
+  if (name[0] == '.')
+    return Directive(name, args);
+
+  if (section_ != TEXT) {
+    error_ = "instruction outside of .text";
+    return false;
+  }
+  return encoder_.Encode(line);
+}
+
+bool ObjectFile::Directive(std::string_view name, std::string_view args) {
+  if (name == ".text") {
+    section_ = TEXT;
+    return true;
+  }
+  if (name == ".section") {
+    section_ = RODATA;
+    return args == ".rodata";
+  }
+  if (name == ".long") {
+    int64_t value;
+    if (!ParseInt(args, value))
+      return false;
+    for (int i = 0; i < 4; i++)
+      Current().push_back(static_cast<uint64_t>(value) >> (i * 8));
+    return true;
+  }
+  if (name == ".string")
+    return DecodeString(args, Current());
+
+  /* the rest take a symbol first */
+  size_t comma = args.find(',');
+  std::string symbol(Trim(args.substr(0, comma)));
+  std::string_view rest =
+      comma == std::string_view::npos ? "" : Trim(args.substr(comma + 1));
+  if (symbol.empty())
+    return false;
+  if (name == ".globl") {
+    symbols_[symbol].global_ = true;
+    return true;
+  }
+  if (name == ".type") {
+    symbols_[symbol].function_ = rest == "@function";
+    return true;
+  }
+  if (name == ".set") {
+    int64_t value;
+    if (!ParseInt(rest, value))
+      return false;
+    constants_[symbol] = value;
+    return true;
+  }
+  if (name == ".size") {
+    /* only `.size f, .-f` */
+    auto found = symbols_.find(symbol);
+    if (rest != ".-" + symbol || found == symbols_.end() ||
+        found->second.section_ != section_)
+      return false;
+    found->second.size_ = Current().size() - found->second.value_;
+    return true;
+  }
+  return false;
+}
+
+bool ObjectFile::Resolve(std::vector<Relocation> &relocations) {
+  /* symbol table: null, section symbols, locals, then globals */
+  int index = 3;
+  for (auto &[name, symbol] : symbols_)
+    if (!symbol.global_ && symbol.section_ != UNDEF)
+      symbol.index_ = index++;
+  for (auto &fixup : fixups_) {
+    Symbol &symbol = symbols_[fixup.symbol_];
+    if (symbol.section_ == UNDEF)
+      symbol.global_ = true;
+  }
+  for (auto &[name, symbol] : symbols_)
+    if (symbol.global_)
+      symbol.index_ = index++;
+
+  for (auto &fixup : fixups_) {
+    const Symbol &symbol = symbols_[fixup.symbol_];
+    if (symbol.section_ == TEXT && !symbol.global_) {
+      /* local label, e.g. a jump target: patch it now */
+      int64_t value = symbol.value_ + fixup.addend_ - fixup.offset_;
+      for (int i = 0; i < 4; i++)
+        text_[fixup.offset_ + i] = static_cast<uint64_t>(value) >> (i * 8);
+    } else if (symbol.section_ == RODATA && !symbol.global_) {
+      relocations.push_back({fixup.offset_, 2, R_X86_64_PC32,
+                             static_cast<int64_t>(symbol.value_) +
+                                 fixup.addend_});
+    } else {
+      relocations.push_back(
+          {fixup.offset_, symbol.index_,
+           fixup.kind_ == Fixup::BRANCH ? static_cast<uint32_t>(R_X86_64_PLT32)
+                                        : static_cast<uint32_t>(R_X86_64_PC32),
+           fixup.addend_});
+    }
+  }
+  return true;
+}
+
+bool ObjectFile::Write(FILE *out) {
+  std::vector<Relocation> relocations;
+  if (!Resolve(relocations))
+    return false;
+
+  StringTable strtab, shstrtab;
+  std::vector<Elf64_Sym> symtab(3);
+  memset(symtab.data(), 0, sizeof(Elf64_Sym) * symtab.size());
+  symtab[1].st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+  symtab[1].st_shndx = TEXT;
+  symtab[2].st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+  symtab[2].st_shndx = RODATA;
+  int first_global = 3;
+  for (int pass = 0; pass < 2; pass++) {
+    for (auto &[name, symbol] : symbols_) {
+      if (symbol.index_ == 0 || symbol.global_ != (pass == 1))
+        continue;
+      Elf64_Sym sym = {};
+      sym.st_name = strtab.Add(name);
+      sym.st_info = ELF64_ST_INFO(symbol.global_ ? STB_GLOBAL : STB_LOCAL,
+                                  symbol.function_ ? STT_FUNC : STT_NOTYPE);
+      sym.st_shndx = symbol.section_;
+      sym.st_value = symbol.value_;
+      sym.st_size = symbol.size_;
+      symtab.push_back(sym);
+    }
+    if (pass == 0)
+      first_global = static_cast<int>(symtab.size());
+  }
+
+  std::vector<Elf64_Rela> rela;
+  for (auto &relocation : relocations) {
+    Elf64_Rela entry = {};
+    entry.r_offset = relocation.offset_;
+    entry.r_info = ELF64_R_INFO(relocation.symbol_, relocation.type_);
+    entry.r_addend = relocation.addend_;
+    rela.push_back(entry);
+  }
+
+  /* sections in file order, after the ELF header */
+  enum { NUL, S_TEXT, S_RODATA, S_RELA, S_SYMTAB, S_STRTAB, S_SHSTRTAB,
+         S_NOTE, SECTION_COUNT };
+  Elf64_Shdr shdrs[SECTION_COUNT] = {};
+  const void *data[SECTION_COUNT] = {};
+  auto set = [&](int i, const char *name, uint32_t type, uint64_t flags,
+                 const void *bytes, uint64_t size, uint64_t align) {
+    shdrs[i].sh_name = shstrtab.Add(name);
+    shdrs[i].sh_type = type;
+    shdrs[i].sh_flags = flags;
+    shdrs[i].sh_size = size;
+    shdrs[i].sh_addralign = align;
+    data[i] = bytes;
+  };
+  set(S_TEXT, ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, text_.data(),
+      text_.size(), 16);
+  set(S_RODATA, ".rodata", SHT_PROGBITS, SHF_ALLOC, rodata_.data(),
+      rodata_.size(), 8);
+  set(S_RELA, ".rela.text", SHT_RELA, SHF_INFO_LINK, rela.data(),
+      rela.size() * sizeof(Elf64_Rela), 8);
+  shdrs[S_RELA].sh_link = S_SYMTAB;
+  shdrs[S_RELA].sh_info = S_TEXT;
+  shdrs[S_RELA].sh_entsize = sizeof(Elf64_Rela);
+  set(S_SYMTAB, ".symtab", SHT_SYMTAB, 0, symtab.data(),
+      symtab.size() * sizeof(Elf64_Sym), 8);
+  shdrs[S_SYMTAB].sh_link = S_STRTAB;
+  shdrs[S_SYMTAB].sh_info = first_global;
+  shdrs[S_SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+  set(S_STRTAB, ".strtab", SHT_STRTAB, 0, strtab.Data().data(),
+      strtab.Data().size(), 1);
+  /* no executable stack needed */
+  set(S_NOTE, ".note.GNU-stack", SHT_PROGBITS, 0, nullptr, 0, 1);
+  /* added last, it holds the names of all sections */
+  set(S_SHSTRTAB, ".shstrtab", SHT_STRTAB, 0, nullptr, 0, 1);
+  shdrs[S_SHSTRTAB].sh_size = shstrtab.Data().size();
+  data[S_SHSTRTAB] = shstrtab.Data().data();
+
+  uint64_t offset = sizeof(Elf64_Ehdr);
+  for (int i = 1; i < SECTION_COUNT; i++) {
+    uint64_t align = shdrs[i].sh_addralign;
+    offset = (offset + align - 1) / align * align;
+    shdrs[i].sh_offset = offset;
+    offset += shdrs[i].sh_size;
+  }
+  uint64_t shoff = (offset + 7) / 8 * 8;
+
+  Elf64_Ehdr ehdr = {};
+  memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+  ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+  ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+  ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+  ehdr.e_type = ET_REL;
+  ehdr.e_machine = EM_X86_64;
+  ehdr.e_version = EV_CURRENT;
+  ehdr.e_shoff = shoff;
+  ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+  ehdr.e_shentsize = sizeof(Elf64_Shdr);
+  ehdr.e_shnum = SECTION_COUNT;
+  ehdr.e_shstrndx = S_SHSTRTAB;
+
+  bool ok = fwrite(&ehdr, sizeof(ehdr), 1, out) == 1;
+  uint64_t written = sizeof(ehdr);
+  static const char kZeros[16] = {};
+  for (int i = 1; i < SECTION_COUNT && ok; i++) {
+    ok = fwrite(kZeros, 1, shdrs[i].sh_offset - written, out) ==
+         shdrs[i].sh_offset - written;
+    if (shdrs[i].sh_size > 0)
+      ok = ok && fwrite(data[i], 1, shdrs[i].sh_size, out) == shdrs[i].sh_size;
+    written = shdrs[i].sh_offset + shdrs[i].sh_size;
+  }
+  ok = ok && fwrite(kZeros, 1, shoff - written, out) == shoff - written;
+  ok = ok && fwrite(shdrs, sizeof(shdrs), 1, out) == 1;
+  if (!ok)
+    error_ = "cannot write object";
+  return ok;
+}
+
+} // namespace elf
@@ -0,0 +1,81 @@
+#ifndef TIGER_ELF_OBJECT_H_
+#define TIGER_ELF_OBJECT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tiger/elf/x64encoder.h"
+
+namespace elf {
+
+/**
+ * An ELF64 relocatable object built from the assembly the compiler emits,
+ * so no external assembler has to run. Besides instructions it knows the
+ * directives of the compiler: .text, .section .rodata, .globl, .type, .set,
+ * .size, .long and .string.
+ */
+class ObjectFile {
+public:
+  ObjectFile() = default;
+  ObjectFile(const ObjectFile &object) = delete;
+  ObjectFile &operator=(const ObjectFile &object) = delete;
+
+  /**
+   * Assemble a piece of assembly text, pieces are appended in order
+   * @return false if some line is not supported, see Error()
+   */
+  bool Assemble(std::string_view assem);
+
+  /**
+   * Resolve labels and write the object
+   * @return false if a label is missing or the object cannot be written
+   */
+  bool Write(FILE *out);
+
+  [[nodiscard]] const std::string &Error() const { return error_; }
+
+private:
+  enum SectionId { UNDEF, TEXT, RODATA };
+
+  struct Symbol {
+    SectionId section_ = UNDEF;
+    uint64_t value_ = 0;
+    uint64_t size_ = 0;
+    bool global_ = false;
+    bool function_ = false;
+    int index_ = 0; // in .symtab
+  };
+
+  struct Relocation {
+    uint64_t offset_;
+    int symbol_;
+    uint32_t type_;
+    int64_t addend_;
+  };
+
+  std::vector<uint8_t> text_;
+  std::vector<uint8_t> rodata_;
+  SectionId section_ = TEXT;
+  /* ordered, so the symbol table does not depend on hashing */
+  std::map<std::string, Symbol> symbols_;
+  std::unordered_map<std::string, int64_t> constants_;
+  std::vector<Fixup> fixups_;
+  X64Encoder encoder_{text_, fixups_, constants_};
+  std::string error_;
+
+  bool AssembleLine(std::string_view line);
+  bool Directive(std::string_view name, std::string_view args);
+  bool Resolve(std::vector<Relocation> &relocations);
+  std::vector<uint8_t> &Current() {
+    return section_ == TEXT ? text_ : rodata_;
+  }
+};
+
+} // namespace elf
+
+#endif // TIGER_ELF_OBJECT_H_
@@ -0,0 +1,356 @@
+#include "tiger/elf/x64encoder.h"
+
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+
+const char *const kRegNames[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp",
+                                 "rsi", "rdi", "r8",  "r9",  "r10", "r11",
+                                 "r12", "r13", "r14", "r15"};
+
+/* second opcode byte of the near jcc forms, 0x0f 0x8? */
+const std::unordered_map<std::string_view, uint8_t> kJccOpcodes = {
+    {"je", 0x84}, {"jne", 0x85}, {"jl", 0x8c},  {"jge", 0x8d},
+    {"jle", 0x8e}, {"jg", 0x8f}, {"jb", 0x82},  {"jae", 0x83},
+    {"jbe", 0x86}, {"ja", 0x87},
+};
+
+/* opcode extension and the MR / RM opcodes of the two-operand ALU forms */
+struct AluOp {
+  int ext_;
+  uint8_t mr_, rm_;
+};
+const std::unordered_map<std::string_view, AluOp> kAluOps = {
+    {"addq", {0, 0x01, 0x03}},
+    {"subq", {5, 0x29, 0x2b}},
+    {"cmpq", {7, 0x39, 0x3b}},
+};
+
+std::string_view Trim(std::string_view s) {
+  while (!s.empty() && isspace(static_cast<unsigned char>(s.front())))
+    s.remove_prefix(1);
+  while (!s.empty() && isspace(static_cast<unsigned char>(s.back())))
+    s.remove_suffix(1);
+  return s;
+}
+
+/* split operands at the commas outside of parentheses */
+std::vector<std::string_view> SplitOperands(std::string_view s) {
+  std::vector<std::string_view> operands;
+  int depth = 0;
+  size_t start = 0;
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '(')
+      depth++;
+    else if (s[i] == ')')
+      depth--;
+    else if (s[i] == ',' && depth == 0) {
+      operands.push_back(Trim(s.substr(start, i - start)));
+      start = i + 1;
+    }
+  }
+  if (!Trim(s.substr(start)).empty())
+    operands.push_back(Trim(s.substr(start)));
+  return operands;
+}
+
+int RegNumber(std::string_view name) {
+  if (name.empty() || name[0] != '%')
+    return -1;
+  name.remove_prefix(1);
+  for (int i = 0; i < 16; i++)
+    if (name == kRegNames[i])
+      return i;
+  return -1;
+}
+
+bool FitsInt8(int64_t value) { return value >= -128 && value <= 127; }
+bool FitsInt32(int64_t value) {
+  return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+/**
+ * Evaluate sums and differences of integers and constants, e.g.
+ * `(f_framesize - 8)`
+ */
+class ExprParser {
+public:
+  ExprParser(std::string_view text,
+             const std::unordered_map<std::string, int64_t> &constants)
+      : text_(text), constants_(constants) {}
+
+  bool Parse(int64_t &value) {
+    return Sum(value) && (Skip(), pos_ == text_.size());
+  }
+
+private:
+  std::string_view text_;
+  const std::unordered_map<std::string, int64_t> &constants_;
+  size_t pos_ = 0;
+
+  void Skip() {
+    while (pos_ < text_.size() && isspace(static_cast<unsigned char>(text_[pos_])))
+      pos_++;
+  }
+
+  bool Sum(int64_t &value) {
+    if (!Term(value))
+      return false;
+    for (Skip(); pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-');
+         Skip()) {
+      char op = text_[pos_++];
+      int64_t rhs;
+      if (!Term(rhs))
+        return false;
+      value = op == '+' ? value + rhs : value - rhs;
+    }
+    return true;
+  }
+
+  bool Term(int64_t &value) {
+    Skip();
+    if (pos_ >= text_.size())
+      return false;
+    char ch = text_[pos_];
+    if (ch == '-') {
+      pos_++;
+      if (!Term(value))
+        return false;
+      value = -value;
+      return true;
+    }
+    if (ch == '(') {
+      pos_++;
+      if (!Sum(value))
+        return false;
+      Skip();
+      return pos_ < text_.size() && text_[pos_++] == ')';
+    }
+    size_t start = pos_;
+    while (pos_ < text_.size() &&
+           (isalnum(static_cast<unsigned char>(text_[pos_])) ||
+            text_[pos_] == '_' || text_[pos_] == '.'))
+      pos_++;
+    std::string_view token = text_.substr(start, pos_ - start);
+    if (token.empty())
+      return false;
+    if (isdigit(static_cast<unsigned char>(token[0]))) {
+      char *end;
+      std::string digits(token);
+      value = strtoll(digits.data(), &end, 0);
+      return *end == '\0';
+    }
+    auto constant = constants_.find(std::string(token));
+    if (constant == constants_.end())
+      return false;
+    value = constant->second;
+    return true;
+  }
+};
+
+} // namespace
+
+namespace elf {
+
+bool X64Encoder::Encode(std::string_view instr) {
+  instr = Trim(instr);
+  size_t space = instr.find_first_of(" \t");
+  std::string_view mnemonic = instr.substr(0, space);
+  std::vector<Operand> ops;
+  if (space != std::string_view::npos) {
+    for (auto text : SplitOperands(instr.substr(space + 1))) {
+      ops.emplace_back();
+      if (!Parse(text, ops.back()))
+        return false;
+    }
+  }
+
+  if (mnemonic == "retq" && ops.empty()) {
+    Emit8(0xc3);
+    return true;
+  }
+  if (mnemonic == "cqto" && ops.empty()) {
+    Emit8(0x48);
+    Emit8(0x99);
+    return true;
+  }
+
+  if (ops.size() == 1 && ops[0].kind_ == Operand::SYM) {
+    auto jcc = kJccOpcodes.find(mnemonic);
+    if (mnemonic == "jmp") {
+      Emit8(0xe9);
+    } else if (mnemonic == "callq") {
+      Emit8(0xe8);
+    } else if (jcc != kJccOpcodes.end()) {
+      Emit8(0x0f);
+      Emit8(jcc->second);
+    } else {
+      return false;
+    }
+    EmitBranch(ops[0]);
+    return true;
+  }
+
+  if (ops.size() == 1 &&
+      (ops[0].kind_ == Operand::REG || ops[0].kind_ == Operand::MEM)) {
+    if (mnemonic == "imulq")
+      EmitOp(0xf7, 5, ops[0]);
+    else if (mnemonic == "idivq")
+      EmitOp(0xf7, 7, ops[0]);
+    else
+      return false;
+    return true;
+  }
+
+  if (ops.size() != 2)
+    return false;
+  const Operand &src = ops[0], &dst = ops[1];
+  bool dst_rm = dst.kind_ == Operand::REG || dst.kind_ == Operand::MEM;
+  if (!dst_rm || (src.kind_ == Operand::MEM && dst.kind_ == Operand::MEM))
+    return false;
+
+  if (mnemonic == "movq") {
+    if (src.kind_ == Operand::REG) {
+      EmitOp(0x89, src.reg_, dst);
+    } else if (src.kind_ == Operand::MEM) {
+      EmitOp(0x8b, dst.reg_, src);
+    } else if (src.kind_ == Operand::IMM && FitsInt32(src.value_)) {
+      EmitOp(0xc7, 0, dst);
+      Emit32(src.value_);
+      if (dst.kind_ == Operand::MEM && dst.rip_)
+        fixups_.back().addend_ -= 4;
+    } else if (src.kind_ == Operand::IMM && dst.kind_ == Operand::REG) {
+      /* movabs */
+      EmitRex(0, dst.reg_);
+      Emit8(0xb8 + (dst.reg_ & 7));
+      for (int i = 0; i < 8; i++)
+        Emit8(static_cast<uint64_t>(src.value_) >> (i * 8));
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  if (mnemonic == "leaq") {
+    if (src.kind_ != Operand::MEM || dst.kind_ != Operand::REG)
+      return false;
+    EmitOp(0x8d, dst.reg_, src);
+    return true;
+  }
+
+  auto alu = kAluOps.find(mnemonic);
+  if (alu == kAluOps.end())
+    return false;
+  if (src.kind_ == Operand::REG) {
+    EmitOp(alu->second.mr_, src.reg_, dst);
+  } else if (src.kind_ == Operand::MEM) {
+    EmitOp(alu->second.rm_, dst.reg_, src);
+  } else if (src.kind_ == Operand::IMM && FitsInt32(src.value_)) {
+    bool short_imm = FitsInt8(src.value_);
+    EmitOp(short_imm ? 0x83 : 0x81, alu->second.ext_, dst);
+    if (short_imm)
+      Emit8(src.value_);
+    else
+      Emit32(src.value_);
+    if (dst.kind_ == Operand::MEM && dst.rip_)
+      fixups_.back().addend_ -= short_imm ? 1 : 4;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool X64Encoder::Parse(std::string_view text, Operand &operand) const {
+  if (text.empty())
+    return false;
+  if (text[0] == '%') {
+    operand.kind_ = Operand::REG;
+    operand.reg_ = RegNumber(text);
+    return operand.reg_ >= 0;
+  }
+  if (text[0] == '$') {
+    operand.kind_ = Operand::IMM;
+    return Evaluate(text.substr(1), operand.value_);
+  }
+  if (text.back() == ')') {
+    /* the base is the last parenthesized part, the rest is displacement */
+    size_t open = text.rfind('(');
+    std::string_view base = text.substr(open + 1, text.size() - open - 2);
+    std::string_view disp = Trim(text.substr(0, open));
+    if (!base.empty() && base[0] == '%') {
+      operand.kind_ = Operand::MEM;
+      if (base == "%rip") {
+        operand.rip_ = true;
+        operand.symbol_ = std::string(disp);
+        return !disp.empty();
+      }
+      operand.reg_ = RegNumber(base);
+      if (operand.reg_ < 0)
+        return false;
+      operand.value_ = 0;
+      return disp.empty() || Evaluate(disp, operand.value_);
+    }
+  }
+  operand.kind_ = Operand::SYM;
+  operand.symbol_ = std::string(text);
+  return true;
+}
+
+bool X64Encoder::Evaluate(std::string_view expr, int64_t &value) const {
+  return ExprParser(expr, constants_).Parse(value);
+}
+
+void X64Encoder::Emit32(int64_t value) {
+  for (int i = 0; i < 4; i++)
+    Emit8(static_cast<uint64_t>(value) >> (i * 8));
+}
+
+void X64Encoder::EmitRex(int reg, int rm) {
+  Emit8(0x48 | ((reg >> 3) & 1) << 2 | ((rm >> 3) & 1));
+}
+
+void X64Encoder::EmitModRm(int reg, const Operand &rm) {
+  reg &= 7;
+  if (rm.kind_ == Operand::REG) {
+    Emit8(0xc0 | reg << 3 | (rm.reg_ & 7));
+    return;
+  }
+  if (rm.rip_) {
+    Emit8(reg << 3 | 5);
+    fixups_.push_back({Fixup::PC_RELATIVE, code_.size(), rm.symbol_});
+    Emit32(0);
+    return;
+  }
+
+  int base = rm.reg_ & 7;
+  int mod;
+  /* [rbp] and [r13] have no form without displacement */
+  if (rm.value_ == 0 && base != 5)
+    mod = 0;
+  else if (FitsInt8(rm.value_))
+    mod = 1;
+  else
+    mod = 2;
+  Emit8(mod << 6 | reg << 3 | base);
+  /* [rsp] and [r12] need a SIB byte */
+  if (base == 4)
+    Emit8(0x24);
+  if (mod == 1)
+    Emit8(rm.value_);
+  else if (mod == 2)
+    Emit32(rm.value_);
+}
+
+void X64Encoder::EmitOp(uint8_t opcode, int reg, const Operand &rm) {
+  EmitRex(reg, rm.rip_ ? 0 : rm.reg_);
+  Emit8(opcode);
+  EmitModRm(reg, rm);
+}
+
+void X64Encoder::EmitBranch(const Operand &target) {
+  fixups_.push_back({Fixup::BRANCH, code_.size(), target.symbol_});
+  Emit32(0);
+}
+
+} // namespace elf
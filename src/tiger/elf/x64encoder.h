@@ -0,0 +1,82 @@
+#ifndef TIGER_ELF_X64ENCODER_H_
+#define TIGER_ELF_X64ENCODER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace elf {
+
+/**
+ * A 32-bit field of the code which refers to a symbol. It is patched once
+ * the symbol is placed, or turned into a relocation if it is not.
+ */
+struct Fixup {
+  enum Kind {
+    BRANCH,      // target of a call or jump
+    PC_RELATIVE, // %rip-relative memory operand
+  };
+
+  Kind kind_;
+  uint64_t offset_; // of the field in the code
+  std::string symbol_;
+  /* the field holds symbol + addend - address of the field */
+  int64_t addend_ = -4;
+};
+
+/**
+ * Encoder of the x86-64 instructions the code generator makes, in the AT&T
+ * syntax they are printed with: movq, leaq, addq, subq, imulq, idivq, cqto,
+ * cmpq, jcc, jmp, callq and retq over 64-bit registers, immediates and
+ * `disp(%reg)` memory operands
+ */
+class X64Encoder {
+public:
+  /**
+   * @param code where the instructions are appended
+   * @param fixups where references to symbols are recorded
+   * @param constants symbols defined by `.set`, e.g. `<fn>_framesize`
+   */
+  X64Encoder(std::vector<uint8_t> &code, std::vector<Fixup> &fixups,
+             const std::unordered_map<std::string, int64_t> &constants)
+      : code_(code), fixups_(fixups), constants_(constants) {}
+
+  /**
+   * Encode one instruction
+   * @param instr instruction text without leading blanks
+   * @return false if the instruction is not supported
+   */
+  bool Encode(std::string_view instr);
+
+private:
+  struct Operand {
+    enum Kind { REG, IMM, MEM, SYM } kind_;
+    int reg_ = 0;       // REG, or base of MEM
+    int64_t value_ = 0; // IMM, or displacement of MEM
+    bool rip_ = false;  // MEM relative to %rip
+    std::string symbol_;
+  };
+
+  std::vector<uint8_t> &code_;
+  std::vector<Fixup> &fixups_;
+  const std::unordered_map<std::string, int64_t> &constants_;
+
+  bool Parse(std::string_view text, Operand &operand) const;
+  bool Evaluate(std::string_view expr, int64_t &value) const;
+
+  void Emit8(uint8_t byte) { code_.push_back(byte); }
+  void Emit32(int64_t value);
+  void EmitRex(int reg, int rm);
+  /* ModRM (and SIB and displacement) of a register or memory operand */
+  void EmitModRm(int reg, const Operand &rm);
+  /* opcode with a register or memory r/m operand, REX.W prefixed */
+  void EmitOp(uint8_t opcode, int reg, const Operand &rm);
+  /* rel32 field of a call or jump */
+  void EmitBranch(const Operand &target);
+};
+
+} // namespace elf
+
+#endif // TIGER_ELF_X64ENCODER_H_
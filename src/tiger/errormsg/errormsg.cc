@@ -3,6 +3,8 @@
 #include <cstdarg>
 #include <cstdio>
 
+#include "tiger/context/context.h"
+
 namespace err {
 
 void ErrorMsg::Newline() {
@@ -24,15 +26,19 @@ void ErrorMsg::Error(int pos, std::string_view message, ...) {
     num--;
   }
 
-  // Output error message
+  // Output error message, in one piece even if programs compile in parallel
+  ctx::CompilerContext *context = ctx::CompilerContext::Current();
+  FILE *out = context ? context->GetDiagnostics() : stderr;
+  flockfile(out);
   if (!file_name_.empty())
-    fprintf(stderr, "%s:", file_name_.data());
+    fprintf(out, "%s:", file_name_.data());
   if (val != -1)
-    fprintf(stderr, "%d.%d: ", num, pos - val);
+    fprintf(out, "%d.%d: ", num, pos - val);
   va_start(ap, message);
-  vfprintf(stderr, message.data(), ap);
+  vfprintf(out, message.data(), ap);
   va_end(ap);
-  fprintf(stderr, "\n");
+  fprintf(out, "\n");
+  funlockfile(out);
 }
 
 } // namespace err
@@ -8,7 +8,12 @@
 #include "tiger/frame/temp.h"
 #include "tiger/translate/tree.h"
 #include "tiger/codegen/assem.h"
+#include "tiger/util/arena.h"
 
+// Forward Declarations
+namespace ctx {
+class CompilerContext;
+} // namespace ctx
 
 namespace frame {
 
@@ -26,6 +31,13 @@ public:
    */
   [[nodiscard]] virtual temp::TempList *Registers() const = 0;
 
+  /**
+   * Registers() as a set, for membership tests and picking colors
+   */
+  [[nodiscard]] const temp::TempSet &RegisterSet() const {
+    return register_set_;
+  }
+
   /**
    * Get registers which can be used to hold arguments
    * NOTE: returned temp list must be in the order of calling convention
@@ -67,6 +79,7 @@ public:
   temp::Map *temp_map_;
 protected:
   std::vector<temp::Temp *> regs_;
+  temp::TempSet register_set_{std::pmr::new_delete_resource()};
 };
 
 class Access {
@@ -81,8 +94,15 @@ class Frame {
 
 public:
 
+  explicit Frame(ctx::CompilerContext *context) : context_(context) {}
   virtual ~Frame() {}
 
+  /* the compilation this frame belongs to */
+  [[nodiscard]] ctx::CompilerContext *Context() const { return context_; }
+
+  /* numbers the temps of the procedure, see temp::TempFactory::Scope */
+  [[nodiscard]] temp::TempFactory *Temps() { return &temps_; }
+
   [[nodiscard]] virtual uint32_t Size() const = 0;
 
   [[nodiscard]] virtual std::list<Access*> &Formals() = 0;
@@ -95,6 +115,12 @@ public:
 
   virtual void AllocStackArg(RegManager *rm) = 0;
 
+  /* formals, size and outgoing args as text, for the assembly cache key */
+  [[nodiscard]] virtual std::string Layout() const = 0;
+
+protected:
+  ctx::CompilerContext *context_;
+  temp::TempFactory temps_{temp::TempFactory::NextGlobalId()};
 };
 
 /*
@@ -120,12 +146,13 @@ public:
 */
 
 /* create a new X64Frame: pre-do Prologue_4 */
-Frame *NewFrame(temp::Label *name, std::list<bool> formals);
+Frame *NewFrame(ctx::CompilerContext *context, temp::Label *name,
+               std::list<bool> formals);
 
 /* do Prologue_4 & 5 & Epilogue_8 (stm include Body_6 & Epilogue_7) */
 tree::Stm *ProcEntryExit1(Frame *frame, tree::Stm *stm);
 
-assem::InstrList *ProcEntryExit2(assem::InstrList *body);
+assem::InstrList *ProcEntryExit2(Frame *frame, assem::InstrList *body);
 
 assem::Proc *ProcEntryExit3(frame::Frame *frame, assem::InstrList *body);
 
@@ -149,9 +176,10 @@ public:
 
   /**
    *Generate assembly for main program
-   * @param out FILE object for output assembly file
+   * @param out writer of the output assembly
    */
-  virtual void OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const = 0;
+  virtual void OutputAssem(output::AsmWriter &out, OutputPhase phase,
+                           bool need_ra) const = 0;
 };
 
 class StringFrag : public Frag {
@@ -162,22 +190,39 @@ public:
   StringFrag(temp::Label *label, std::string str)
       : label_(label), str_(std::move(str)) {}
 
-  void OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const override;
+  void OutputAssem(output::AsmWriter &out, OutputPhase phase,
+                   bool need_ra) const override;
 };
 
+/**
+ * A function body. The tree of the body and everything the backend makes
+ * from it live in the arena of the fragment, which is released once the
+ * assembly is written, so the body can only be output once.
+ */
 class ProcFrag : public Frag {
 public:
   tree::Stm *body_;
   Frame *frame_;
 
-  ProcFrag(tree::Stm *body, Frame *frame) : body_(body), frame_(frame) {}
+  ProcFrag(tree::Stm *body, Frame *frame, std::unique_ptr<util::Arena> arena)
+      : body_(body), frame_(frame), arena_(std::move(arena)) {}
 
-  void OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const override;
+  void OutputAssem(output::AsmWriter &out, OutputPhase phase,
+                   bool need_ra) const override;
+
+private:
+  mutable std::unique_ptr<util::Arena> arena_;
 };
 
 class Frags {
 public:
   Frags() = default;
+  Frags(const Frags &frags) = delete;
+  Frags &operator=(const Frags &frags) = delete;
+  ~Frags() {
+    for (auto frag : frags_)
+      delete frag;
+  }
   void PushBack(Frag *frag) { frags_.emplace_back(frag); }
   const std::list<Frag*> &GetList() { return frags_; }
 
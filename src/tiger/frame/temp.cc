@@ -1,20 +1,35 @@
 #include "tiger/frame/temp.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cstdio>
-#include <set>
-#include <sstream>
+#include <cstring>
+#include <string>
+
+#include "tiger/context/context.h"
 
 namespace temp {
 
 LabelFactory LabelFactory::label_factory;
 TempFactory TempFactory::temp_factory;
+thread_local LabelFactory::Scope *LabelFactory::scope_ = nullptr;
+thread_local TempFactory::Scope *TempFactory::scope_ = nullptr;
 
 Label *LabelFactory::NewLabel() {
-  char buf[100];
-  sprintf(buf, "L%d", label_factory.label_id_++);
-  return NamedLabel(std::string(buf));
+  /* named `L<scope>_<n>` or `L<n>` only once printed */
+  if (scope_)
+    return sym::Symbol::AnonymousSymbol(scope_->scope_id_,
+                                        scope_->label_id_++);
+  return sym::Symbol::AnonymousSymbol(-1, Active().label_id_++);
+}
+
+LabelFactory::Scope::Scope(int scope_id)
+    : scope_id_(scope_id), prev_(LabelFactory::scope_) {
+  LabelFactory::scope_ = this;
 }
 
+LabelFactory::Scope::~Scope() { LabelFactory::scope_ = prev_; }
+
 /**
  * Get symbol of a label_. The label_ will be created only if it is not found.
  * @param s label_ string
@@ -24,69 +39,135 @@ Label *LabelFactory::NamedLabel(std::string_view s) {
   return sym::Symbol::UniqueSymbol(s);
 }
 
-std::string LabelFactory::LabelString(Label *s) { return s->Name(); }
+std::string LabelFactory::LabelString(Label *s) {
+  return std::string(s->Name());
+}
+
+bool LabelFactory::IsAnonymous(std::string_view name) {
+  /* L<n> or L<scope>_<n> */
+  if (name.size() < 2 || name[0] != 'L')
+    return false;
+  bool digit_before = false, underscore = false;
+  for (size_t i = 1; i < name.size(); i++) {
+    if (isdigit(static_cast<unsigned char>(name[i]))) {
+      digit_before = true;
+    } else if (name[i] == '_' && digit_before && !underscore) {
+      underscore = true;
+      digit_before = false;
+    } else {
+      return false;
+    }
+  }
+  return digit_before;
+}
+
+int LabelFactory::NextLabelNumber() {
+  return scope_ ? scope_->label_id_ : Active().label_id_.load();
+}
+
+LabelFactory &LabelFactory::Active() {
+  ctx::CompilerContext *context = ctx::CompilerContext::Current();
+  return context ? *context->GetLabelFactory() : label_factory;
+}
 
 Temp *TempFactory::NewTemp() {
-  Temp *p = new Temp(temp_factory.temp_id_++);
-  std::stringstream stream;
-  stream << 't';
-  stream << p->num_;
-  Map::Name()->Enter(p, new std::string(stream.str()));
+  TempFactory &factory = scope_ ? *scope_->factory_ : Active();
+  return new Temp(factory.temp_id_++);
+}
+
+int TempFactory::NextGlobalId() { return temp_factory.temp_id_; }
 
-  return p;
+TempFactory::Scope::Scope(TempFactory *factory)
+    : factory_(factory), prev_(TempFactory::scope_) {
+  TempFactory::scope_ = this;
 }
 
-int Temp::Int() const { return num_; }
+TempFactory::Scope::~Scope() { TempFactory::scope_ = prev_; }
+
+TempFactory &TempFactory::Active() {
+  ctx::CompilerContext *context = ctx::CompilerContext::Current();
+  return context ? *context->GetTempFactory() : temp_factory;
+}
 
-Map *Map::Empty() { return new Map(); }
+Map *Map::Empty() { return new Map(Resource(), false); }
 
 Map *Map::Name() {
-  static Map *m = nullptr;
-  if (!m)
-    m = Empty();
-  return m;
+  /* outside of any arena, every procedure and thread names temps here */
+  static Map names(std::pmr::new_delete_resource(), true);
+  return &names;
 }
 
 Map *Map::LayerMap(Map *over, Map *under) {
   if (over == nullptr)
     return under;
-  else
-    return new Map(over->tab_, LayerMap(over->under_, under));
+  /* Name() has an entry for every temp, nothing below it is reached */
+  if (over->naming_)
+    return over;
+  auto layered = new Map(Resource(), false);
+  if (over->under_) {
+    layered->under_ = over->under_;
+  } else if (under && under->naming_) {
+    layered->under_ = under;
+  } else if (under) {
+    layered->Overlay(under);
+    layered->under_ = under->under_;
+  }
+  layered->Overlay(over);
+  return layered;
 }
 
 void Map::Enter(Temp *t, std::string *s) {
-  assert(tab_);
-  tab_->Enter(t, s);
+  assert(!naming_);
+  size_t id = t->Int();
+  if (id >= strings_.size())
+    strings_.resize(id + 1, nullptr);
+  strings_[id] = s;
 }
 
 std::string *Map::Look(Temp *t) {
-  std::string *s;
-  assert(tab_);
-  s = tab_->Look(t);
-  if (s)
-    return s;
+  if (naming_)
+    return Named(t);
+  size_t id = t->Int();
+  if (id < strings_.size() && strings_[id])
+    return strings_[id];
   else if (under_)
     return under_->Look(t);
   else
     return nullptr;
 }
 
+std::string *Map::Named(Temp *t) {
+  /* temps are printed concurrently by the parallel backend */
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> guard(mutex);
+  size_t id = t->Int();
+  if (id >= strings_.size())
+    strings_.resize(id + 1, nullptr);
+  if (!strings_[id])
+    strings_[id] = new std::string("t" + std::to_string(id));
+  return strings_[id];
+}
+
+void Map::Overlay(const Map *map) {
+  if (map->strings_.size() > strings_.size())
+    strings_.resize(map->strings_.size(), nullptr);
+  for (size_t id = 0; id < map->strings_.size(); id++) {
+    if (map->strings_[id])
+      strings_[id] = map->strings_[id];
+  }
+}
+
 void Map::DumpMap(FILE *out) {
-  tab_->Dump([out](temp::Temp *t, std::string *r) {
-    fprintf(out, "t%d -> %s\n", t->Int(), r->data());
-  });
+  for (size_t id = 0; id < strings_.size(); id++) {
+    if (strings_[id])
+      fprintf(out, "t%zu -> %s\n", id, strings_[id]->data());
+  }
   if (under_) {
     fprintf(out, "---------\n");
     under_->DumpMap(out);
   }
 }
 
-bool TempList::IsEquivalent(TempList *other) const {
-  std::set<Temp*> selfSet(temp_list_.begin(), temp_list_.end());
-  std::set<Temp*> otherSet(other->temp_list_.begin(), other->temp_list_.end());
-  return selfSet == otherSet;
-}
-
 void TempList::CatList(TempList *other) {
   if (!other || other->GetList().empty()) return;
   temp_list_.insert(temp_list_.end(), 
@@ -100,37 +181,94 @@ bool TempList::Contain(Temp *target) const {
   return false;
 }
 
-TempList *TempList::Union(TempList *tl) {
-  auto res = new TempList();
-  res->CatList(this);
-  for (auto t : tl->GetList()) {
-    if (!Contain(t)) res->Append(t);
+void TempList::Replace(Temp *before, Temp *after) {
+  auto itr = temp_list_.begin();
+  while (itr != temp_list_.end()) {
+    if (*itr == before) *itr = after;
+    itr++;
   }
-  return res;
 }
 
-TempList *TempList::Diff(TempList *tl) {
-  auto res = new TempList();
-  for (auto temp : temp_list_) {
-    if (!tl->Contain(temp))
-      res->temp_list_.push_back(temp);
-  }
-  return res;
+TempSet::TempSet(TempSpan temps, std::pmr::memory_resource *resource)
+    : temps_(resource) {
+  temps_.Resize(static_cast<uint32_t>(temps.Size()));
+  std::copy(temps.begin(), temps.end(), temps_.begin());
+  std::sort(temps_.begin(), temps_.end(),
+            [](Temp *a, Temp *b) { return a->Int() < b->Int(); });
+  temps_.Resize(std::unique(temps_.begin(), temps_.end()) - temps_.begin());
+}
+
+uint32_t TempSet::LowerBound(Temp *t) const {
+  return std::lower_bound(temps_.begin(), temps_.end(), t,
+                          [](Temp *a, Temp *b) { return a->Int() < b->Int(); }) -
+         temps_.begin();
+}
+
+bool TempSet::Contain(Temp *t) const {
+  uint32_t pos = LowerBound(t);
+  return pos < temps_.Size() && temps_[pos] == t;
 }
 
-void TempList::UnionWith(TempList *tl) {
-  for (auto t : tl->temp_list_) {
-    if (!Contain(t))
-      temp_list_.push_back(t);
+bool TempSet::Insert(Temp *t) {
+  uint32_t pos = LowerBound(t);
+  if (pos < temps_.Size() && temps_[pos] == t)
+    return false;
+  temps_.Insert(pos, t);
+  return true;
+}
+
+bool TempSet::Erase(Temp *t) {
+  uint32_t pos = LowerBound(t);
+  if (pos == temps_.Size() || temps_[pos] != t)
+    return false;
+  temps_.Erase(pos);
+  return true;
+}
+
+void TempSet::UnionWith(const TempSet &other) {
+  uint32_t size = temps_.Size(), other_size = other.temps_.Size();
+  if (other_size == 0)
+    return;
+  /* merge from the back into the grown vector, then close the gap the
+   * temps in both sets leave at its front */
+  temps_.Resize(size + other_size);
+  Temp **data = temps_.Data();
+  Temp *const *theirs = other.temps_.Data();
+  uint32_t i = size, j = other_size, k = size + other_size;
+  while (j > 0) {
+    if (i > 0 && data[i - 1]->Int() >= theirs[j - 1]->Int()) {
+      if (data[i - 1] == theirs[j - 1])
+        j--;
+      data[--k] = data[--i];
+    } else {
+      data[--k] = theirs[--j];
+    }
+  }
+  /* the rest of ours is in place already if nothing was shared */
+  if (k > i) {
+    memmove(data + i, data + k, (size + other_size - k) * sizeof(Temp *));
+    temps_.Resize(size + other_size - (k - i));
   }
 }
 
-void TempList::Replace(Temp *before, Temp *after) {
-  auto itr = temp_list_.begin();
-  while (itr != temp_list_.end()) {
-    if (*itr == before) *itr = after;
-    itr++;
+void TempSet::DiffWith(const TempSet &other) {
+  uint32_t size = temps_.Size(), other_size = other.temps_.Size();
+  Temp **data = temps_.Data();
+  Temp *const *theirs = other.temps_.Data();
+  uint32_t kept = 0, j = 0;
+  for (uint32_t i = 0; i < size; i++) {
+    while (j < other_size && theirs[j]->Int() < data[i]->Int())
+      j++;
+    if (j < other_size && theirs[j] == data[i])
+      continue;
+    data[kept++] = data[i];
   }
+  temps_.Resize(kept);
+}
+
+bool TempSet::operator==(const TempSet &other) const {
+  return temps_.Size() == other.temps_.Size() &&
+         std::equal(temps_.begin(), temps_.end(), other.temps_.begin());
 }
 
 } // namespace temp
\ No newline at end of file
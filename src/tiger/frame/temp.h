@@ -2,29 +2,72 @@
 #define TIGER_FRAME_TEMP_H_
 
 #include "tiger/symbol/symbol.h"
+#include "tiger/util/arena.h"
+#include "tiger/util/small_vector.h"
 
+#include <algorithm>
+#include <atomic>
 #include <list>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
 
 namespace temp {
 
 using Label = sym::Symbol;
 
+/**
+ * Label and temp factories are owned by the compiler context; their static
+ * methods work on the factory of the current context, or on a process-wide
+ * one outside of any compilation
+ */
 class LabelFactory {
 public:
+  LabelFactory() = default;
+  LabelFactory(const LabelFactory &factory) = delete;
+  LabelFactory &operator=(const LabelFactory &factory) = delete;
+
   static Label *NewLabel();
   static Label *NamedLabel(std::string_view name);
   static std::string LabelString(Label *s);
+  /* whether a label name is one made by NewLabel() */
+  static bool IsAnonymous(std::string_view name);
+  /* number the next label made by NewLabel() on this thread gets */
+  static int NextLabelNumber();
+
+  /**
+   * While a scope is alive, anonymous labels created by the current thread
+   * are numbered inside the scope as `L<scope>_<n>`, so their names do not
+   * depend on how fragments are scheduled among threads
+   */
+  class Scope {
+    friend class LabelFactory;
+
+  public:
+    explicit Scope(int scope_id);
+    Scope(const Scope &scope) = delete;
+    Scope &operator=(const Scope &scope) = delete;
+    ~Scope();
+
+  private:
+    int scope_id_;
+    int label_id_ = 0;
+    Scope *prev_;
+  };
 
 private:
-  int label_id_ = 0;
+  std::atomic<int> label_id_{0};
   static LabelFactory label_factory;
+  static thread_local Scope *scope_;
+
+  static LabelFactory &Active();
 };
 
-class Temp {
+class Temp : public util::ProcObject {
   friend class TempFactory;
 
 public:
-  [[nodiscard]] int Int() const;
+  [[nodiscard]] int Int() const { return num_; }
 
 private:
   int num_;
@@ -33,56 +76,172 @@ private:
 
 class TempFactory {
 public:
+  constexpr explicit TempFactory(int first_id = 100) : temp_id_(first_id) {}
+  TempFactory(const TempFactory &factory) = delete;
+  TempFactory &operator=(const TempFactory &factory) = delete;
+
+  /* named `t<n>` only once printed */
   static Temp *NewTemp();
 
+  /**
+   * Next id of the process-wide factory. Other factories start numbering
+   * here, so their temps never share an id with the machine registers made
+   * at startup.
+   */
+  static int NextGlobalId();
+
+  /**
+   * While a scope is alive, temps created by the current thread are numbered
+   * by the given factory, the one of the frame they belong to. Ids are then
+   * dense inside a procedure, and maps indexed by them stay small.
+   */
+  class Scope {
+    friend class TempFactory;
+
+  public:
+    explicit Scope(TempFactory *factory);
+    Scope(const Scope &scope) = delete;
+    Scope &operator=(const Scope &scope) = delete;
+    ~Scope();
+
+  private:
+    TempFactory *factory_;
+    Scope *prev_;
+  };
+
 private:
-  int temp_id_ = 100;
+  std::atomic<int> temp_id_;
   static TempFactory temp_factory;
+  static thread_local Scope *scope_;
+
+  static TempFactory &Active();
 };
 
-class Map {
+/**
+ * Map from temps to strings, a vector indexed by the id of the temp. Like
+ * the temps, maps made inside a procedure live in its arena.
+ */
+class Map : public util::ProcObject {
 public:
   void Enter(Temp *t, std::string *s);
   std::string *Look(Temp *t);
   void DumpMap(FILE *out);
 
   static Map *Empty();
+  /* names `t<n>` of all temps, made when first looked up by any thread */
   static Map *Name();
+  /* entries of over hide those of under, both are copied into the result */
   static Map *LayerMap(Map *over, Map *under);
 
 private:
-  tab::Table<Temp, std::string> *tab_;
-  Map *under_;
+  std::pmr::vector<std::string *> strings_;
+  /* looked up for temps without an entry, only ever Name() */
+  Map *under_ = nullptr;
+  /* whether this is Name(), whose entries are made on demand */
+  bool naming_ = false;
 
-  Map() : tab_(new tab::Table<Temp, std::string>()), under_(nullptr) {}
-  Map(tab::Table<Temp, std::string> *tab, Map *under)
-      : tab_(tab), under_(under) {}
+  Map(std::pmr::memory_resource *resource, bool naming)
+      : strings_(resource), naming_(naming) {}
+
+  std::string *Named(Temp *t);
+  void Overlay(const Map *map);
 };
 
-class TempList {
+class TempList : public util::ProcObject {
 public:
-  explicit TempList(Temp *t) : temp_list_({t}) {}
+  explicit TempList(Temp *t) : temp_list_({t}, Resource()) {}
   /* for copy-construct */
-  explicit TempList(TempList *other) : temp_list_(other->temp_list_) {}
-  TempList(std::initializer_list<Temp *> list) : temp_list_(list) {}
+  explicit TempList(TempList *other)
+      : temp_list_(other->temp_list_, Resource()) {}
+  TempList(std::initializer_list<Temp *> list)
+      : temp_list_(list, Resource()) {}
   TempList() = default;
-  /* for compare elements without order */
-  bool IsEquivalent(TempList *other) const ;
   void CatList(TempList *other);
   bool Contain(Temp *target) const ;
-  TempList *Union(TempList *tl);
-  TempList *Diff(TempList *tl);
-  void UnionWith(TempList *tl);
   void Append(Temp *t) { temp_list_.push_back(t); }
-  void Delete(Temp *t) { temp_list_.remove(t); }
+  void Delete(Temp *t) {
+    temp_list_.erase(std::remove(temp_list_.begin(), temp_list_.end(), t),
+                     temp_list_.end());
+  }
   bool Empty() const { return temp_list_.empty(); }
   Temp *GetOne() const { return temp_list_.front(); }
   void Replace(Temp *before, Temp *after);
   [[nodiscard]] Temp *NthTemp(int i) const;
-  [[nodiscard]] const std::list<Temp *> &GetList() const { return temp_list_; }
+  [[nodiscard]] const std::pmr::vector<Temp *> &GetList() const {
+    return temp_list_;
+  }
 
 private:
-  std::list<Temp *> temp_list_;
+  std::pmr::vector<Temp *> temp_list_{Resource()};
+};
+
+/**
+ * Temps stored contiguously elsewhere, e.g. the operands of an instruction,
+ * viewed without copying them. The default span is empty.
+ */
+class TempSpan {
+public:
+  constexpr TempSpan() = default;
+  /* the temps of a list, empty for nullptr */
+  explicit TempSpan(const TempList *list)
+      : begin_(list ? list->GetList().data() : nullptr),
+        end_(list ? list->GetList().data() + list->GetList().size()
+                  : nullptr) {}
+
+  [[nodiscard]] Temp *const *begin() const { return begin_; }
+  [[nodiscard]] Temp *const *end() const { return end_; }
+  [[nodiscard]] bool Empty() const { return begin_ == end_; }
+  [[nodiscard]] size_t Size() const { return end_ - begin_; }
+  Temp *operator[](size_t i) const { return begin_[i]; }
+  [[nodiscard]] bool Contain(Temp *t) const {
+    return std::find(begin_, end_, t) != end_;
+  }
+
+private:
+  Temp *const *begin_ = nullptr;
+  Temp *const *end_ = nullptr;
+};
+
+/**
+ * Set of temps in a vector sorted by id, the first few of them inline.
+ * Union and difference merge the sorted vectors in place in linear time,
+ * membership is a binary search and equality a comparison of the vectors;
+ * none of them allocates beyond growing the vector.
+ */
+class TempSet {
+public:
+  explicit TempSet(
+      std::pmr::memory_resource *resource = util::ProcObject::Resource())
+      : temps_(resource) {}
+  /* the temps of a span, without their order and duplicates */
+  explicit TempSet(TempSpan temps, std::pmr::memory_resource *resource =
+                                       util::ProcObject::Resource());
+  explicit TempSet(const TempList *list, std::pmr::memory_resource *resource =
+                                             util::ProcObject::Resource())
+      : TempSet(TempSpan(list), resource) {}
+
+  [[nodiscard]] bool Contain(Temp *t) const;
+  /* @return whether t was not in the set */
+  bool Insert(Temp *t);
+  /* @return whether t was in the set */
+  bool Erase(Temp *t);
+  void UnionWith(const TempSet &other);
+  void DiffWith(const TempSet &other);
+  void Clear() { temps_.Clear(); }
+
+  [[nodiscard]] bool Empty() const { return temps_.Empty(); }
+  [[nodiscard]] uint32_t Size() const { return temps_.Size(); }
+  [[nodiscard]] Temp *const *begin() const { return temps_.begin(); }
+  [[nodiscard]] Temp *const *end() const { return temps_.end(); }
+
+  bool operator==(const TempSet &other) const;
+  bool operator!=(const TempSet &other) const { return !(*this == other); }
+
+private:
+  util::SmallVector<Temp *, 4> temps_;
+
+  /* position of t, or of the first temp after it */
+  [[nodiscard]] uint32_t LowerBound(Temp *t) const;
 };
 
 } // namespace temp
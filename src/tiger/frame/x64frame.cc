@@ -1,7 +1,7 @@
 #include "tiger/frame/x64frame.h"
 #include <sstream>
 
-extern frame::RegManager *reg_manager;
+#include "tiger/context/context.h"
 
 namespace frame {
 
@@ -44,6 +44,7 @@ X64RegManager::X64RegManager() {
 
   regs_ = std::vector<temp::Temp*>(
     registers_->GetList().begin(), registers_->GetList().end());
+  register_set_ = temp::TempSet(registers_, std::pmr::new_delete_resource());
 
   temp_map_->Enter(rax, new std::string("%rax"));
   temp_map_->Enter(rbx, new std::string("%rbx"));
@@ -112,7 +113,8 @@ public:
 class X64Frame : public Frame {
 
 public:
-  X64Frame(temp::Label *name, std::list<bool> formals);
+  X64Frame(ctx::CompilerContext *context, temp::Label *name,
+           std::list<bool> formals);
   ~X64Frame() override;
   std::list<Access*> &Formals() override { return formals_; }
   uint32_t Size() const override { return frame_size_; }
@@ -122,6 +124,7 @@ public:
   temp::Label* Name() override { return name_; }
   void InnerFuncArgCount(int argCount) override ;
   void AllocStackArg(RegManager *rm) override ;
+  std::string Layout() const override;
 private:
   /* private data member */
   std::list<Access*> formals_;
@@ -134,9 +137,13 @@ private:
 };
 
 /* result of Prologue_4 are saved in shift_of_view_ */
-X64Frame::X64Frame(temp::Label *name, std::list<bool> formals): 
-  name_(name), frame_size_(0), shift_of_view_(), max_inner_func_arg_cnt_(-1) {
-  
+X64Frame::X64Frame(ctx::CompilerContext *context, temp::Label *name,
+                   std::list<bool> formals):
+  Frame(context), name_(name), frame_size_(0), shift_of_view_(),
+  max_inner_func_arg_cnt_(-1) {
+  frame::RegManager *reg_manager = context_->GetRegManager();
+  temp::TempFactory::Scope temp_scope(&temps_);
+
   /* alloc space for formal params, and generate stm to move them */
   auto argRegs = reg_manager->ArgRegs()->GetList();
   auto argRegItr = argRegs.begin();
@@ -168,14 +175,16 @@ X64Frame::X64Frame(temp::Label *name, std::list<bool> formals):
 }
 
 /* pre-do Prologue_4 */
-Frame *NewFrame(temp::Label *name, std::list<bool> formals) {
-  return new X64Frame(name, formals);
+Frame *NewFrame(ctx::CompilerContext *context, temp::Label *name,
+               std::list<bool> formals) {
+  return new X64Frame(context, name, formals);
 }
 
 /* do Prologue_4 & 5 & Epilogue_8, stm is translated body (6 & 7)*/
 tree::Stm *ProcEntryExit1(Frame *frame, tree::Stm *body) {
   /* Prlogue_4 */
   auto x64Frame = static_cast<X64Frame*>(frame);
+  frame::RegManager *reg_manager = frame->Context()->GetRegManager();
   tree::SeqStm *shiftRoot = nullptr;
   tree::SeqStm *shiftRecurStm = nullptr;
   for (auto shiftStm : x64Frame->ShiftOfView()) {
@@ -246,30 +255,32 @@ tree::Stm *ProcEntryExit1(Frame *frame, tree::Stm *body) {
 }
 
 /* for regalloc */
-assem::InstrList *ProcEntryExit2(assem::InstrList *body) {
+assem::InstrList *ProcEntryExit2(Frame *frame, assem::InstrList *body) {
+  frame::RegManager *reg_manager = frame->Context()->GetRegManager();
   /* return sink as src: must live-out */
-  body->Append(new assem::OperInstr("", new temp::TempList(), 
-    reg_manager->ReturnSink(), nullptr));
+  body->Append(new assem::OperInstr(assem::Opcode::SINK, {}, {},
+    new temp::TempList(), reg_manager->ReturnSink(), nullptr));
   
   return body;
 }
 
 /* Prologue_1 & 2 & 3 & Epilogue_9 & 10 & 11 */
 assem::Proc *ProcEntryExit3(frame::Frame *frame, assem::InstrList *body) {
-  std::stringstream prologue, epilogue;
-  std::string funcName = frame->Name()->Name();
-  std::string stackPtrName = *(reg_manager->temp_map_->Look(reg_manager->StackPointer()));
+  frame::RegManager *reg_manager = frame->Context()->GetRegManager();
+  std::string funcName(frame->Name()->Name());
+  const std::string &stackPtrName =
+      *(reg_manager->temp_map_->Look(reg_manager->StackPointer()));
   /* fianlly, alloc space for arg */
   frame->AllocStackArg(reg_manager);
+  std::string size = std::to_string(frame->Size());
 
-  prologue << "  .set " << tree::fsPlaceHolder(funcName) << ", " << frame->Size() << "\n";
-  prologue << funcName << ":\n";
-  prologue << "\tsubq $" << frame->Size() << ", " << stackPtrName << "\n";
-
-  epilogue << "\taddq $" << frame->Size() << ", " << stackPtrName << "\n";
-  epilogue << "\tretq\n";
+  std::string prologue = "  .set " + tree::fsPlaceHolder(funcName) + ", " +
+                         size + "\n" + funcName + ":\n\tsubq $" + size +
+                         ", " + stackPtrName + "\n";
+  std::string epilogue = "\taddq $" + size + ", " + stackPtrName +
+                         "\n\tretq\n";
 
-  return new assem::Proc(prologue.str(), body, epilogue.str());
+  return new assem::Proc(std::move(prologue), body, std::move(epilogue));
 }
 
 X64Frame::~X64Frame() {
@@ -297,6 +308,19 @@ void X64Frame::InnerFuncArgCount(int argCount) {
   }
 }
 
+std::string X64Frame::Layout() const {
+  std::stringstream layout;
+  layout << "size " << frame_size_ << " args " << max_inner_func_arg_cnt_
+         << " formals";
+  for (auto access : formals_) {
+    if (auto in_frame = dynamic_cast<InFrameAccess *>(access))
+      layout << " " << in_frame->offset;
+    else
+      layout << " reg";
+  }
+  return layout.str();
+}
+
 void X64Frame::AllocStackArg(RegManager *rm) {
   int rmArgRegCount = rm->ArgRegs()->GetList().size();
   if (max_inner_func_arg_cnt_ > rmArgRegCount) {
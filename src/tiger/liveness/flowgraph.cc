@@ -1,32 +1,109 @@
 #include "tiger/liveness/flowgraph.h"
 
+#include <algorithm>
+
 namespace fg {
 
 void FlowGraphFactory::AssemFlowGraph() {
-
-  FNodePtr prevNode = nullptr;
-  for (auto instr : instr_list_->GetList()) {
-    FNodePtr curNode = flowgraph_->NewNode(instr);
-    if (prevNode) {
-      /* prev is not direct jump: have an edge */
-      flowgraph_->AddEdge(prevNode, curNode);
-    }
-    if (typeid(*instr) == typeid(assem::LabelInstr)) {
-      temp::Label *label = static_cast<assem::LabelInstr*>(instr)->label_;
-      label_map_->Enter(label, curNode);
-    }
-    if (instr->IsDirectJmp()) prevNode = nullptr;
-    else prevNode = curNode;
+  auto &blocks = flowgraph_.blocks_;
+  const auto &instrs = instr_list_->GetList();
+  /* a block starts at a label, or right after a jump */
+  bool leader = true;
+  for (auto pos = instrs.cbegin(); pos != instrs.cend(); ++pos) {
+    auto instr = *pos;
+    if (leader || typeid(*instr) == typeid(assem::LabelInstr))
+      blocks.push_back(Block{pos, pos, {}, {}});
+    blocks.back().last_ = pos;
+    leader = instr->IsJmp();
   }
-  /* add jump edge to control flow */
-  for (auto fromNode : flowgraph_->Nodes()->GetList()) {
-    if (fromNode->NodeInfo()->IsJmp()) {
-      auto targetLabels = *(static_cast<assem::OperInstr*>(fromNode->NodeInfo())->jumps_->labels_);
+  for (auto &block : blocks) {
+    auto instr = *block.begin_;
+    if (typeid(*instr) == typeid(assem::LabelInstr))
+      label_map_->Enter(static_cast<assem::LabelInstr *>(instr)->label_,
+                        &block);
+  }
+  /* falling through unless the block ends with a direct jump, and jumping */
+  for (int from = 0; from < static_cast<int>(blocks.size()); from++) {
+    auto last = *blocks[from].last_;
+    if (!last->IsDirectJmp() && from + 1 < static_cast<int>(blocks.size()))
+      AddEdge(from, from + 1);
+    if (last->IsJmp()) {
+      auto targetLabels = *(static_cast<assem::OperInstr*>(last)->jumps_->labels_);
       for (auto label : targetLabels) {
-        FNodePtr toNode = label_map_->Look(label);
-        assert(toNode != nullptr);
-        flowgraph_->AddEdge(fromNode, toNode);
+        Block *to = label_map_->Look(label);
+        assert(to != nullptr);
+        AddEdge(from, static_cast<int>(to - blocks.data()));
+      }
+    }
+  }
+  Postorder();
+  LoopDepths();
+}
+
+void FlowGraphFactory::AddEdge(int from, int to) {
+  auto &succs = flowgraph_.blocks_[from].succs_;
+  if (std::find(succs.begin(), succs.end(), to) != succs.end())
+    return;
+  succs.push_back(to);
+  flowgraph_.blocks_[to].preds_.push_back(from);
+}
+
+void FlowGraphFactory::Postorder() {
+  const auto &blocks = flowgraph_.blocks_;
+  auto &order = flowgraph_.postorder_;
+  std::vector<bool> visited(blocks.size(), false);
+  std::vector<bool> onStack(blocks.size(), false);
+  /* (block, next successor to visit) */
+  std::vector<std::pair<int, size_t>> stack;
+  if (!blocks.empty()) {
+    visited[0] = onStack[0] = true;
+    stack.emplace_back(0, 0);
+  }
+  while (!stack.empty()) {
+    auto &[block, next] = stack.back();
+    if (next < blocks[block].succs_.size()) {
+      int succ = blocks[block].succs_[next++];
+      if (!visited[succ]) {
+        visited[succ] = onStack[succ] = true;
+        stack.emplace_back(succ, 0);
+      } else if (onStack[succ]) {
+        back_edges_.emplace_back(block, succ);
       }
+    } else {
+      order.push_back(block);
+      onStack[block] = false;
+      stack.pop_back();
+    }
+  }
+  for (int block = 0; block < static_cast<int>(blocks.size()); block++) {
+    if (!visited[block])
+      order.push_back(block);
+  }
+}
+
+void FlowGraphFactory::LoopDepths() {
+  auto &blocks = flowgraph_.blocks_;
+  std::sort(back_edges_.begin(), back_edges_.end(),
+            [](const auto &a, const auto &b) { return a.second < b.second; });
+  std::vector<int> inLoop(blocks.size(), -1);
+  std::vector<int> worklist;
+  for (size_t e = 0; e < back_edges_.size(); e++) {
+    int header = back_edges_[e].second;
+    /* the header is in the loop and stops the walk */
+    if (inLoop[header] != header) {
+      inLoop[header] = header;
+      blocks[header].loop_depth_++;
+    }
+    worklist.push_back(back_edges_[e].first);
+    while (!worklist.empty()) {
+      int block = worklist.back();
+      worklist.pop_back();
+      if (inLoop[block] == header)
+        continue;
+      inLoop[block] = header;
+      blocks[block].loop_depth_++;
+      for (int pred : blocks[block].preds_)
+        worklist.push_back(pred);
     }
   }
 }
@@ -35,27 +112,16 @@ void FlowGraphFactory::AssemFlowGraph() {
 
 namespace assem {
 
-temp::TempList *LabelInstr::Def() const {
-  return new temp::TempList();
-}
+temp::TempSpan LabelInstr::Def() const { return {}; }
 
-temp::TempList *MoveInstr::Def() const {
-  return dst_ ? dst_ : new temp::TempList();
-}
+temp::TempSpan MoveInstr::Def() const { return temp::TempSpan(dst_); }
 
-temp::TempList *OperInstr::Def() const {
-  return dst_ ? dst_ : new temp::TempList();
-}
+temp::TempSpan OperInstr::Def() const { return temp::TempSpan(dst_); }
 
-temp::TempList *LabelInstr::Use() const {
-  return new temp::TempList();
-}
+temp::TempSpan LabelInstr::Use() const { return {}; }
 
-temp::TempList *MoveInstr::Use() const {
-  return src_ ? src_ : new temp::TempList();
-}
+temp::TempSpan MoveInstr::Use() const { return temp::TempSpan(src_); }
+
+temp::TempSpan OperInstr::Use() const { return temp::TempSpan(src_); }
 
-temp::TempList *OperInstr::Use() const {
-  return src_ ? src_ : new temp::TempList();
-}
 } // namespace assem
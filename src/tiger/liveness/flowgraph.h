@@ -1,33 +1,85 @@
 #ifndef TIGER_LIVENESS_FLOWGRAPH_H_
 #define TIGER_LIVENESS_FLOWGRAPH_H_
 
+#include <iterator>
+#include <memory>
+#include <vector>
+
 #include "tiger/codegen/assem.h"
 #include "tiger/frame/frame.h"
 #include "tiger/frame/temp.h"
-#include "tiger/util/graph.h"
+#include "tiger/util/table.h"
 
 namespace fg {
 
-using FNode = graph::Node<assem::Instr>;
-using FNodePtr = graph::Node<assem::Instr>*;
-using FNodeListPtr = graph::NodeList<assem::Instr>*;
-using FGraph = graph::Graph<assem::Instr>;
-using FGraphPtr = graph::Graph<assem::Instr>*;
+using InstrPos = std::pmr::list<assem::Instr *>::const_iterator;
+
+/**
+ * Basic block, a maximal run of instructions entered only at the first one
+ * and left only after the last one. Its ends are positions in the
+ * instruction list, which stay valid when instructions are inserted.
+ */
+struct Block {
+  InstrPos begin_;
+  InstrPos last_;
+  std::vector<int> succs_;
+  std::vector<int> preds_;
+  /* number of loops the block is in */
+  int loop_depth_ = 0;
+
+  /* past the last instruction */
+  [[nodiscard]] InstrPos End() const { return std::next(last_); }
+};
+
+/* control flow graph of the basic blocks of a procedure */
+class FlowGraph {
+  friend class FlowGraphFactory;
+
+public:
+  /* in the order of the instructions, the entry first */
+  [[nodiscard]] std::vector<Block> &Blocks() { return blocks_; }
+  [[nodiscard]] const std::vector<Block> &Blocks() const { return blocks_; }
+
+  /**
+   * Blocks in postorder of a depth-first walk from the entry, successors
+   * before predecessors, then the blocks it does not reach
+   */
+  [[nodiscard]] const std::vector<int> &Postorder() const {
+    return postorder_;
+  }
+
+private:
+  std::vector<Block> blocks_;
+  std::vector<int> postorder_;
+};
 
 class FlowGraphFactory {
 public:
   explicit FlowGraphFactory(assem::InstrList *instr_list)
-      : instr_list_(instr_list), flowgraph_(new FGraph()),
-        label_map_(std::make_unique<tab::Table<temp::Label, FNode>>()) {}
+      : instr_list_(instr_list),
+        label_map_(std::make_unique<tab::Table<temp::Label, Block>>()) {}
   void AssemFlowGraph();
-  FGraphPtr GetFlowGraph() { return flowgraph_; }
+  FlowGraph *GetFlowGraph() { return &flowgraph_; }
 
 private:
   assem::InstrList *instr_list_;
-  FGraphPtr flowgraph_;
-  std::unique_ptr<tab::Table<temp::Label, FNode>> label_map_;
+  FlowGraph flowgraph_;
+  /* blocks by the label they start with */
+  std::unique_ptr<tab::Table<temp::Label, Block>> label_map_;
+
+  /* edges to a block still on the stack of the depth-first walk */
+  std::vector<std::pair<int, int>> back_edges_;
+
+  void AddEdge(int from, int to);
+  void Postorder();
+  /**
+   * The natural loop of a back edge is its target, the header, with the
+   * blocks reaching its source without passing the header. Back edges to
+   * the same header make one loop.
+   */
+  void LoopDepths();
 };
 
 } // namespace fg
 
-#endif
\ No newline at end of file
+#endif
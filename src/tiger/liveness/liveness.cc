@@ -1,9 +1,61 @@
 #include "tiger/liveness/liveness.h"
 
-extern frame::RegManager *reg_manager;
-
 namespace live {
 
+INode *IGraph::NewNode(temp::Temp *temp, bool precolored) {
+  auto node = new INode(temp, static_cast<int>(nodes_.size()), precolored);
+  nodes_.push_back(node);
+  if (temp_nodes_.size() <= static_cast<size_t>(temp->Int()))
+    temp_nodes_.resize(temp->Int() + 1, nullptr);
+  temp_nodes_[temp->Int()] = node;
+  return node;
+}
+
+INode *IGraph::Look(temp::Temp *temp) const {
+  size_t id = temp->Int();
+  return id < temp_nodes_.size() ? temp_nodes_[id] : nullptr;
+}
+
+bool IGraph::AddEdge(INode *u, INode *v) {
+  assert(u && v);
+  if (u == v || Adjacent(u, v))
+    return false;
+  size_t bit = Bit(u->key_, v->key_);
+  if (bit / 64 >= matrix_.size()) {
+    /* rows of all nodes so far, (i, 0) ... (i, i - 1) for each i */
+    matrix_.resize((Bit(nodes_.size(), 0) + 63) / 64, 0);
+  }
+  matrix_[bit / 64] |= uint64_t(1) << (bit % 64);
+  if (!u->precolored_)
+    u->adj_.push_back(v);
+  if (!v->precolored_)
+    v->adj_.push_back(u);
+  return true;
+}
+
+void IGraph::RemoveEdge(INode *u, INode *v) {
+  if (!Adjacent(u, v))
+    return;
+  size_t bit = Bit(u->key_, v->key_);
+  matrix_[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+  if (!u->precolored_)
+    u->adj_.erase(std::find(u->adj_.begin(), u->adj_.end(), v));
+  if (!v->precolored_)
+    v->adj_.erase(std::find(v->adj_.begin(), v->adj_.end(), u));
+}
+
+void IGraph::RemoveNode(INode *n) {
+  assert(!n->precolored_);
+  for (auto m : n->adj_) {
+    size_t bit = Bit(n->key_, m->key_);
+    matrix_[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+    if (!m->precolored_)
+      m->adj_.erase(std::find(m->adj_.begin(), m->adj_.end(), n));
+  }
+  n->adj_.clear();
+  n->removed_ = true;
+}
+
 bool MoveList::Contain(INodePtr src, INodePtr dst) {
   return std::any_of(move_list_.cbegin(), move_list_.cend(),
                      [src, dst](std::pair<INodePtr, INodePtr> move) {
@@ -50,119 +102,198 @@ MoveList *MoveList::Intersect(MoveList *list) {
   return res;
 }
 
-void LiveGraphFactory::LiveMap() {
-  /* intialize in & out set */
-  for (auto node : flowgraph_->Nodes()->GetList()) {
-    in_->Enter(node, new temp::TempList());
-    out_->Enter(node, new temp::TempList());
-  }
-  /* calculate in & out till reach fixed-point */
-  bool done = false;
-  auto allN = flowgraph_->Nodes()->GetList();
-  while (!done) {
-    done = true;
-    /* loop backwards => reach fixpoint faster */
-    for (auto curNode = allN.rbegin(); curNode != allN.rend(); ++curNode) {
-      /* tons of memory leak here, but I dont give a shit */
-      auto inSet = in_->Look(*curNode);
-      auto outSet = out_->Look(*curNode);
-      auto instr = (*curNode)->NodeInfo();
-      auto newInSet = instr->Use()->Union(outSet->Diff(instr->Def()));
-      auto newOutSet = new temp::TempList();
-      for (auto succNode : (*curNode)->Succ()->GetList()) {
-        newOutSet->UnionWith(in_->Look(succNode));
-      }
-      in_->Set(*curNode, newInSet);
-      out_->Set(*curNode, newOutSet);
-      if (!newInSet->IsEquivalent(inSet) || !newOutSet->IsEquivalent(outSet))
-        done = false;
-      delete inSet, delete outSet;
+void LiveGraphFactory::MakeNodes() {
+  auto interf_graph_ = live_graph_.interf_graph;
+  /* phase1: insert all pre-colored regs, which need no edges among them */
+  for (auto reg : reg_manager_->Registers()->GetList()) {
+    /* rsp not allowed here */
+    interf_graph_->NewNode(reg, true);
+  }
+  /* phase2: the temps, in the order they appear */
+  for (const auto &block : flowgraph_->Blocks()) {
+    for (auto pos = block.begin_; pos != block.End(); ++pos) {
+      for (auto temp : (*pos)->Def())
+        AskNode(temp);
+      for (auto temp : (*pos)->Use())
+        AskNode(temp);
     }
   }
 }
 
-void LiveGraphFactory::InterfGraph() {
-  
+void LiveGraphFactory::LiveMap() {
+  const auto &blocks = flowgraph_->Blocks();
   auto interf_graph_ = live_graph_.interf_graph;
-  auto move_list_ = live_graph_.moves;
-  /* phase1: insert all pre-colored regs */
-  for (auto reg : reg_manager->Registers()->GetList()) {
-    /* rsp not allowed here */
-    INode *node = interf_graph_->NewNode(reg);
-    temp_node_map_->Enter(reg, node);
-  }
-  for (auto from : reg_manager->ArgRegs()->GetList()) {
-    for (auto to : reg_manager->ArgRegs()->GetList()) {
-      if (from == to) continue;
-      interf_graph_->AddEdge(AskNode(from), AskNode(to));
+  size_t count = interf_graph_->Nodes().size();
+  def_.assign(blocks.size(), util::BitVector(count));
+  use_.assign(blocks.size(), util::BitVector(count));
+  in_.assign(blocks.size(), util::BitVector(count));
+  out_.assign(blocks.size(), util::BitVector(count));
+  /* use & def of a block, walking it backwards */
+  for (size_t b = 0; b < blocks.size(); b++) {
+    for (auto pos = blocks[b].End(); pos != blocks[b].begin_;) {
+      auto instr = *--pos;
+      for (auto temp : instr->Def()) {
+        int key = interf_graph_->Look(temp)->Key();
+        def_[b].Set(key);
+        use_[b].Reset(key);
+      }
+      for (auto temp : instr->Use())
+        use_[b].Set(interf_graph_->Look(temp)->Key());
     }
   }
-  /* phase2: add temps to flowgraph */
-  for (auto fNode : flowgraph_->Nodes()->GetList()) {
-    auto instr = fNode->NodeInfo();
-    /* code can be optmized here */
-    if (fNode->NodeInfo()->IsMove()) {
-      for (auto defTemp : instr->Def()->GetList()) {
-        auto defNode = AskNode(defTemp);
-        /* add interference edge: not in use-list */
-        for (auto outTemp : out_->Look(fNode)->Diff(instr->Use())->GetList()) {
-          if (defTemp == outTemp) continue;
-          auto outNode = AskNode(outTemp);
-          interf_graph_->AddEdge(defNode, outNode);
-          interf_graph_->AddEdge(outNode, defNode);
-        }
-        /* construct move list */
-        for (auto useTemp : instr->Use()->GetList()) {
-          move_list_->Append(AskNode(useTemp), defNode);
+  /* successors come first in postorder, the block is seen after them */
+  std::vector<int> worklist(flowgraph_->Postorder().rbegin(),
+                            flowgraph_->Postorder().rend());
+  std::vector<bool> queued(blocks.size(), true);
+  while (!worklist.empty()) {
+    int b = worklist.back();
+    worklist.pop_back();
+    queued[b] = false;
+    /* out = U in[succ], in = use U (out - def) */
+    out_[b].Clear();
+    for (int succ : blocks[b].succs_)
+      out_[b].UnionWith(in_[succ]);
+    if (in_[b].AssignUnionDiff(use_[b], out_[b], def_[b])) {
+      for (int pred : blocks[b].preds_) {
+        if (!queued[pred]) {
+          queued[pred] = true;
+          worklist.push_back(pred);
         }
       }
-    } else {
-      for (auto defTemp : instr->Def()->GetList()) {
-        auto defNode = AskNode(defTemp);
-        for (auto outTemp : out_->Look(fNode)->GetList()) {
-          if (defTemp == outTemp) continue;
-          auto outNode = AskNode(outTemp);
-          interf_graph_->AddEdge(defNode, outNode);
-          interf_graph_->AddEdge(outNode, defNode);
+    }
+  }
+}
+
+void LiveGraphFactory::InterfGraph() {
+  /* backwards through the blocks, the moves are prepended and end up in
+   * the order of the instructions */
+  for (int b = static_cast<int>(flowgraph_->Blocks().size()); b-- > 0;)
+    WalkBlock(b, 0, live_graph_.moves);
+}
+
+void LiveGraphFactory::WalkBlock(int b, size_t first, MoveList *moves) {
+  const auto &block = flowgraph_->Blocks()[b];
+  auto interf_graph_ = live_graph_.interf_graph;
+  const auto &nodes = interf_graph_->Nodes();
+  util::BitVector live = out_[b];
+  live.Resize(nodes.size());
+  for (auto pos = block.End(); pos != block.begin_;) {
+    auto instr = *--pos;
+    /* live is the out set of instr here */
+    bool isMove = instr->IsMove();
+    auto use = instr->Use();
+    for (auto defTemp : instr->Def()) {
+      auto defNode = interf_graph_->Look(defTemp);
+      /* add interference edge: for moves, not with the source */
+      auto addEdge = [&](size_t key) {
+        auto outNode = nodes[key];
+        if (outNode == defNode ||
+            (isMove && use.Contain(outNode->NodeInfo())))
+          return;
+        /* the graph is undirected, one call adds both directions */
+        interf_graph_->AddEdge(defNode, outNode);
+      };
+      /* edges between older nodes are there already */
+      bool fresh = static_cast<size_t>(defNode->Key()) >= first;
+      live.ForEachFrom(fresh ? 0 : first, addEdge);
+      /* construct move list */
+      if (isMove) {
+        for (auto useTemp : use) {
+          auto useNode = interf_graph_->Look(useTemp);
+          if (fresh || static_cast<size_t>(useNode->Key()) >= first)
+            moves->Prepend(useNode, defNode);
         }
       }
     }
+    for (auto defTemp : instr->Def())
+      live.Reset(interf_graph_->Look(defTemp)->Key());
+    for (auto useTemp : use)
+      live.Set(interf_graph_->Look(useTemp)->Key());
   }
 }
 
-INodePtr LiveGraphFactory::AskNode(temp::Temp *reg) {
-  INodePtr node = temp_node_map_->Look(reg);
-  if (node == nullptr) {
-    node = live_graph_.interf_graph->NewNode(reg);
-    temp_node_map_->Enter(reg, node);
+void LiveGraphFactory::Update(const std::vector<INode *> &spilled,
+                              const std::vector<int> &blocks) {
+  auto interf_graph_ = live_graph_.interf_graph;
+  for (auto node : spilled) {
+    int key = node->Key();
+    for (size_t b = 0; b < in_.size(); b++) {
+      def_[b].Reset(key);
+      use_[b].Reset(key);
+      in_[b].Reset(key);
+      out_[b].Reset(key);
+    }
+    interf_graph_->RemoveNode(node);
   }
+  live_graph_.moves->DeleteIf([](const std::pair<INodePtr, INodePtr> &move) {
+    return move.first->Removed() || move.second->Removed();
+  });
+
+  /* nodes of the new temps come after all others */
+  size_t first = interf_graph_->Nodes().size();
+  for (int b : blocks) {
+    const auto &block = flowgraph_->Blocks()[b];
+    for (auto pos = block.begin_; pos != block.End(); ++pos) {
+      for (auto temp : (*pos)->Def())
+        AskNode(temp);
+      for (auto temp : (*pos)->Use())
+        AskNode(temp);
+    }
+  }
+  /* the new temps never live across blocks, their bits stay clear; the
+   * sets cover them for the next rounds, which may spill them again */
+  size_t count = interf_graph_->Nodes().size();
+  for (size_t b = 0; b < in_.size(); b++) {
+    def_[b].Resize(count);
+    use_[b].Resize(count);
+    in_[b].Resize(count);
+    out_[b].Resize(count);
+  }
+  MoveList moves;
+  for (auto b = blocks.rbegin(); b != blocks.rend(); ++b)
+    WalkBlock(*b, first, &moves);
+  for (const auto &move : moves.GetList())
+    live_graph_.moves->Append(move.first, move.second);
+}
+
+INodePtr LiveGraphFactory::AskNode(temp::Temp *reg) {
+  INodePtr node = live_graph_.interf_graph->Look(reg);
+  if (node == nullptr)
+    node = live_graph_.interf_graph->NewNode(reg, false);
   return node;
 }
 
 void LiveGraphFactory::Liveness() {
-  LiveMap();
+  LiveSets();
   InterfGraph();
-  // PrintInAndOut(reg_manager);
+  // PrintInAndOut(reg_manager_);
+}
+
+void LiveGraphFactory::LiveSets() {
+  MakeNodes();
+  LiveMap();
 }
 
-void PrintTempList(temp::TempList *tl, frame::RegManager *rm) {
-  for (auto temp : tl->GetList()) {
+void PrintTempSet(const util::BitVector &ts, IGraph *g,
+                  frame::RegManager *rm) {
+  ts.ForEach([g, rm](size_t key) {
+    auto temp = g->Nodes()[key]->NodeInfo();
     auto res = rm->temp_map_->Look(temp);
     if (res) {
       printf("%s ", res->c_str());
     } else {
       printf("t%d ", temp->Int());
     }
-  }
+  });
   printf("\n");
 }
 
 void LiveGraphFactory::PrintInAndOut(frame::RegManager *rm) {
-  for (auto fnode : flowgraph_->Nodes()->GetList()) {
+  for (size_t b = 0; b < flowgraph_->Blocks().size(); b++) {
     printf("In : ");
-    PrintTempList(in_->Look(fnode), rm);
+    PrintTempSet(in_[b], live_graph_.interf_graph, rm);
     printf("Out: ");
-    PrintTempList(out_->Look(fnode), rm);
+    PrintTempSet(out_[b], live_graph_.interf_graph, rm);
   }
 }
 
@@ -1,26 +1,127 @@
 #ifndef TIGER_LIVENESS_LIVENESS_H_
 #define TIGER_LIVENESS_LIVENESS_H_
 
+#include <algorithm>
+#include <list>
+#include <vector>
+
 #include "tiger/codegen/assem.h"
 #include "tiger/frame/x64frame.h"
 #include "tiger/frame/temp.h"
 #include "tiger/liveness/flowgraph.h"
+#include "tiger/util/bit_vector.h"
 #include "tiger/util/graph.h"
 
 namespace live {
 
-using INode = graph::Node<temp::Temp>;
-using INodePtr = graph::Node<temp::Temp>*;
-using INodeList = graph::NodeList<temp::Temp>;
-using INodeListPtr = graph::NodeList<temp::Temp>*;
-using IGraph = graph::Graph<temp::Temp>;
-using IGraphPtr = graph::Graph<temp::Temp>*;
+class IGraph;
+
+/**
+ * Node of the interference graph, standing for one temp. Following Appel,
+ * precolored nodes keep no adjacency list: the allocator never walks their
+ * neighbours, it only asks whether an edge to them exists.
+ */
+class INode : public util::ProcObject {
+  friend class IGraph;
+
+public:
+  [[nodiscard]] temp::Temp *NodeInfo() const { return info_; }
+  /* dense index of the node in its graph, in the order of creation */
+  [[nodiscard]] int Key() const { return key_; }
+  [[nodiscard]] bool Precolored() const { return precolored_; }
+  /* spilled, its temp is no longer in the code */
+  [[nodiscard]] bool Removed() const { return removed_; }
+  /* neighbours of the node, always empty if it is precolored */
+  [[nodiscard]] const std::pmr::vector<INode *> &Adj() const { return adj_; }
+  [[nodiscard]] int Degree() const { return static_cast<int>(adj_.size()); }
+
+private:
+  temp::Temp *info_;
+  int key_;
+  bool precolored_;
+  bool removed_ = false;
+  std::pmr::vector<INode *> adj_{Resource()};
+
+  INode(temp::Temp *info, int key, bool precolored)
+      : info_(info), key_(key), precolored_(precolored) {}
+};
+
+using INodePtr = INode *;
+
+/**
+ * Undirected interference graph. Whether two nodes interfere is a lookup in
+ * a triangular bit matrix, the bit of (i, j) with i > j being at
+ * i * (i - 1) / 2 + j, so the matrix only grows at its end as nodes are
+ * added. It is sized by the first edge beyond its end, a graph without
+ * edges has none. The neighbours of a node are walked in its adjacency
+ * vector.
+ */
+class IGraph : public util::ProcObject {
+public:
+  INode *NewNode(temp::Temp *temp, bool precolored);
+  /* the node of a temp, nullptr if it has none */
+  [[nodiscard]] INode *Look(temp::Temp *temp) const;
+
+  /**
+   * Add the edge between u and v
+   * @return false if they already interfere, or u == v
+   */
+  bool AddEdge(INode *u, INode *v);
+  void RemoveEdge(INode *u, INode *v);
+  /* drop the edges of a node and mark it removed, its key stays taken */
+  void RemoveNode(INode *n);
+  [[nodiscard]] bool Adjacent(const INode *u, const INode *v) const {
+    size_t bit = Bit(u->key_, v->key_);
+    return u != v && bit / 64 < matrix_.size() &&
+           (matrix_[bit / 64] >> (bit % 64) & 1);
+  }
+
+  [[nodiscard]] const std::pmr::vector<INode *> &Nodes() const {
+    return nodes_;
+  }
+
+private:
+  std::pmr::vector<INode *> nodes_{Resource()};
+  /* indexed by the id of the temp */
+  std::pmr::vector<INode *> temp_nodes_{Resource()};
+  std::pmr::vector<uint64_t> matrix_{Resource()};
+
+  static size_t Bit(size_t i, size_t j) {
+    if (i < j)
+      std::swap(i, j);
+    return i * (i - 1) / 2 + j;
+  }
+};
+
+using IGraphPtr = IGraph *;
+
+/* list of interference nodes */
+class INodeList : public util::ProcObject {
+public:
+  [[nodiscard]] const std::pmr::list<INode *> &GetList() const {
+    return node_list_;
+  }
+  bool Contain(INode *n) const {
+    return std::find(node_list_.begin(), node_list_.end(), n) !=
+           node_list_.end();
+  }
+  void DeleteNode(INode *n) { node_list_.remove(n); }
+  void Clear() { node_list_.clear(); }
+  void Append(INode *n) { node_list_.push_back(n); }
+  bool Empty() const { return node_list_.empty(); }
+  INode *GetOne() { return node_list_.front(); }
+
+private:
+  std::pmr::list<INode *> node_list_{Resource()};
+};
 
-class MoveList {
+using INodeListPtr = INodeList *;
+
+class MoveList : public util::ProcObject {
 public:
   MoveList() = default;
 
-  [[nodiscard]] const std::list<std::pair<INodePtr, INodePtr>> &
+  [[nodiscard]] const std::pmr::list<std::pair<INodePtr, INodePtr>> &
   GetList() const {
     return move_list_;
   }
@@ -35,9 +136,10 @@ public:
   bool Empty() { return move_list_.empty(); } 
   std::pair<INodePtr, INodePtr> &GetOne() { return move_list_.front(); }
   void UnionWith(MoveList *list);
+  template <typename P> void DeleteIf(P pred) { move_list_.remove_if(pred); }
 
 private:
-  std::list<std::pair<INodePtr, INodePtr>> move_list_;
+  std::pmr::list<std::pair<INodePtr, INodePtr>> move_list_{Resource()};
 };
 
 struct LiveGraph {
@@ -48,29 +150,62 @@ struct LiveGraph {
       : interf_graph(interf_graph), moves(moves) {}
 };
 
+/**
+ * Liveness on the basic blocks of a procedure. Use and def are summarized
+ * per block, and in and out are bit vectors indexed by the keys of the
+ * interference nodes, solved with a worklist. Liveness at each instruction
+ * is only known during the backward walk which builds the interference
+ * graph.
+ */
 class LiveGraphFactory {
 public:
-  explicit LiveGraphFactory(fg::FGraphPtr flowgraph)
-      : flowgraph_(flowgraph), live_graph_(new IGraph(), new MoveList()),
-        in_(std::make_unique<graph::Table<assem::Instr, temp::TempList>>()),
-        out_(std::make_unique<graph::Table<assem::Instr, temp::TempList>>()),
-        temp_node_map_(new tab::Table<temp::Temp, INode>()) {}
+  LiveGraphFactory(fg::FlowGraph *flowgraph, frame::RegManager *reg_manager)
+      : flowgraph_(flowgraph), reg_manager_(reg_manager),
+        live_graph_(new IGraph(), new MoveList()) {}
   void Liveness();
+  /* only the nodes and the in and out sets, without interference */
+  void LiveSets();
+
+  /**
+   * Patch liveness and interference after spilling, instead of starting
+   * over. The spilled temps are live nowhere now. The temps of the spill
+   * code never live out of their block, so in and out of the blocks stay
+   * as they are, and only the rewritten blocks are walked again, for the
+   * edges and moves of the new temps.
+   * @param spilled nodes of the temps moved to memory
+   * @param blocks indices of the blocks with spill code, increasing
+   */
+  void Update(const std::vector<INode *> &spilled,
+              const std::vector<int> &blocks);
+
   LiveGraph GetLiveGraph() { return live_graph_; }
-  tab::Table<temp::Temp, INode> *GetTempNodeMap() { return temp_node_map_; }
+  /* temps live into and out of block b, by the keys of their nodes */
+  [[nodiscard]] const util::BitVector &In(int b) const { return in_[b]; }
+  [[nodiscard]] const util::BitVector &Out(int b) const { return out_[b]; }
   void PrintInAndOut(frame::RegManager *rm);
 
 private:
-  fg::FGraphPtr flowgraph_;
+  fg::FlowGraph *flowgraph_;
+  frame::RegManager *reg_manager_;
   LiveGraph live_graph_;
 
-  std::unique_ptr<graph::Table<assem::Instr, temp::TempList>> in_;
-  std::unique_ptr<graph::Table<assem::Instr, temp::TempList>> out_;
-  tab::Table<temp::Temp, INode> *temp_node_map_;
+  /* sets of the blocks, indexed like them */
+  std::vector<util::BitVector> def_;
+  std::vector<util::BitVector> use_;
+  std::vector<util::BitVector> in_;
+  std::vector<util::BitVector> out_;
 
+  void MakeNodes();
   void LiveMap();
   void InterfGraph();
 
+  /**
+   * Walk a block backwards from its out set, adding the edges and moves of
+   * the nodes with a key no less than first
+   * @param moves where the moves are prepended
+   */
+  void WalkBlock(int b, size_t first, MoveList *moves);
+
   /* get a node by its regPtr, create if necessary */
   INodePtr AskNode(temp::Temp *reg);
 };
@@ -0,0 +1,273 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+#include "tiger/bench/args.h"
+#include "tiger/bench/generator.h"
+#include "tiger/bench/json.h"
+#include "tiger/driver/driver.h"
+#include "tiger/frame/x64frame.h"
+#include "tiger/stats/stats.h"
+
+namespace {
+
+void Usage() {
+  fprintf(stderr,
+          "usage: bench_compile [options]\n"
+          "options: --grow functions|depth|vars|loops|block, "
+          "--sizes N,N,...,\n"
+          "         --functions N, --depth N, --vars N, --loops N, "
+          "--records PCT,\n"
+          "         --arrays PCT, --block N, --seed N, --repeat N, -j N,\n"
+          "         --dump dir, -o report.json\n");
+  exit(1);
+}
+
+/* the shape parameters which can grow, and their flags */
+const char *const kParams[] = {"functions", "depth", "vars", "loops", "block"};
+
+int *Param(bench::ProgramShape &shape, std::string_view name) {
+  if (name == "functions")
+    return &shape.functions_;
+  if (name == "depth")
+    return &shape.depth_;
+  if (name == "vars")
+    return &shape.vars_;
+  if (name == "loops")
+    return &shape.loops_;
+  if (name == "block")
+    return &shape.block_;
+  if (name == "records")
+    return &shape.records_;
+  if (name == "arrays")
+    return &shape.arrays_;
+  return nullptr;
+}
+
+/* instructions in the assembly, i.e. lines that are no label or directive */
+uint64_t CountInstrs(FILE *assem) {
+  uint64_t instrs = 0;
+  char line[4096];
+  rewind(assem);
+  while (fgets(line, sizeof(line), assem)) {
+    const char *p = line;
+    while (*p == ' ' || *p == '\t')
+      p++;
+    size_t len = strcspn(p, "\n");
+    if (len > 0 && *p != '.' && p[len - 1] != ':')
+      instrs++;
+  }
+  return instrs;
+}
+
+struct Run {
+  int size_;
+  uint64_t lines_;
+  uint64_t bytes_;
+  uint64_t instrs_;
+  uint64_t wall_ns_;
+  std::vector<stats::PassTotal> passes_;
+};
+
+/**
+ * Slope of log(time) over log(lines), the exponent of the growth of a pass
+ * @return NaN with less than two usable points
+ */
+double Exponent(const std::vector<std::pair<double, double>> &points) {
+  double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (const auto &[lines, ns] : points) {
+    if (lines <= 0 || ns <= 0)
+      continue;
+    double x = std::log(lines), y = std::log(ns);
+    n++;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+  double d = n * sxx - sx * sx;
+  if (n < 2 || d == 0)
+    return NAN;
+  return (n * sxy - sx * sy) / d;
+}
+
+void WriteReport(FILE *out, const bench::ProgramShape &shape,
+                 const char *grow, int repeat, const std::vector<Run> &runs) {
+  bench::JsonWriter json(out);
+  json.BeginObject();
+  json.Key("benchmark").String("compile");
+  json.Key("version").String(TIGER_VERSION);
+  json.Key("shape").BeginObject();
+  bench::ProgramShape base = shape;
+  for (const char *param : {"functions", "depth", "vars", "loops", "records",
+                            "arrays", "block"})
+    json.Key(param).Int(*Param(base, param));
+  json.Key("seed").Int(static_cast<int64_t>(shape.seed_));
+  json.EndObject();
+  json.Key("grow").String(grow);
+  json.Key("repeat").Int(repeat);
+
+  // Points of the complexity curves: pass -> (lines, time)
+  std::vector<std::string> order = {"total"};
+  std::map<std::string, std::vector<std::pair<double, double>>> curves;
+  json.Key("runs").BeginArray();
+  for (const auto &run : runs) {
+    double seconds = run.wall_ns_ / 1e9;
+    json.BeginObject();
+    json.Key("size").Int(run.size_);
+    json.Key("lines").Int(run.lines_);
+    json.Key("bytes").Int(run.bytes_);
+    json.Key("instrs").Int(run.instrs_);
+    json.Key("wall_ns").Int(run.wall_ns_);
+    json.Key("lines_per_s").Double(seconds > 0 ? run.lines_ / seconds : 0);
+    json.Key("instrs_per_s").Double(seconds > 0 ? run.instrs_ / seconds : 0);
+    json.Key("passes").BeginArray();
+    for (const auto &pass : run.passes_) {
+      json.BeginObject();
+      json.Key("pass").String(pass.pass_);
+      json.Key("calls").Int(pass.calls_);
+      json.Key("time_ns").Int(pass.ns_);
+      json.Key("allocs").Int(pass.allocs_);
+      json.Key("bytes").Int(pass.bytes_);
+      json.EndObject();
+      if (curves.find(pass.pass_) == curves.end())
+        order.push_back(pass.pass_);
+      curves[pass.pass_].emplace_back(run.lines_, pass.ns_);
+    }
+    json.EndArray();
+    json.EndObject();
+    curves["total"].emplace_back(run.lines_, run.wall_ns_);
+  }
+  json.EndArray();
+
+  // Around 1 is linear in the size of the program, 2 quadratic
+  json.Key("scaling").BeginArray();
+  for (const auto &pass : order) {
+    json.BeginObject();
+    json.Key("pass").String(pass);
+    json.Key("exponent").Double(Exponent(curves[pass]));
+    json.EndObject();
+  }
+  json.EndArray();
+  json.EndObject();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::ProgramShape shape;
+  const char *grow = "functions";
+  std::vector<int> sizes = {1, 2, 4, 8};
+  int repeat = 3;
+  const char *dump_dir = nullptr;
+  const char *out_path = nullptr;
+  driver::Options options;
+  for (int argi = 1; argi < argc; argi += 2) {
+    const char *arg = argv[argi];
+    if (argi + 1 >= argc || arg[0] != '-')
+      Usage();
+    const char *value = argv[argi + 1];
+    if (strcmp(arg, "--grow") == 0) {
+      grow = value;
+      bool known = false;
+      for (const char *param : kParams)
+        known |= strcmp(param, value) == 0;
+      if (!known)
+        Usage();
+    } else if (strcmp(arg, "--sizes") == 0) {
+      // grown parameters such as loops may start from 0
+      if (!bench::ParseSizes(value, 0, sizes))
+        Usage();
+    } else if (strcmp(arg, "--seed") == 0) {
+      shape.seed_ = strtoull(value, nullptr, 10);
+    } else if (strcmp(arg, "--repeat") == 0) {
+      repeat = std::max(1, atoi(value));
+    } else if (strcmp(arg, "-j") == 0) {
+      options.jobs = std::max(1, atoi(value));
+    } else if (strcmp(arg, "--dump") == 0) {
+      dump_dir = value;
+    } else if (strcmp(arg, "-o") == 0) {
+      out_path = value;
+    } else if (strncmp(arg, "--", 2) == 0 && Param(shape, arg + 2)) {
+      *Param(shape, arg + 2) = std::max(0, atoi(value));
+    } else {
+      Usage();
+    }
+  }
+
+  // Programs go to a file of their own, the compiler reads from files only
+  std::string dir = dump_dir ? dump_dir : "";
+  if (dir.empty()) {
+    char tmp[] = "/tmp/bench_compile.XXXXXX";
+    if (!mkdtemp(tmp)) {
+      perror("mkdtemp");
+      return 1;
+    }
+    dir = tmp;
+  }
+
+  stats::Enable(true, true);
+  frame::X64RegManager reg_manager;
+  std::vector<Run> runs;
+  for (int size : sizes) {
+    bench::ProgramShape sized = shape;
+    *Param(sized, grow) = size;
+    sized.functions_ = std::max(1, sized.functions_);
+    std::string program = bench::GenerateProgram(sized);
+    std::string fname = dir + "/" + grow + "_" + std::to_string(size) + ".tig";
+    FILE *source = fopen(fname.data(), "w");
+    if (!source || fwrite(program.data(), 1, program.size(), source) !=
+                       program.size()) {
+      perror(fname.data());
+      return 1;
+    }
+    fclose(source);
+
+    Run best{size, 0, program.size(), 0, UINT64_MAX, {}};
+    for (char c : program)
+      best.lines_ += c == '\n';
+    for (int i = 0; i < repeat; i++) {
+      FILE *assem = tmpfile();
+      stats::Reset();
+      auto start = std::chrono::steady_clock::now();
+      int status = driver::Compile(&reg_manager, fname, assem, stderr, options);
+      auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+      if (status != 0) {
+        fprintf(stderr, "%s does not compile\n", fname.data());
+        return 1;
+      }
+      // Keep the fastest of the repetitions, it is the least disturbed
+      if (static_cast<uint64_t>(wall_ns) < best.wall_ns_) {
+        best.wall_ns_ = wall_ns;
+        best.passes_ = stats::Totals();
+        best.instrs_ = CountInstrs(assem);
+      }
+      fclose(assem);
+    }
+    fprintf(stderr, "%s=%d: %llu lines, %.3f ms\n", grow, size,
+            (unsigned long long)best.lines_, best.wall_ns_ / 1e6);
+    runs.push_back(std::move(best));
+    if (!dump_dir)
+      remove(fname.data());
+  }
+  if (!dump_dir)
+    rmdir(dir.data());
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out) {
+    perror(out_path);
+    return 1;
+  }
+  WriteReport(out, shape, grow, repeat, runs);
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "tiger/bench/json.h"
+#include "tiger/bench/process.h"
+#include "tiger/driver/driver.h"
+#include "tiger/frame/x64frame.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void Usage() {
+  fprintf(stderr,
+          "usage: bench_run [options] [program...]\n"
+          "options: --corpus dir, --runtime runtime.c, --cc compiler,\n"
+          "         --repeat N, --keep dir, -o report.json,\n"
+          "         --compare baseline.json, --threshold PCT\n");
+  exit(1);
+}
+
+/* measurements of one program of the corpus */
+struct Program {
+  std::string name_;
+  bool ok_ = false;
+  uint64_t compile_ns_ = 0;
+  /* medians of the runs, except for the minimum of the wall time */
+  uint64_t wall_ns_ = 0;
+  uint64_t wall_min_ns_ = 0;
+  uint64_t user_ns_ = 0;
+  long max_rss_kb_ = 0;
+  std::optional<uint64_t> instructions_;
+  std::optional<uint64_t> cycles_;
+};
+
+/* result of a program against the baseline */
+struct Change {
+  std::string name_;
+  const char *metric_;
+  double baseline_;
+  double current_;
+  double percent_;
+  bool regression_;
+};
+
+template <typename T> T Median(std::vector<T> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+bool ReadFile(const fs::path &path, std::string &text) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+  std::ostringstream buffer;
+  buffer << in.rdbuf();
+  text = buffer.str();
+  return true;
+}
+
+/* the programs of the corpus, or the ones named on the command line */
+bool FindPrograms(const fs::path &corpus, const std::vector<std::string> &names,
+                  std::vector<std::string> &programs) {
+  std::error_code ec;
+  if (!names.empty()) {
+    for (const auto &name : names) {
+      if (!fs::exists(corpus / (name + ".tig"), ec)) {
+        fprintf(stderr, "%s: no program %s\n", corpus.c_str(), name.data());
+        return false;
+      }
+    }
+    programs = names;
+    return true;
+  }
+  for (const auto &entry : fs::directory_iterator(corpus, ec)) {
+    if (entry.path().extension() == ".tig")
+      programs.push_back(entry.path().stem());
+  }
+  std::sort(programs.begin(), programs.end());
+  if (ec || programs.empty()) {
+    fprintf(stderr, "%s: no programs\n", corpus.c_str());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Compile, link and run one program. A run fails when it is killed by a
+ * signal or prints something other than `<name>.out`; the exit code is
+ * whatever the program returns and is not checked.
+ */
+Program Measure(frame::RegManager *reg_manager, const fs::path &corpus,
+                const fs::path &work, const std::string &name,
+                const char *runtime, const char *cc, int repeat) {
+  Program program;
+  program.name_ = name;
+  fs::path source = corpus / (name + ".tig");
+  fs::path assem = work / (name + ".s");
+  fs::path exe = work / name;
+  fs::path output = work / (name + ".txt");
+
+  FILE *out = fopen(assem.c_str(), "w");
+  if (!out) {
+    perror(assem.c_str());
+    return program;
+  }
+  auto start = std::chrono::steady_clock::now();
+  int status = driver::Compile(reg_manager, source.native(), out, stderr,
+                               driver::Options());
+  program.compile_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  fclose(out);
+  if (status != 0) {
+    fprintf(stderr, "%s does not compile\n", source.c_str());
+    return program;
+  }
+
+  // The runtime wraps getchar to read input a line at a time
+  bench::RunResult result;
+  if (!bench::RunProgram({cc, "-m64", "-Wl,--wrap,getchar", "-Wl,-z,noexecstack",
+                          "-o", exe.native(), assem.native(), runtime},
+                         nullptr, nullptr, result) ||
+      !WIFEXITED(result.status_) || WEXITSTATUS(result.status_) != 0) {
+    fprintf(stderr, "%s does not link\n", assem.c_str());
+    return program;
+  }
+
+  std::error_code ec;
+  fs::path input = corpus / (name + ".in");
+  bool has_input = fs::exists(input, ec);
+  std::string expected;
+  bool has_expected = ReadFile(corpus / (name + ".out"), expected);
+  std::vector<uint64_t> wall, user, instructions, cycles;
+  for (int i = 0; i < repeat; i++) {
+    if (!bench::RunProgram({exe.native()}, has_input ? input.c_str() : nullptr,
+                           output.c_str(), result)) {
+      perror(exe.c_str());
+      return program;
+    }
+    if (WIFSIGNALED(result.status_)) {
+      fprintf(stderr, "%s: killed by signal %d\n", name.data(),
+              WTERMSIG(result.status_));
+      return program;
+    }
+    std::string actual;
+    if (has_expected && (!ReadFile(output, actual) || actual != expected)) {
+      fprintf(stderr, "%s: wrong output, see %s\n", name.data(),
+              output.c_str());
+      return program;
+    }
+    wall.push_back(result.wall_ns_);
+    user.push_back(result.user_ns_);
+    program.max_rss_kb_ = std::max(program.max_rss_kb_, result.max_rss_kb_);
+    if (result.instructions_)
+      instructions.push_back(*result.instructions_);
+    if (result.cycles_)
+      cycles.push_back(*result.cycles_);
+  }
+
+  program.ok_ = true;
+  program.wall_ns_ = Median(wall);
+  program.wall_min_ns_ = *std::min_element(wall.begin(), wall.end());
+  program.user_ns_ = Median(user);
+  // Counters which could not be read in every run are left out
+  if (instructions.size() == wall.size())
+    program.instructions_ = Median(instructions);
+  if (cycles.size() == wall.size())
+    program.cycles_ = Median(cycles);
+  return program;
+}
+
+/**
+ * Compare with a baseline report. Instruction counts are preferred where
+ * both reports have them, they hardly vary between runs; otherwise the
+ * median wall time is compared.
+ * @return false if the baseline cannot be read
+ */
+bool Compare(const char *baseline_path, double threshold,
+             const std::vector<Program> &programs,
+             std::vector<Change> &changes) {
+  std::string text;
+  bench::JsonValue baseline;
+  if (!ReadFile(baseline_path, text) || !bench::ParseJson(text, baseline)) {
+    fprintf(stderr, "%s: not a report of bench_run\n", baseline_path);
+    return false;
+  }
+  const bench::JsonValue *list = baseline.Find("programs");
+  if (!list || list->kind_ != bench::JsonValue::ARRAY) {
+    fprintf(stderr, "%s: not a report of bench_run\n", baseline_path);
+    return false;
+  }
+
+  for (const auto &program : programs) {
+    const bench::JsonValue *base = nullptr;
+    for (const auto &entry : list->array_) {
+      const bench::JsonValue *name = entry.Find("name");
+      if (name && name->string_ == program.name_)
+        base = &entry;
+    }
+    const bench::JsonValue *ok = base ? base->Find("ok") : nullptr;
+    if (!program.ok_ || !ok || !ok->bool_)
+      continue;
+
+    Change change{program.name_, "wall_ns", 0, 0, 0, false};
+    const bench::JsonValue *instructions = base->Find("instructions");
+    const bench::JsonValue *wall = base->Find("wall_ns");
+    if (program.instructions_ && instructions && instructions->IsNumber()) {
+      change.metric_ = "instructions";
+      change.baseline_ = instructions->number_;
+      change.current_ = *program.instructions_;
+    } else if (wall && wall->IsNumber()) {
+      change.baseline_ = wall->number_;
+      change.current_ = program.wall_ns_;
+    } else {
+      continue;
+    }
+    if (change.baseline_ <= 0)
+      continue;
+    change.percent_ = (change.current_ / change.baseline_ - 1) * 100;
+    change.regression_ = change.percent_ > threshold;
+    changes.push_back(change);
+  }
+  return true;
+}
+
+void WriteReport(FILE *out, int repeat, const std::vector<Program> &programs,
+                 const char *baseline, double threshold,
+                 const std::vector<Change> &changes) {
+  bench::JsonWriter json(out);
+  json.BeginObject();
+  json.Key("benchmark").String("run");
+  json.Key("version").String(TIGER_VERSION);
+  json.Key("repeat").Int(repeat);
+  json.Key("programs").BeginArray();
+  for (const auto &program : programs) {
+    json.BeginObject();
+    json.Key("name").String(program.name_);
+    json.Key("ok").Bool(program.ok_);
+    json.Key("compile_ns").Int(program.compile_ns_);
+    json.Key("wall_ns").Int(program.wall_ns_);
+    json.Key("wall_min_ns").Int(program.wall_min_ns_);
+    json.Key("user_ns").Int(program.user_ns_);
+    json.Key("max_rss_kb").Int(program.max_rss_kb_);
+    if (program.instructions_)
+      json.Key("instructions").Int(*program.instructions_);
+    else
+      json.Key("instructions").Null();
+    if (program.cycles_)
+      json.Key("cycles").Int(*program.cycles_);
+    else
+      json.Key("cycles").Null();
+    json.EndObject();
+  }
+  json.EndArray();
+
+  if (baseline) {
+    json.Key("comparison").BeginObject();
+    json.Key("baseline").String(baseline);
+    json.Key("threshold_pct").Double(threshold);
+    json.Key("programs").BeginArray();
+    for (const auto &change : changes) {
+      json.BeginObject();
+      json.Key("name").String(change.name_);
+      json.Key("metric").String(change.metric_);
+      json.Key("baseline").Double(change.baseline_);
+      json.Key("current").Double(change.current_);
+      json.Key("change_pct").Double(change.percent_);
+      json.Key("regression").Bool(change.regression_);
+      json.EndObject();
+    }
+    json.EndArray();
+    json.EndObject();
+  }
+  json.EndObject();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string corpus = TIGER_SOURCE_DIR "/testdata/bench";
+  std::string runtime = TIGER_SOURCE_DIR "/src/tiger/runtime/runtime.c";
+  const char *cc = "gcc";
+  int repeat = 5;
+  const char *keep_dir = nullptr;
+  const char *out_path = nullptr;
+  const char *baseline = nullptr;
+  double threshold = 5;
+  std::vector<std::string> names;
+  for (int argi = 1; argi < argc; argi++) {
+    const char *arg = argv[argi];
+    if (arg[0] != '-') {
+      names.push_back(arg);
+      continue;
+    }
+    if (++argi >= argc)
+      Usage();
+    const char *value = argv[argi];
+    if (strcmp(arg, "--corpus") == 0) {
+      corpus = value;
+    } else if (strcmp(arg, "--runtime") == 0) {
+      runtime = value;
+    } else if (strcmp(arg, "--cc") == 0) {
+      cc = value;
+    } else if (strcmp(arg, "--repeat") == 0) {
+      repeat = std::max(1, atoi(value));
+    } else if (strcmp(arg, "--keep") == 0) {
+      keep_dir = value;
+    } else if (strcmp(arg, "-o") == 0) {
+      out_path = value;
+    } else if (strcmp(arg, "--compare") == 0) {
+      baseline = value;
+    } else if (strcmp(arg, "--threshold") == 0) {
+      threshold = atof(value);
+    } else {
+      Usage();
+    }
+  }
+
+  std::vector<std::string> programs;
+  if (!FindPrograms(corpus, names, programs))
+    return 1;
+
+  // Assembly, executables and outputs go to a directory of their own
+  std::string work = keep_dir ? keep_dir : "";
+  std::error_code ec;
+  if (work.empty()) {
+    char tmp[] = "/tmp/bench_run.XXXXXX";
+    if (!mkdtemp(tmp)) {
+      perror("mkdtemp");
+      return 1;
+    }
+    work = tmp;
+  } else if (!fs::create_directories(work, ec) && ec) {
+    fprintf(stderr, "%s: %s\n", work.data(), ec.message().data());
+    return 1;
+  }
+
+  frame::X64RegManager reg_manager;
+  std::vector<Program> results;
+  int failures = 0;
+  for (const auto &name : programs) {
+    results.push_back(Measure(&reg_manager, corpus, work, name, runtime.data(),
+                              cc, repeat));
+    const Program &program = results.back();
+    failures += !program.ok_;
+    if (program.ok_)
+      fprintf(stderr, "%-12s %9.3f ms", name.data(), program.wall_ns_ / 1e6);
+    if (program.ok_ && program.instructions_)
+      fprintf(stderr, "  %llu instructions",
+              (unsigned long long)*program.instructions_);
+    if (program.ok_)
+      fputc('\n', stderr);
+  }
+  if (!keep_dir)
+    fs::remove_all(work, ec);
+
+  std::vector<Change> changes;
+  if (baseline && !Compare(baseline, threshold, results, changes))
+    return 1;
+  int regressions = 0;
+  for (const auto &change : changes) {
+    regressions += change.regression_;
+    fprintf(stderr, "%-12s %-12s %+7.2f%%%s\n", change.name_.data(),
+            change.metric_, change.percent_,
+            change.regression_ ? "  REGRESSION" : "");
+  }
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out) {
+    perror(out_path);
+    return 1;
+  }
+  WriteReport(out, repeat, results, baseline, threshold, changes);
+  if (out != stdout)
+    fclose(out);
+  if (failures)
+    fprintf(stderr, "%d programs failed\n", failures);
+  if (regressions)
+    fprintf(stderr, "%d programs regressed by more than %g%%\n", regressions,
+            threshold);
+  return failures || regressions ? 1 : 0;
+}
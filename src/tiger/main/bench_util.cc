@@ -0,0 +1,600 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tiger/bench/args.h"
+#include "tiger/bench/json.h"
+#include "tiger/frame/temp.h"
+#include "tiger/liveness/liveness.h"
+#include "tiger/stats/stats.h"
+#include "tiger/symbol/symbol.h"
+#include "tiger/util/graph.h"
+#include "tiger/util/table.h"
+
+namespace {
+
+void Usage() {
+  fprintf(stderr,
+          "usage: bench_util [options] [case...]\n"
+          "options: --sizes N,N,..., --repeat N, --budget STEPS, --seed N,\n"
+          "         -o report.json\n"
+          "cases are selected by prefix, e.g. `table` or `tempset.union`\n");
+  exit(1);
+}
+
+using Graph = graph::Graph<temp::Temp>;
+using Node = graph::Node<temp::Temp>;
+using NodeList = graph::NodeList<temp::Temp>;
+
+/**
+ * One micro-benchmark. `run` builds its data with the timer paused, resumes
+ * it around the operations being measured and returns how many there were.
+ */
+struct Case {
+  const char *name_;
+  /* element steps of one run at size n, to skip runs over the budget */
+  std::function<double(double n)> cost_;
+  std::function<uint64_t(int n, stats::PassTimer &timer)> run_;
+};
+
+struct Result {
+  std::string name_;
+  int size_;
+  bool skipped_;
+  uint64_t ops_;
+  double ns_per_op_;
+  double allocs_per_op_;
+  double bytes_per_op_;
+};
+
+/* inputs of the benchmarks, the same for every run of a seed */
+class Inputs {
+public:
+  explicit Inputs(uint64_t seed) : random_(seed) {}
+
+  /* n temps made once and shared by the cases */
+  const std::vector<temp::Temp *> &Temps(int n) {
+    while (static_cast<int>(temps_.size()) < n)
+      temps_.push_back(temp::TempFactory::NewTemp());
+    temps_view_.assign(temps_.begin(), temps_.begin() + n);
+    return temps_view_;
+  }
+
+  /* the first n temps in random order */
+  std::vector<temp::Temp *> Shuffled(int n) {
+    std::vector<temp::Temp *> temps = Temps(n);
+    std::shuffle(temps.begin(), temps.end(), random_);
+    return temps;
+  }
+
+  /* in [0, n) */
+  int Below(int n) { return static_cast<int>(random_() % n); }
+
+private:
+  std::mt19937_64 random_;
+  std::vector<temp::Temp *> temps_;
+  std::vector<temp::Temp *> temps_view_;
+};
+
+/* a list of the temps in the given range */
+temp::TempList *MakeTempList(const std::vector<temp::Temp *> &temps,
+                             int begin, int end) {
+  auto list = new temp::TempList();
+  for (int i = begin; i < end; i++)
+    list->Append(temps[i]);
+  return list;
+}
+
+/* a set of the temps in the given range */
+temp::TempSet MakeTempSet(const std::vector<temp::Temp *> &temps, int begin,
+                          int end) {
+  auto list = MakeTempList(temps, begin, end);
+  temp::TempSet set(list);
+  delete list;
+  return set;
+}
+
+/* a graph over n temps with about `degree` random edges out of each node */
+Graph *MakeGraph(Inputs &inputs, int n, int degree,
+                 std::vector<Node *> &nodes) {
+  auto g = new Graph();
+  nodes.clear();
+  for (auto t : inputs.Temps(n))
+    nodes.push_back(g->NewNode(t));
+  for (int i = 0; i < n * degree; i++)
+    g->AddEdge(nodes[inputs.Below(n)], nodes[inputs.Below(n)]);
+  return g;
+}
+
+/* an interference graph of n nodes without edges */
+live::IGraph *MakeIGraph(Inputs &inputs, int n,
+                         std::vector<live::INode *> &nodes) {
+  auto g = new live::IGraph();
+  nodes.clear();
+  for (auto t : inputs.Temps(n))
+    nodes.push_back(g->NewNode(t, false));
+  return g;
+}
+
+/* a move list of n moves between random nodes */
+live::MoveList *MakeMoveList(Inputs &inputs,
+                             const std::vector<live::INode *> &nodes, int n) {
+  auto moves = new live::MoveList();
+  for (int i = 0; i < n; i++)
+    moves->Append(nodes[inputs.Below(static_cast<int>(nodes.size()))],
+                  nodes[inputs.Below(static_cast<int>(nodes.size()))]);
+  return moves;
+}
+
+/* queries of the linear-time operations, as many as the budget allows */
+int Queries(int n) { return std::clamp(10000000 / std::max(n, 1), 1, n); }
+
+std::vector<Case> Cases(Inputs &inputs) {
+  // Each interference node gets this many edges, about what a function with
+  // a few dozen live temps gives
+  const int kDegree = 4;
+  auto linear = [](double n) { return n; };
+  auto quadratic = [](double n) { return n * n; };
+  auto queries = [](double n) { return n * Queries(static_cast<int>(n)); };
+  using Table = tab::Table<temp::Temp, temp::Temp>;
+
+  return {
+      {"table.enter", linear,
+       [&](int n, stats::PassTimer &timer) {
+         const auto &temps = inputs.Temps(n);
+         Table table;
+         timer.Resume();
+         for (auto t : temps)
+           table.Enter(t, t);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"table.look", linear,
+       [&](int n, stats::PassTimer &timer) {
+         Table table;
+         for (auto t : inputs.Temps(n))
+           table.Enter(t, t);
+         auto keys = inputs.Shuffled(n);
+         timer.Resume();
+         for (auto t : keys) {
+           if (table.Look(t) != t)
+             abort();
+         }
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"table.pop", linear,
+       [&](int n, stats::PassTimer &timer) {
+         Table table;
+         for (auto t : inputs.Temps(n))
+           table.Enter(t, t);
+         timer.Resume();
+         for (int i = 0; i < n; i++)
+           table.Pop();
+         timer.Pause();
+         return uint64_t(n);
+       }},
+
+      {"templist.append", linear,
+       [&](int n, stats::PassTimer &timer) {
+         const auto &temps = inputs.Temps(n);
+         temp::TempList list;
+         timer.Resume();
+         for (auto t : temps)
+           list.Append(t);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"templist.contain", queries,
+       [&](int n, stats::PassTimer &timer) {
+         auto list = MakeTempList(inputs.Temps(n), 0, n);
+         auto keys = inputs.Shuffled(n);
+         int queries = Queries(n);
+         timer.Resume();
+         for (int i = 0; i < queries; i++) {
+           if (!list->Contain(keys[i]))
+             abort();
+         }
+         timer.Pause();
+         delete list;
+         return uint64_t(queries);
+       }},
+      {"templist.delete", quadratic,
+       [&](int n, stats::PassTimer &timer) {
+         auto list = MakeTempList(inputs.Temps(n), 0, n);
+         auto keys = inputs.Shuffled(n);
+         timer.Resume();
+         for (auto t : keys)
+           list->Delete(t);
+         timer.Pause();
+         delete list;
+         return uint64_t(n);
+       }},
+
+      {"tempset.insert", quadratic,
+       [&](int n, stats::PassTimer &timer) {
+         auto keys = inputs.Shuffled(n);
+         temp::TempSet set;
+         timer.Resume();
+         for (auto t : keys)
+           set.Insert(t);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"tempset.contain", queries,
+       [&](int n, stats::PassTimer &timer) {
+         auto set = MakeTempSet(inputs.Temps(n), 0, n);
+         auto keys = inputs.Shuffled(n);
+         int queries = Queries(n);
+         timer.Resume();
+         for (int i = 0; i < queries; i++) {
+           if (!set.Contain(keys[i]))
+             abort();
+         }
+         timer.Pause();
+         return uint64_t(queries);
+       }},
+      {"tempset.union", linear,
+       [&](int n, stats::PassTimer &timer) {
+         // Halves overlapping by half, like live sets of neighbouring
+         // instructions; one operation per element of the result
+         auto temps = inputs.Shuffled(n);
+         auto a = MakeTempSet(temps, 0, n * 3 / 4);
+         auto b = MakeTempSet(temps, n / 4, n);
+         timer.Resume();
+         a.UnionWith(b);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"tempset.diff", linear,
+       [&](int n, stats::PassTimer &timer) {
+         auto temps = inputs.Shuffled(n);
+         auto a = MakeTempSet(temps, 0, n * 3 / 4);
+         auto b = MakeTempSet(temps, n / 4, n);
+         timer.Resume();
+         a.DiffWith(b);
+         timer.Pause();
+         return uint64_t(n * 3 / 4);
+       }},
+
+      {"graph.newnode", linear,
+       [&](int n, stats::PassTimer &timer) {
+         const auto &temps = inputs.Temps(n);
+         Graph g;
+         timer.Resume();
+         for (auto t : temps)
+           g.NewNode(t);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"graph.addedge", [=](double n) { return n * kDegree * kDegree; },
+       [&](int n, stats::PassTimer &timer) {
+         Graph g;
+         std::vector<Node *> nodes;
+         for (auto t : inputs.Temps(n))
+           nodes.push_back(g.NewNode(t));
+         std::vector<std::pair<Node *, Node *>> edges;
+         for (int i = 0; i < n * kDegree; i++)
+           edges.emplace_back(nodes[inputs.Below(n)], nodes[inputs.Below(n)]);
+         timer.Resume();
+         for (auto [from, to] : edges)
+           g.AddEdge(from, to);
+         timer.Pause();
+         return uint64_t(edges.size());
+       }},
+      {"graph.goesto", [=](double n) { return n * kDegree; },
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<Node *> nodes;
+         std::unique_ptr<Graph> g(MakeGraph(inputs, n, kDegree, nodes));
+         std::vector<std::pair<Node *, Node *>> queries;
+         for (int i = 0; i < n; i++)
+           queries.emplace_back(nodes[inputs.Below(n)], nodes[inputs.Below(n)]);
+         timer.Resume();
+         int edges = 0;
+         for (auto [from, to] : queries)
+           edges += from->GoesTo(to);
+         timer.Pause();
+         if (edges > n)
+           abort();
+         return uint64_t(n);
+       }},
+      {"graph.adj", [=](double n) { return n * kDegree * kDegree; },
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<Node *> nodes;
+         std::unique_ptr<Graph> g(MakeGraph(inputs, n, kDegree, nodes));
+         std::vector<NodeList *> adjacent;
+         timer.Resume();
+         for (auto node : nodes)
+           adjacent.push_back(node->Adj());
+         timer.Pause();
+         for (auto list : adjacent)
+           delete list;
+         return uint64_t(n);
+       }},
+      {"nodelist.union", quadratic,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<Node *> nodes;
+         std::unique_ptr<Graph> g(MakeGraph(inputs, n, 0, nodes));
+         std::shuffle(nodes.begin(), nodes.end(), std::mt19937_64(n));
+         NodeList a, b;
+         for (int i = 0; i < n * 3 / 4; i++)
+           a.Append(nodes[i]);
+         for (int i = n / 4; i < n; i++)
+           b.Append(nodes[i]);
+         timer.Resume();
+         auto result = a.Union(&b);
+         timer.Pause();
+         delete result;
+         return uint64_t(n);
+       }},
+      {"nodelist.diff", quadratic,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<Node *> nodes;
+         std::unique_ptr<Graph> g(MakeGraph(inputs, n, 0, nodes));
+         std::shuffle(nodes.begin(), nodes.end(), std::mt19937_64(n));
+         NodeList a, b;
+         for (int i = 0; i < n * 3 / 4; i++)
+           a.Append(nodes[i]);
+         for (int i = n / 4; i < n; i++)
+           b.Append(nodes[i]);
+         timer.Resume();
+         auto result = a.Diff(&b);
+         timer.Pause();
+         delete result;
+         return uint64_t(n * 3 / 4);
+       }},
+
+      // The adjacency matrix of n nodes takes n * n / 2 bits
+      {"igraph.addedge", quadratic,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<live::INode *> nodes;
+         std::unique_ptr<live::IGraph> g(MakeIGraph(inputs, n, nodes));
+         std::vector<std::pair<live::INode *, live::INode *>> edges;
+         for (int i = 0; i < n * kDegree; i++)
+           edges.emplace_back(nodes[inputs.Below(n)], nodes[inputs.Below(n)]);
+         timer.Resume();
+         for (auto [u, v] : edges)
+           g->AddEdge(u, v);
+         timer.Pause();
+         return uint64_t(edges.size());
+       }},
+      {"igraph.adjacent", quadratic,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<live::INode *> nodes;
+         std::unique_ptr<live::IGraph> g(MakeIGraph(inputs, n, nodes));
+         for (int i = 0; i < n * kDegree; i++)
+           g->AddEdge(nodes[inputs.Below(n)], nodes[inputs.Below(n)]);
+         std::vector<std::pair<live::INode *, live::INode *>> queries;
+         for (int i = 0; i < n; i++)
+           queries.emplace_back(nodes[inputs.Below(n)], nodes[inputs.Below(n)]);
+         timer.Resume();
+         int edges = 0;
+         for (auto [u, v] : queries)
+           edges += g->Adjacent(u, v);
+         timer.Pause();
+         if (edges > n)
+           abort();
+         return uint64_t(n);
+       }},
+
+      {"symbol.intern", linear,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<std::string> names;
+         for (int i = 0; i < n; i++)
+           names.push_back("name" + std::to_string(i));
+         sym::SymbolPool pool;
+         timer.Resume();
+         for (const auto &name : names)
+           pool.Intern(name);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"symbol.lookup", linear,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<std::string> names;
+         for (int i = 0; i < n; i++)
+           names.push_back("name" + std::to_string(i));
+         sym::SymbolPool pool;
+         for (const auto &name : names)
+           pool.Intern(name);
+         std::shuffle(names.begin(), names.end(), std::mt19937_64(n));
+         timer.Resume();
+         for (const auto &name : names)
+           pool.Intern(name);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"symbol.label", linear,
+       [&](int n, stats::PassTimer &timer) {
+         timer.Resume();
+         for (int i = 0; i < n; i++)
+           temp::LabelFactory::NewLabel();
+         timer.Pause();
+         return uint64_t(n);
+       }},
+
+      {"movelist.append", linear,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<live::INode *> nodes;
+         std::unique_ptr<live::IGraph> g(MakeIGraph(inputs, n, nodes));
+         live::MoveList moves;
+         timer.Resume();
+         for (int i = 0; i < n; i++)
+           moves.Append(nodes[i], nodes[n - 1 - i]);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"movelist.contain", queries,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<live::INode *> nodes;
+         std::unique_ptr<live::IGraph> g(MakeIGraph(inputs, n, nodes));
+         std::unique_ptr<live::MoveList> moves(MakeMoveList(inputs, nodes, n));
+         int queries = Queries(n);
+         timer.Resume();
+         int found = 0;
+         for (int i = 0; i < queries; i++)
+           found += moves->Contain(nodes[inputs.Below(n)],
+                                   nodes[inputs.Below(n)]);
+         timer.Pause();
+         if (found > queries)
+           abort();
+         return uint64_t(queries);
+       }},
+      {"movelist.union", quadratic,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<live::INode *> nodes;
+         std::unique_ptr<live::IGraph> g(MakeIGraph(inputs, n, nodes));
+         std::unique_ptr<live::MoveList> a(MakeMoveList(inputs, nodes, n));
+         std::unique_ptr<live::MoveList> b(MakeMoveList(inputs, nodes, n));
+         timer.Resume();
+         std::unique_ptr<live::MoveList> result(a->Union(b.get()));
+         timer.Pause();
+         return uint64_t(n);
+       }},
+      {"movelist.delete", quadratic,
+       [&](int n, stats::PassTimer &timer) {
+         std::vector<live::INode *> nodes;
+         std::unique_ptr<live::IGraph> g(MakeIGraph(inputs, n, nodes));
+         std::unique_ptr<live::MoveList> moves(MakeMoveList(inputs, nodes, n));
+         std::vector<std::pair<live::INode *, live::INode *>> order(
+             moves->GetList().begin(), moves->GetList().end());
+         std::shuffle(order.begin(), order.end(), std::mt19937_64(n));
+         timer.Resume();
+         for (auto [src, dst] : order)
+           moves->Delete(src, dst);
+         timer.Pause();
+         return uint64_t(n);
+       }},
+  };
+}
+
+bool Selected(const char *name, const std::vector<const char *> &filters) {
+  if (filters.empty())
+    return true;
+  for (const char *filter : filters) {
+    if (strncmp(name, filter, strlen(filter)) == 0)
+      return true;
+  }
+  return false;
+}
+
+void WriteReport(FILE *out, uint64_t seed, int repeat, double budget,
+                 const std::vector<Result> &results) {
+  bench::JsonWriter json(out);
+  json.BeginObject();
+  json.Key("benchmark").String("util");
+  json.Key("version").String(TIGER_VERSION);
+  json.Key("seed").Int(static_cast<int64_t>(seed));
+  json.Key("repeat").Int(repeat);
+  json.Key("budget").Double(budget);
+  json.Key("results").BeginArray();
+  for (const auto &result : results) {
+    json.BeginObject();
+    json.Key("case").String(result.name_);
+    json.Key("size").Int(result.size_);
+    json.Key("skipped").Bool(result.skipped_);
+    if (!result.skipped_) {
+      json.Key("ops").Int(result.ops_);
+      json.Key("ns_per_op").Double(result.ns_per_op_);
+      json.Key("allocs_per_op").Double(result.allocs_per_op_);
+      json.Key("bytes_per_op").Double(result.bytes_per_op_);
+    }
+    json.EndObject();
+  }
+  json.EndArray();
+  json.EndObject();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::vector<int> sizes = {10, 100, 1000, 10000, 100000};
+  int repeat = 5;
+  double budget = 2e9;
+  uint64_t seed = 1;
+  const char *out_path = nullptr;
+  std::vector<const char *> filters;
+  for (int argi = 1; argi < argc; argi++) {
+    const char *arg = argv[argi];
+    if (arg[0] != '-') {
+      filters.push_back(arg);
+      continue;
+    }
+    if (++argi >= argc)
+      Usage();
+    const char *value = argv[argi];
+    if (strcmp(arg, "--sizes") == 0) {
+      // every case needs at least one element
+      if (!bench::ParseSizes(value, 1, sizes))
+        Usage();
+    } else if (strcmp(arg, "--repeat") == 0) {
+      repeat = std::max(1, atoi(value));
+    } else if (strcmp(arg, "--budget") == 0) {
+      budget = atof(value);
+    } else if (strcmp(arg, "--seed") == 0) {
+      seed = strtoull(value, nullptr, 10);
+    } else if (strcmp(arg, "-o") == 0) {
+      out_path = value;
+    } else {
+      Usage();
+    }
+  }
+
+  // Every case is one pass of the statistics, which count time and heap
+  // allocations while its timer runs
+  stats::Enable(true, true);
+  Inputs inputs(seed);
+  std::vector<Result> results;
+  for (const auto &bench_case : Cases(inputs)) {
+    if (!Selected(bench_case.name_, filters))
+      continue;
+    for (int size : sizes) {
+      Result result{bench_case.name_, size, true, 0, 0, 0, 0};
+      if (bench_case.cost_(size) > budget) {
+        fprintf(stderr, "%-18s %7d  skipped, over the budget\n",
+                bench_case.name_, size);
+        results.push_back(result);
+        continue;
+      }
+      // Keep the fastest of the repetitions, allocations do not vary
+      result.skipped_ = false;
+      result.ns_per_op_ = INFINITY;
+      for (int i = 0; i < repeat; i++) {
+        stats::Reset();
+        uint64_t ops;
+        {
+          stats::PassTimer timer(bench_case.name_, {}, 0, false);
+          ops = bench_case.run_(size, timer);
+        }
+        std::vector<stats::PassTotal> totals = stats::Totals();
+        if (totals.empty() || ops == 0)
+          continue;
+        result.ops_ = ops;
+        result.ns_per_op_ =
+            std::min(result.ns_per_op_, double(totals[0].ns_) / ops);
+        result.allocs_per_op_ = double(totals[0].allocs_) / ops;
+        result.bytes_per_op_ = double(totals[0].bytes_) / ops;
+      }
+      fprintf(stderr, "%-18s %7d %12.1f ns/op %8.2f allocs/op\n",
+              bench_case.name_, size, result.ns_per_op_,
+              result.allocs_per_op_);
+      results.push_back(result);
+    }
+  }
+
+  FILE *out = out_path ? fopen(out_path, "w") : stdout;
+  if (!out) {
+    perror(out_path);
+    return 1;
+  }
+  WriteReport(out, seed, repeat, budget, results);
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
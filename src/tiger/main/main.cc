@@ -1,74 +1,206 @@
-#include "tiger/absyn/absyn.h"
-#include "tiger/escape/escape.h"
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tiger/cache/cache.h"
+#include "tiger/driver/driver.h"
+#include "tiger/driver/server.h"
 #include "tiger/frame/x64frame.h"
-#include "tiger/output/logger.h"
-#include "tiger/output/output.h"
-#include "tiger/parse/parser.h"
-#include "tiger/translate/translate.h"
-#include "tiger/semant/semant.h"
+#include "tiger/stats/stats.h"
 
-frame::RegManager *reg_manager;
-frame::Frags *frags;
+namespace {
 
-int main(int argc, char **argv) {
-  std::string_view fname;
-  std::unique_ptr<absyn::AbsynTree> absyn_tree;
-  reg_manager = new frame::X64RegManager();
-  frags = new frame::Frags();
+void Usage() {
+  fprintf(stderr, "usage: tiger-compiler [options] file.tig\n"
+                  "       tiger-compiler [-j N] --batch file.tig... | "
+                  "@filelist\n"
+                  "       tiger-compiler [-j N] --server socket\n"
+                  "       tiger-compiler --client socket [-o out.s] "
+                  "file.tig | -\n"
+                  "       tiger-compiler --shutdown socket\n"
+                  "options: -c|--emit-obj, -j N, --time-passes[=json], "
+                  "--mem-passes[=json],\n"
+                  "         --cache-dir dir, --cache-size N[K|M|G], "
+                  "--cache-stats, --mmap-output,\n"
+                  "         -O0|--ra=linear|--ra=coloring, --ra-max-nodes N\n");
+  exit(1);
+}
 
-  if (argc < 2) {
-    fprintf(stderr, "usage: tiger-compiler file.tig\n");
-    exit(1);
+/**
+ * Parse a size such as 64M
+ * @return size in bytes, 0 if malformed
+ */
+uint64_t ParseSize(const char *text) {
+  char *end;
+  uint64_t size = strtoull(text, &end, 10);
+  switch (*end) {
+  case 'G': size <<= 10; [[fallthrough]];
+  case 'M': size <<= 10; [[fallthrough]];
+  case 'K': size <<= 10; end++; break;
+  default: break;
   }
+  return *end == '\0' ? size : 0;
+}
 
-  fname = std::string_view(argv[1]);
-
-  {
-    std::unique_ptr<err::ErrorMsg> errormsg;
+} // namespace
 
-    {
-      // Lab 3: parsing
-      TigerLog("-------====Parse=====-----\n");
-      Parser parser(fname, std::cerr);
-      parser.parse();
-      absyn_tree = parser.TransferAbsynTree();
-      errormsg = parser.TransferErrormsg();
+int main(int argc, char **argv) {
+  // Number of threads, 0 means one per core. In batch and server modes they
+  // compile programs, otherwise they run the backend of the only program.
+  // A server takes one per core unless told otherwise.
+  int jobs = 1;
+  bool jobs_given = false;
+  bool batch = false;
+  const char *server_socket = nullptr;
+  const char *client_socket = nullptr;
+  const char *out_path = nullptr;
+  bool time_passes = false, mem_passes = false, json_report = false;
+  const char *cache_dir = nullptr;
+  uint64_t cache_size = 256ULL << 20;
+  bool cache_stats = false;
+  bool emit_obj = false;
+  bool mmap_output = false;
+  ra::Options ra_options;
+  int argi = 1;
+  while (argi < argc && argv[argi][0] == '-') {
+    if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+      jobs = atoi(argv[argi + 1]);
+      jobs_given = true;
+      argi += 2;
+    } else if (strncmp(argv[argi], "-j", 2) == 0 && argv[argi][2] != '\0') {
+      jobs = atoi(argv[argi] + 2);
+      jobs_given = true;
+      argi += 1;
+    } else if (strcmp(argv[argi], "-c") == 0 ||
+               strcmp(argv[argi], "--emit-obj") == 0) {
+      emit_obj = true;
+      argi += 1;
+    } else if (strcmp(argv[argi], "--mmap-output") == 0) {
+      mmap_output = true;
+      argi += 1;
+    } else if (strcmp(argv[argi], "-O0") == 0 ||
+               strcmp(argv[argi], "--ra=linear") == 0) {
+      ra_options.allocator = ra::Allocator::LINEAR;
+      argi += 1;
+    } else if (strcmp(argv[argi], "--ra=coloring") == 0) {
+      ra_options.allocator = ra::Allocator::COLORING;
+      argi += 1;
+    } else if (strcmp(argv[argi], "--ra-max-nodes") == 0 && argi + 1 < argc) {
+      // 0 colors functions of any size
+      ra_options.max_graph_nodes = atoi(argv[argi + 1]);
+      if (ra_options.max_graph_nodes < 0)
+        Usage();
+      argi += 2;
+    } else if (strcmp(argv[argi], "--batch") == 0) {
+      batch = true;
+      argi += 1;
+    } else if (strcmp(argv[argi], "--server") == 0 && argi + 1 < argc) {
+      server_socket = argv[argi + 1];
+      argi += 2;
+    } else if (strcmp(argv[argi], "--client") == 0 && argi + 1 < argc) {
+      client_socket = argv[argi + 1];
+      argi += 2;
+    } else if (strcmp(argv[argi], "--shutdown") == 0 && argi + 1 < argc) {
+      return driver::StopServer(argv[argi + 1]);
+    } else if (strcmp(argv[argi], "-o") == 0 && argi + 1 < argc) {
+      out_path = argv[argi + 1];
+      argi += 2;
+    } else if (strncmp(argv[argi], "--time-passes", 13) == 0 ||
+               strncmp(argv[argi], "--mem-passes", 12) == 0) {
+      bool time = argv[argi][2] == 't';
+      const char *value = argv[argi] + (time ? 13 : 12);
+      if (*value != '\0' && strcmp(value, "=json") != 0)
+        Usage();
+      json_report |= *value != '\0';
+      time_passes |= time;
+      mem_passes |= !time;
+      argi += 1;
+    } else if (strcmp(argv[argi], "--cache-dir") == 0 && argi + 1 < argc) {
+      cache_dir = argv[argi + 1];
+      argi += 2;
+    } else if (strcmp(argv[argi], "--cache-size") == 0 && argi + 1 < argc) {
+      cache_size = ParseSize(argv[argi + 1]);
+      if (cache_size == 0)
+        Usage();
+      argi += 2;
+    } else if (strcmp(argv[argi], "--cache-stats") == 0) {
+      cache_stats = true;
+      argi += 1;
+    } else if (strcmp(argv[argi], "-") == 0) {
+      break; // standard input for the client
+    } else {
+      Usage();
     }
+  }
+  if (server_socket && !jobs_given)
+    jobs = 0;
+  if (jobs <= 0)
+    jobs = std::max(1U, std::thread::hardware_concurrency());
+  if (time_passes || mem_passes)
+    stats::Enable(time_passes, mem_passes);
 
-    {
-      // Lab 4: semantic analysis
-      TigerLog("-------====Semantic analysis=====-----\n");
-      sem::ProgSem prog_sem(std::move(absyn_tree), std::move(errormsg));
-      prog_sem.SemAnalyze();
-      absyn_tree = prog_sem.TransferAbsynTree();
-      errormsg = prog_sem.TransferErrormsg();
-    }
+  if (client_socket) {
+    if (argi + 1 != argc)
+      Usage();
+    std::string out = out_path ? out_path
+                      : strcmp(argv[argi], "-") == 0
+                          ? "-"
+                          : std::string(argv[argi]) + ".s";
+    return driver::RunClient(client_socket, argv[argi], out);
+  }
 
-    {
-      // Lab 5: escape analysis
-      TigerLog("-------====Escape analysis=====-----\n");
-      esc::EscFinder esc_finder(std::move(absyn_tree));
-      esc_finder.FindEscape();
-      absyn_tree = esc_finder.TransferAbsynTree();
-    }
+  // Shared by every compilation in this process
+  frame::X64RegManager reg_manager;
+  std::unique_ptr<cache::AssemCache> assem_cache;
+  if (cache_dir)
+    assem_cache = std::make_unique<cache::AssemCache>(cache_dir, cache_size);
+  driver::Options options;
+  options.jobs = jobs;
+  options.assem_cache = assem_cache.get();
+  options.emit_obj = emit_obj;
+  options.mmap_output = mmap_output;
+  options.ra = ra_options;
+  auto report = [&] {
+    if (stats::Enabled())
+      stats::Report(stderr, json_report);
+    if (cache_stats && assem_cache)
+      assem_cache->Report(stderr);
+  };
 
-    {
-      // Lab 5: translate IR tree
-      TigerLog("-------====Translate=====-----\n");
-      tr::ProgTr prog_tr(std::move(absyn_tree), std::move(errormsg));
-      prog_tr.Translate();
-      errormsg = prog_tr.TransferErrormsg();
-    }
+  if (server_socket) {
+    if (argi != argc)
+      Usage();
+    int status = driver::Serve(&reg_manager, server_socket, options);
+    report();
+    return status;
+  }
+
+  if (argi >= argc)
+    Usage();
 
-    if (errormsg->AnyErrors())
-      return 1; // Don't continue if error occurrs
+  if (!batch) {
+    int status = driver::Compile(&reg_manager, argv[argi], options);
+    report();
+    return status;
   }
 
-  {
-    // Output assembly
-    output::AssemGen assem_gen(fname);
-    assem_gen.GenAssem(true);
+  std::vector<std::string> fnames;
+  for (; argi < argc; argi++) {
+    if (argv[argi][0] != '@') {
+      fnames.emplace_back(argv[argi]);
+    } else if (!driver::ReadFileList(argv[argi] + 1, fnames)) {
+      fprintf(stderr, "cannot read file list %s\n", argv[argi] + 1);
+      return 1;
+    }
   }
 
-  return 0;
+  int failures = driver::CompileBatch(&reg_manager, fnames, options);
+  report();
+  if (failures > 0)
+    fprintf(stderr, "%d of %zu programs failed to compile\n", failures,
+            fnames.size());
+  return failures > 0 ? 1 : 0;
 }
@@ -4,10 +4,6 @@
 #include "tiger/absyn/absyn.h"
 #include "tiger/parse/parser.h"
 
-// define here to parse compilation
-frame::RegManager *reg_manager;
-frame::Frags frags;
-
 int main(int argc, char **argv) {
   std::unique_ptr<absyn::AbsynTree> absyn_tree;
 
@@ -17,7 +13,8 @@ int main(int argc, char **argv) {
   }
 
   Parser parser(argv[1], std::cerr);
-  parser.parse();
+  if (parser.parse() != 0)
+    return 1;
   absyn_tree = parser.TransferAbsynTree();
   absyn_tree->Print(stderr);
   fprintf(stderr, "\n");
@@ -6,10 +6,6 @@
 #include "tiger/parse/parser.h"
 #include "tiger/semant/semant.h"
 
-// define here to pass compilation
-frame::RegManager *reg_manager;
-frame::Frags *frags;
-
 int main(int argc, char **argv) {
   std::unique_ptr<absyn::AbsynTree> absyn_tree;
   std::unique_ptr<err::ErrorMsg> errormsg;
@@ -21,7 +17,8 @@ int main(int argc, char **argv) {
 
   {
     Parser parser(argv[1], std::cerr);
-    parser.parse();
+    if (parser.parse() != 0)
+      return 1;
     errormsg = parser.TransferErrormsg();
     absyn_tree = parser.TransferAbsynTree();
   }
@@ -1,18 +1,17 @@
 #include "tiger/absyn/absyn.h"
+#include "tiger/context/context.h"
 #include "tiger/escape/escape.h"
 #include "tiger/frame/x64frame.h"
 #include "tiger/parse/parser.h"
 #include "tiger/translate/translate.h"
 
-frame::RegManager *reg_manager;
-frame::Frags *frags;
-
 int main(int argc, char **argv) {
   std::string_view fname;
   std::unique_ptr<absyn::AbsynTree> absyn_tree;
-  reg_manager = new frame::X64RegManager();
-  frags = new frame::Frags();
-  
+  frame::X64RegManager reg_manager;
+  ctx::CompilerContext context(&reg_manager);
+  ctx::CompilerContext::Scope scope(&context);
+
   if (argc < 2) {
     fprintf(stderr, "usage: tiger-compiler file.tig\n");
     exit(1);
@@ -27,7 +26,8 @@ int main(int argc, char **argv) {
       // Lab 3: parsing
     //   TigerLog("-------====Parse=====-----\n");
       Parser parser(fname, std::cerr);
-      parser.parse();
+      if (parser.parse() != 0)
+        return 1;
       absyn_tree = parser.TransferAbsynTree();
       errormsg = parser.TransferErrormsg();
     }
@@ -44,7 +44,7 @@ int main(int argc, char **argv) {
     {
       // Lab 5: translate IR tree
     //   TigerLog("-------====Translate=====-----\n");
-      tr::ProgTr prog_tr(std::move(absyn_tree), std::move(errormsg));
+      tr::ProgTr prog_tr(&context, std::move(absyn_tree), std::move(errormsg));
       prog_tr.Translate();
       errormsg = prog_tr.TransferErrormsg();
     }
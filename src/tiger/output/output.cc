@@ -1,73 +1,127 @@
 #include "tiger/output/output.h"
 
 #include <cstdio>
+#include <cstdlib>
+#include <vector>
 
+#include "tiger/cache/cache.h"
 #include "tiger/output/logger.h"
-
-extern frame::RegManager *reg_manager;
-extern frame::Frags *frags;
+#include "tiger/stats/stats.h"
+#include "tiger/util/thread_pool.h"
 
 namespace output {
-void AssemGen::GenAssem(bool need_ra) {
+bool AssemGen::GenAssem(bool need_ra, int jobs) {
   frame::Frag::OutputPhase phase;
 
   // Output proc
+  if (!out_)
+    return false;
+
   phase = frame::Frag::Proc;
-  fprintf(out_, ".text\n");
-  for (auto &&frag : frags->GetList())
-    frag->OutputAssem(out_, phase, need_ra);
+  out_->Put(".text\n");
+  if (jobs > 1) {
+    GenProcParallel(need_ra, jobs);
+  } else {
+    // Number the labels as the parallel backend does, so that the output
+    // does not depend on -j
+    int idx = 0;
+    for (auto &&frag : context_->GetFrags()->GetList()) {
+      temp::LabelFactory::Scope label_scope(idx++);
+      frag->OutputAssem(*out_, phase, need_ra);
+    }
+  }
 
   // Output string
   phase = frame::Frag::String;
-  fprintf(out_, ".section .rodata\n");
-  for (auto &&frag : frags->GetList())
-    frag->OutputAssem(out_, phase, need_ra);
+  out_->Put(".section .rodata\n");
+  for (auto &&frag : context_->GetFrags()->GetList())
+    frag->OutputAssem(*out_, phase, need_ra);
+
+  // A writer owned by the caller is closed by the caller
+  return !owned_out_ || owned_out_->Close();
+}
+
+void AssemGen::GenProcParallel(bool need_ra, int jobs) {
+  const std::list<frame::Frag *> &frag_list = context_->GetFrags()->GetList();
+  ctx::CompilerContext *context = context_;
+  std::vector<std::unique_ptr<AsmWriter>> texts(frag_list.size());
+
+  {
+    util::ThreadPool pool(jobs);
+    int idx = 0;
+    for (auto frag : frag_list) {
+      pool.Submit([context, frag, idx, need_ra, &texts] {
+        ctx::CompilerContext::Scope context_scope(context);
+        // Labels made in the backend are numbered per fragment
+        temp::LabelFactory::Scope label_scope(idx);
+        texts[idx] = std::make_unique<AsmWriter>();
+        frag->OutputAssem(*texts[idx], frame::Frag::Proc, need_ra);
+      });
+      idx++;
+    }
+    pool.Wait();
+  }
+
+  // Keep the output deterministic: emit in fragment order
+  for (auto &text : texts)
+    out_->Put(text->Text());
 }
 
 } // namespace output
 
-namespace frame {
+namespace {
 
-void ProcFrag::OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const {
+/**
+ * Run the backend on the body of a function and write its assembly
+ */
+void GenProc(tree::Stm *body, frame::Frame *frame, output::AsmWriter &out,
+             bool need_ra) {
   std::unique_ptr<canon::Traces> traces;
   std::unique_ptr<cg::AssemInstr> assem_instr;
   std::unique_ptr<ra::Result> allocation;
 
-  // When generating proc fragment, do not output string assembly
-  if (phase != Proc)
-    return;
-
   TigerLog("-------====IR tree=====-----\n");
-  TigerLog(body_);
+  TigerLog(body);
+
+  std::string proc_name(frame->Name()->Name());
 
   {
     // Canonicalize
     TigerLog("-------====Canonicalize=====-----\n");
-    canon::Canon canon(body_);
+    canon::Canon canon(body);
 
     // Linearize to generate canonical trees
     TigerLog("-------====Linearlize=====-----\n");
+    stats::PassTimer linearize_timer("Linearize", proc_name);
     tree::StmList *stm_linearized = canon.Linearize();
+    linearize_timer.Pause();
     // TigerLog(stm_linearized);
 
     // Group list into basic blocks
     TigerLog("------====Basic block_=====-------\n");
+    stats::PassTimer blocks_timer("BasicBlocks", proc_name);
     canon::StmListList *stm_lists = canon.BasicBlocks();
+    blocks_timer.Pause();
     // TigerLog(stm_lists);
 
     // Order basic blocks into traces_
     TigerLog("-------====Trace=====-----\n");
+    stats::PassTimer trace_timer("TraceSchedule", proc_name);
     tree::StmList *stm_traces = canon.TraceSchedule();
+    trace_timer.Pause();
     TigerLog(stm_traces);
 
     traces = canon.TransferTraces();
   }
 
+  ctx::CompilerContext *context = frame->Context();
+  frame::RegManager *reg_manager = context->GetRegManager();
   temp::Map *color = temp::Map::LayerMap(reg_manager->temp_map_, temp::Map::Name());
   {
     // Lab 5: code generation
     TigerLog("-------====Code generate=====-----\n");
-    cg::CodeGen code_gen(frame_, std::move(traces));
+    stats::PassTimer timer("Codegen", proc_name);
+    cg::CodeGen code_gen(context, frame, std::move(traces));
     code_gen.Codegen();
     assem_instr = code_gen.TransferAssemInstr();
     TigerLog(assem_instr.get(), color);
@@ -78,53 +132,99 @@ void ProcFrag::OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const {
   if (need_ra) {
     // Lab 6: register allocation
     TigerLog("----====Register allocate====-----\n");
-    ra::RegAllocator reg_allocator(frame_, std::move(assem_instr));
-    reg_allocator.RegAlloc();
-    allocation = reg_allocator.TransferResult();
+    stats::PassTimer timer("RegAlloc", proc_name);
+    allocation = ra::Allocate(context, frame, std::move(assem_instr));
     il = allocation->il_;
     color = temp::Map::LayerMap(reg_manager->temp_map_, allocation->coloring_);
   }
 
   TigerLog("-------====Output assembly for %s=====-----\n",
-           frame_->Name()->Name().data());
+           frame->Name()->Name().data());
 
-  assem::Proc *proc = frame::ProcEntryExit3(frame_, il);
+  stats::PassTimer emit_timer("Emit", proc_name);
+  assem::Proc *proc = frame::ProcEntryExit3(frame, il);
 
-  std::string proc_name = frame_->Name()->Name();
-
-  fprintf(out, "  .globl %s\n", proc_name.data());
-  fprintf(out, "  .type %s, @function\n", proc_name.data());
+  out.Put("  .globl ");
+  out.Put(proc_name);
+  out.Put("\n  .type ");
+  out.Put(proc_name);
+  out.Put(", @function\n");
   // prologue
-  fprintf(out, "%s", proc->prolog_.data());
+  out.Put(proc->prolog_);
   // body
   proc->body_->Print(out, color);
   // epilog_
-  fprintf(out, "%s", proc->epilog_.data());
-  fprintf(out, "  .size %s, .-%s\n", proc_name.data(), proc_name.data());
+  out.Put(proc->epilog_);
+  out.Put("  .size ");
+  out.Put(proc_name);
+  out.Put(", .-");
+  out.Put(proc_name);
+  out.Put('\n');
 }
 
-void StringFrag::OutputAssem(FILE *out, OutputPhase phase, bool need_ra) const {
+/**
+ * Write the assembly of a function, from the assembly cache if the context
+ * has one
+ */
+void GenProcCached(tree::Stm *body, frame::Frame *frame,
+                   output::AsmWriter &out, bool need_ra) {
+  // Only allocated code is cached, it names no temps
+  ctx::CompilerContext *context = frame->Context();
+  cache::AssemCache *assem_cache = context->GetAssemCache();
+  if (!assem_cache || !need_ra) {
+    GenProc(body, frame, out, need_ra);
+    return;
+  }
+
+  // The key is taken before the body is canonicalized
+  cache::FunctionKey key(frame, body, context->GetRegManager(),
+                         context->GetRegAllocOptions());
+  std::string text;
+  if (assem_cache->Lookup(key, text)) {
+    out.Put(text);
+    return;
+  }
+  int first_label = temp::LabelFactory::NextLabelNumber();
+  output::AsmWriter generated;
+  GenProc(body, frame, generated, need_ra);
+  assem_cache->Store(key, generated.Text(), first_label,
+                     temp::LabelFactory::NextLabelNumber() - first_label);
+  out.Put(generated.Text());
+}
+
+} // namespace
+
+namespace frame {
+
+void ProcFrag::OutputAssem(output::AsmWriter &out, OutputPhase phase,
+                           bool need_ra) const {
+  // When generating proc fragment, do not output string assembly
+  if (phase != Proc)
+    return;
+
+  {
+    // The backend allocates in the arena of the function as well
+    util::ProcObject::Scope arena_scope(arena_.get());
+    temp::TempFactory::Scope temp_scope(frame_->Temps());
+    GenProcCached(body_, frame_, out, need_ra);
+  }
+  // The assembly is written, drop the IR of the function
+  arena_.reset();
+}
+
+void StringFrag::OutputAssem(output::AsmWriter &out, OutputPhase phase,
+                             bool need_ra) const {
   // When generating string fragment, do not output proc assembly
   if (phase != String)
     return;
 
-  fprintf(out, "%s:\n", label_->Name().data());
-  int length = static_cast<int>(str_.size());
-  // It may contain zeros in the middle of string. To keep this work, we need
-  // to print all the charactors instead of using fprintf(str)
-  fprintf(out, ".long %d\n", length);
-  fprintf(out, ".string \"");
-  for (int i = 0; i < length; i++) {
-    if (str_[i] == '\n') {
-      fprintf(out, "\\n");
-    } else if (str_[i] == '\t') {
-      fprintf(out, "\\t");
-    } else if (str_[i] == '\"') {
-      fprintf(out, "\\\"");
-    } else {
-      fprintf(out, "%c", str_[i]);
-    }
-  }
-  fprintf(out, "\"\n");
+  out.Put(label_->Name());
+  // It may contain zeros in the middle of string, so the length is written
+  // explicitly and the literal is copied as a whole
+  out.Put(":\n.long ");
+  out.PutInt(static_cast<int64_t>(str_.size()));
+  out.Put("\n.string \"");
+  out.PutEscaped(str_);
+  out.Put("\"\n");
 }
 } // namespace frame
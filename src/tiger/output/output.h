@@ -7,7 +7,9 @@
 
 #include "tiger/canon/canon.h"
 #include "tiger/codegen/codegen.h"
+#include "tiger/context/context.h"
 #include "tiger/frame/frame.h"
+#include "tiger/output/writer.h"
 #include "tiger/regalloc/regalloc.h"
 
 namespace output {
@@ -15,23 +17,48 @@ namespace output {
 class AssemGen {
 public:
   AssemGen() = delete;
-  explicit AssemGen(std::string_view infile) {
+  /**
+   * Write `<infile>.s`
+   * @param mapped write the file through a memory mapping
+   */
+  AssemGen(ctx::CompilerContext *context, std::string_view infile,
+           bool mapped = false)
+      : context_(context) {
     std::string outfile = static_cast<std::string>(infile) + ".s";
-    out_ = fopen(outfile.data(), "w");
+    owned_out_ = AsmWriter::Open(outfile, mapped);
+    if (!owned_out_)
+      perror(outfile.data());
+    out_ = owned_out_.get();
   }
+  /* write to a stream owned by the caller */
+  AssemGen(ctx::CompilerContext *context, FILE *out)
+      : context_(context), owned_out_(std::make_unique<AsmWriter>(out)),
+        out_(owned_out_.get()) {}
+  /* write to a writer owned by the caller */
+  AssemGen(ctx::CompilerContext *context, AsmWriter *out)
+      : context_(context), out_(out) {}
   AssemGen(const AssemGen &assem_generator) = delete;
   AssemGen(AssemGen &&assem_generator) = delete;
   AssemGen &operator=(const AssemGen &assem_generator) = delete;
   AssemGen &operator=(AssemGen &&assem_generator) = delete;
-  ~AssemGen() { fclose(out_); }
+  ~AssemGen() = default;
 
   /**
    * Generate assembly
+   * @param need_ra whether to run register allocation
+   * @param jobs number of threads compiling proc fragments; the text of every
+   * fragment is still emitted in the original fragment order
+   * @return whether the assembly was written; an output file is closed, one
+   * that cannot be opened or written is reported
    */
-  void GenAssem(bool need_ra);
+  [[nodiscard]] bool GenAssem(bool need_ra, int jobs = 1);
 
 private:
-  FILE *out_; // Instream of source file
+  ctx::CompilerContext *context_;
+  std::unique_ptr<AsmWriter> owned_out_;
+  AsmWriter *out_; // Instream of source file
+
+  void GenProcParallel(bool need_ra, int jobs);
 };
 
 } // namespace output
@@ -0,0 +1,178 @@
+#include "tiger/output/writer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+/* stream buffers and mapped windows start this large */
+constexpr size_t kBufferSize = 1 << 20;
+/* in-memory writers mostly hold one function */
+constexpr size_t kMemorySize = 1 << 14;
+
+} // namespace
+
+namespace output {
+
+AsmWriter::AsmWriter() : mode_(MEMORY) { Grow(kMemorySize); }
+
+AsmWriter::AsmWriter(FILE *out) : mode_(STREAM), out_(out) {
+  Grow(kBufferSize);
+}
+
+AsmWriter::AsmWriter(int fd) : mode_(MAPPED), fd_(fd) {}
+
+AsmWriter::~AsmWriter() {
+  if (!closed_)
+    (void)Close();
+  free(begin_);
+}
+
+bool AsmWriter::Close() {
+  closed_ = true;
+  if (mode_ == MAPPED) {
+    size_t size = pos_ - begin_;
+    if (begin_)
+      munmap(begin_, end_ - begin_);
+    begin_ = pos_ = end_ = nullptr;
+    /* drop the slack of the last window */
+    if (ftruncate(fd_, static_cast<off_t>(size)) != 0)
+      Fail("tiger-compiler: cannot truncate output");
+    if (close(fd_) != 0)
+      Fail("tiger-compiler: cannot close output");
+  } else if (mode_ == STREAM) {
+    Flush();
+    if (owns_out_ && fclose(out_) != 0)
+      Fail("tiger-compiler: cannot close output");
+  }
+  return !failed_;
+}
+
+std::unique_ptr<AsmWriter> AsmWriter::Open(std::string_view path,
+                                           bool mapped) {
+  std::string name(path);
+  if (mapped) {
+    int fd = open(name.data(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return nullptr;
+    std::unique_ptr<AsmWriter> writer(new AsmWriter(fd));
+    writer->Map(kBufferSize);
+    if (writer->begin_)
+      return writer;
+    /* the file system cannot map files, write through a stream */
+    writer->closed_ = true;
+    close(fd);
+  }
+  FILE *out = fopen(name.data(), "w");
+  if (!out)
+    return nullptr;
+  auto writer = std::make_unique<AsmWriter>(out);
+  writer->owns_out_ = true;
+  return writer;
+}
+
+void AsmWriter::PutInt(int64_t value) {
+  char digits[24];
+  char *p = digits + sizeof(digits);
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value)
+                                 : static_cast<uint64_t>(value);
+  do {
+    *--p = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0)
+    *--p = '-';
+  Put(std::string_view(p, digits + sizeof(digits) - p));
+}
+
+void AsmWriter::PutEscaped(std::string_view s) {
+  size_t run = 0;
+  for (size_t i = 0; i < s.size(); i++) {
+    const char *escape;
+    switch (s[i]) {
+    case '\n': escape = "\\n"; break;
+    case '\t': escape = "\\t"; break;
+    case '"': escape = "\\\""; break;
+    default: continue;
+    }
+    Put(s.substr(run, i - run));
+    Put(std::string_view(escape, 2));
+    run = i + 1;
+  }
+  Put(s.substr(run));
+}
+
+void AsmWriter::Flush() {
+  if (mode_ != STREAM || pos_ == begin_)
+    return;
+  size_t size = pos_ - begin_;
+  if (fwrite(begin_, 1, size, out_) != size)
+    Fail("tiger-compiler: cannot write output");
+  pos_ = begin_;
+}
+
+void AsmWriter::Reserve(size_t n) {
+  size_t capacity = end_ - begin_;
+  size_t used = pos_ - begin_;
+  if (failed_) {
+    /* the output is lost, the rest of the text goes nowhere */
+    pos_ = begin_;
+    if (capacity >= n)
+      return;
+    used = 0;
+  }
+  if (mode_ == STREAM) {
+    Flush();
+    if (capacity >= n)
+      return;
+    used = 0;
+  }
+  size_t wanted = std::max(capacity * 2, used + n);
+  if (mode_ != MAPPED) {
+    Grow(wanted);
+  } else {
+    Map(wanted);
+    if (!begin_) {
+      Fail("tiger-compiler: cannot map output");
+      close(fd_);
+      mode_ = MEMORY;
+      Grow(std::max(kMemorySize, n));
+    }
+  }
+}
+
+void AsmWriter::Grow(size_t capacity) {
+  size_t used = pos_ - begin_;
+  begin_ = static_cast<char *>(realloc(begin_, capacity));
+  if (!begin_)
+    abort();
+  pos_ = begin_ + used;
+  end_ = begin_ + capacity;
+}
+
+void AsmWriter::Map(size_t capacity) {
+  size_t used = pos_ - begin_;
+  if (begin_)
+    munmap(begin_, end_ - begin_);
+  begin_ = pos_ = end_ = nullptr;
+  if (ftruncate(fd_, static_cast<off_t>(capacity)) != 0)
+    return;
+  void *map = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                   0);
+  if (map == MAP_FAILED)
+    return;
+  begin_ = static_cast<char *>(map);
+  pos_ = begin_ + used;
+  end_ = begin_ + capacity;
+}
+
+void AsmWriter::Fail(const char *what) {
+  if (!failed_)
+    perror(what);
+  failed_ = true;
+}
+
+} // namespace output
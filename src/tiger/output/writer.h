@@ -0,0 +1,95 @@
+#ifndef TIGER_OUTPUT_WRITER_H_
+#define TIGER_OUTPUT_WRITER_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace output {
+
+/**
+ * Sink of the assembly text. Text is appended to one large buffer which is
+ * flushed to a stream when full, kept in memory, or is itself a memory
+ * mapped output file, so emitting needs neither formatted I/O nor
+ * temporary strings.
+ */
+class AsmWriter {
+public:
+  /* collect the text in memory, see Text() */
+  AsmWriter();
+  /* buffer the text and write it to a stream owned by the caller */
+  explicit AsmWriter(FILE *out);
+  AsmWriter(const AsmWriter &writer) = delete;
+  AsmWriter &operator=(const AsmWriter &writer) = delete;
+  ~AsmWriter();
+
+  /**
+   * Open an output file, either written through a stream or mapped into
+   * memory
+   * @return nullptr if the file cannot be opened
+   */
+  static std::unique_ptr<AsmWriter> Open(std::string_view path, bool mapped);
+
+  void Put(char ch) {
+    if (pos_ == end_)
+      Reserve(1);
+    *pos_++ = ch;
+  }
+  void Put(std::string_view s) {
+    if (static_cast<size_t>(end_ - pos_) < s.size())
+      Reserve(s.size());
+    memcpy(pos_, s.data(), s.size());
+    pos_ += s.size();
+  }
+  void PutInt(int64_t value);
+
+  /**
+   * Put the body of a `.string` literal, escaping newlines, tabs and
+   * quotes; runs of plain characters are copied at once
+   */
+  void PutEscaped(std::string_view s);
+
+  /**
+   * Text collected by an in-memory writer
+   */
+  [[nodiscard]] std::string_view Text() const {
+    return std::string_view(begin_, pos_ - begin_);
+  }
+  void Clear() { pos_ = begin_; }
+
+  /* write the buffer out to the stream */
+  void Flush();
+
+  /**
+   * Write out the rest of the text and close a file opened by Open(), which
+   * the destructor does otherwise; nothing may be put afterwards
+   * @return whether all the text was written
+   */
+  [[nodiscard]] bool Close();
+
+private:
+  enum Mode { MEMORY, STREAM, MAPPED };
+
+  Mode mode_;
+  FILE *out_ = nullptr;
+  bool owns_out_ = false;
+  int fd_ = -1; // mapped file
+  bool closed_ = false;
+  /* some text was lost, the error is reported once */
+  bool failed_ = false;
+  char *begin_ = nullptr, *pos_ = nullptr, *end_ = nullptr;
+
+  explicit AsmWriter(int fd);
+  /* make room for at least n more bytes */
+  void Reserve(size_t n);
+  void Grow(size_t capacity);
+  void Map(size_t capacity);
+  void Fail(const char *what);
+};
+
+} // namespace output
+
+#endif // TIGER_OUTPUT_WRITER_H_
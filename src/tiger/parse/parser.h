@@ -58,9 +58,12 @@ private:
   void print__();
 };
 
+/**
+ * Report a syntax error. There is no error recovery in the grammar, so parse()
+ * aborts and returns nonzero afterwards.
+ */
 inline void Parser::error() {
   scanner_.Error(scanner_.GetTokPos(), "syntax error");
-  exit(1);
 }
 
 inline int Parser::lex() {
@@ -1,6 +1,4 @@
 #include "tiger/regalloc/color.h"
 
-extern frame::RegManager *reg_manager;
-
 namespace col {
 } // namespace col
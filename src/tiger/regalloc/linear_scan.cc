@@ -0,0 +1,254 @@
+#include "tiger/regalloc/linear_scan.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "tiger/output/logger.h"
+#include "tiger/stats/stats.h"
+
+namespace ra {
+
+LinearScanAllocator::LinearScanAllocator(
+    ctx::CompilerContext *context, frame::Frame *frame,
+    std::unique_ptr<cg::AssemInstr> assem_instr)
+    : reg_manager_(context->GetRegManager()), frame_(frame),
+      assem_instr_(std::move(assem_instr)) {
+  const auto &regs = reg_manager_->Registers()->GetList();
+  regs_.assign(regs.begin(), regs.end());
+  sp_ = static_cast<int>(
+      std::find(regs_.begin(), regs_.end(), reg_manager_->StackPointer()) -
+      regs_.begin());
+}
+
+std::unique_ptr<Result> LinearScanAllocator::TransferResult() {
+  auto coloring = temp::Map::Empty();
+  auto temp_map = reg_manager_->temp_map_;
+  int count = static_cast<int>(regs_.size());
+  for (int r = 0; r < count; r++)
+    coloring->Enter(regs_[r], temp_map->Look(regs_[r]));
+  for (size_t key = count; key < intervals_.size(); key++) {
+    int reg = intervals_[key].reg_;
+    if (reg != NONE)
+      coloring->Enter(graph_->Nodes()[key]->NodeInfo(),
+                      temp_map->Look(regs_[reg]));
+  }
+  auto il = assem_instr_->GetInstrList()->Compressed(coloring);
+  return std::make_unique<Result>(coloring, il);
+}
+
+void LinearScanAllocator::RegAlloc() {
+  /* a round that spills starts another, each timed separately */
+  std::string function(frame_->Name()->Name());
+  for (int round = 1;; round++) {
+    {
+      stats::PassTimer timer("RA.Liveness", function, round);
+      Liveness();
+    }
+    {
+      stats::PassTimer timer("RA.Intervals", function, round);
+      BuildIntervals();
+    }
+    {
+      stats::PassTimer timer("RA.Scan", function, round);
+      Scan();
+    }
+    if (spilled_.empty())
+      break;
+    stats::PassTimer timer("RA.Rewrite", function, round);
+    Rewrite();
+  }
+}
+
+void LinearScanAllocator::Liveness() {
+  if (!fg_factory_) {
+    fg_factory_ = std::make_unique<fg::FlowGraphFactory>(
+        assem_instr_->GetInstrList());
+    fg_factory_->AssemFlowGraph();
+  }
+  /* the blocks stay across rounds, spill code only grows them */
+  lg_factory_ = std::make_unique<live::LiveGraphFactory>(
+      fg_factory_->GetFlowGraph(), reg_manager_);
+  lg_factory_->LiveSets();
+  graph_ = lg_factory_->GetLiveGraph().interf_graph;
+}
+
+void LinearScanAllocator::BuildIntervals() {
+  int count = static_cast<int>(regs_.size());
+  size_t nodes = graph_->Nodes().size();
+  intervals_.assign(nodes, {NONE, NONE});
+  ranges_.assign(nodes, {});
+  std::vector<int> open(nodes, NONE);
+
+  /* backwards through each block, a range is open from the last use of a
+   * temp until its def; a def nothing reads, such as the clobber of a call,
+   * still takes its position */
+  const auto &blocks = fg_factory_->GetFlowGraph()->Blocks();
+  int first = 0;
+  for (int b = 0; b < static_cast<int>(blocks.size()); b++) {
+    const auto &block = blocks[b];
+    int last = first - 1;
+    for (auto pos = block.begin_; pos != block.End(); ++pos)
+      last++;
+    lg_factory_->Out(b).ForEach([&](size_t key) { open[key] = 2 * last + 1; });
+    int i = last;
+    for (auto pos = block.End(); pos != block.begin_; i--) {
+      auto instr = *--pos;
+      for (auto temp : instr->Def()) {
+        int key = graph_->Look(temp)->Key();
+        ranges_[key].push_back(
+            {2 * i + 1, open[key] == NONE ? 2 * i + 1 : open[key]});
+        open[key] = NONE;
+      }
+      for (auto temp : instr->Use()) {
+        int key = graph_->Look(temp)->Key();
+        if (open[key] == NONE)
+          open[key] = 2 * i;
+      }
+      /* the register of the other end saves a move */
+      if (instr->IsMove() && instr->Use().Size() == 1 &&
+          instr->Def().Size() == 1) {
+        int src = graph_->Look(instr->Use()[0])->Key();
+        int dst = graph_->Look(instr->Def()[0])->Key();
+        if (dst >= count && intervals_[dst].hint_ == NONE)
+          intervals_[dst].hint_ = src;
+        if (src >= count && dst < count && intervals_[src].hint_ == NONE)
+          intervals_[src].hint_ = dst;
+      }
+    }
+    lg_factory_->In(b).ForEach([&](size_t key) {
+      ranges_[key].push_back({2 * first, open[key]});
+      open[key] = NONE;
+    });
+    first = last + 1;
+  }
+
+  /* ranges come by block, and backwards within each block */
+  for (size_t key = 0; key < nodes; key++) {
+    auto &ranges = ranges_[key];
+    std::sort(ranges.begin(), ranges.end(),
+              [](const Range &a, const Range &b) { return a.start_ < b.start_; });
+    if (ranges.empty())
+      continue;
+    intervals_[key].start_ = ranges.front().start_;
+    for (const auto &range : ranges)
+      intervals_[key].end_ = std::max(intervals_[key].end_, range.end_);
+  }
+  next_fixed_.assign(count, 0);
+}
+
+bool LinearScanAllocator::Fits(int r, int key) {
+  const auto &fixed = ranges_[r];
+  const auto &own = ranges_[key];
+  size_t &next = next_fixed_[r];
+  while (next < fixed.size() && fixed[next].end_ < intervals_[key].start_)
+    next++;
+  /* both are sorted by start, the ranges of a register may overlap */
+  for (size_t i = next, j = 0; i < fixed.size() && j < own.size();) {
+    if (fixed[i].end_ < own[j].start_)
+      i++;
+    else if (own[j].end_ < fixed[i].start_)
+      j++;
+    else
+      return false;
+  }
+  return true;
+}
+
+int LinearScanAllocator::FreeUntil(int r) const {
+  const auto &fixed = ranges_[r];
+  size_t next = next_fixed_[r];
+  return next < fixed.size() ? fixed[next].start_
+                             : std::numeric_limits<int>::max();
+}
+
+void LinearScanAllocator::Scan() {
+  int count = static_cast<int>(regs_.size());
+  std::vector<int> order;
+  for (int key = count; key < static_cast<int>(intervals_.size()); key++) {
+    if (intervals_[key].end_ != NONE)
+      order.push_back(key);
+  }
+  std::sort(order.begin(), order.end(), [this](int a, int b) {
+    return intervals_[a].start_ < intervals_[b].start_ ||
+           (intervals_[a].start_ == intervals_[b].start_ && a < b);
+  });
+
+  /* intervals holding registers, at most one per register */
+  std::vector<int> active;
+  std::vector<bool> taken(count, false);
+  taken[sp_] = true;
+  spilled_.clear();
+  for (int key : order) {
+    auto &cur = intervals_[key];
+    for (size_t a = 0; a < active.size();) {
+      auto &old = intervals_[active[a]];
+      if (old.end_ < cur.start_) {
+        taken[old.reg_] = false;
+        active[a] = active.back();
+        active.pop_back();
+      } else {
+        a++;
+      }
+    }
+
+    /* the register of the hint if it fits, otherwise the one freed by the
+     * code soonest, which leaves the registers free longer to the others */
+    int hint = cur.hint_ == NONE || cur.hint_ < count
+                   ? cur.hint_
+                   : intervals_[cur.hint_].reg_;
+    int best = NONE;
+    if (hint != NONE && !taken[hint] && Fits(hint, key)) {
+      best = hint;
+    } else {
+      for (int r = 0; r < count; r++) {
+        if (taken[r] || !Fits(r, key))
+          continue;
+        if (best == NONE || FreeUntil(r) < FreeUntil(best))
+          best = r;
+      }
+    }
+    if (best != NONE) {
+      cur.reg_ = best;
+      taken[best] = true;
+      active.push_back(key);
+      continue;
+    }
+
+    /* spill the interval ending last among cur and those whose register
+     * cur could take, sparing the short intervals of spill code */
+    int victim = NONE;
+    for (size_t a = 0; a < active.size(); a++) {
+      const auto &old = intervals_[active[a]];
+      if ((SpillTemp(active[a]) && !SpillTemp(key)) || !Fits(old.reg_, key))
+        continue;
+      if (victim == NONE || old.end_ > intervals_[active[victim]].end_)
+        victim = static_cast<int>(a);
+    }
+    if (victim != NONE &&
+        (intervals_[active[victim]].end_ > cur.end_ || SpillTemp(key))) {
+      auto &old = intervals_[active[victim]];
+      cur.reg_ = old.reg_;
+      old.reg_ = NONE;
+      spilled_.push_back(graph_->Nodes()[active[victim]]->NodeInfo());
+      active[victim] = key;
+    } else {
+      spilled_.push_back(graph_->Nodes()[key]->NodeInfo());
+    }
+  }
+}
+
+void LinearScanAllocator::Rewrite() {
+  TigerLog("%ld temps spilled!\n", spilled_.size());
+  if (max_code_temp_ < 0) {
+    for (auto node : graph_->Nodes())
+      max_code_temp_ = std::max(max_code_temp_, node->NodeInfo()->Int());
+  }
+  if (!rewriter_) {
+    rewriter_ = std::make_unique<SpillRewriter>(
+        frame_, reg_manager_, assem_instr_->GetInstrList(),
+        fg_factory_->GetFlowGraph());
+  }
+  rewriter_->Rewrite(spilled_, lg_factory_.get());
+}
+
+} // namespace ra
@@ -0,0 +1,99 @@
+#ifndef TIGER_REGALLOC_LINEAR_SCAN_H_
+#define TIGER_REGALLOC_LINEAR_SCAN_H_
+
+#include <memory>
+#include <vector>
+
+#include "tiger/codegen/assem.h"
+#include "tiger/codegen/codegen.h"
+#include "tiger/frame/frame.h"
+#include "tiger/frame/temp.h"
+#include "tiger/liveness/flowgraph.h"
+#include "tiger/liveness/liveness.h"
+#include "tiger/regalloc/regalloc.h"
+#include "tiger/regalloc/spill.h"
+
+namespace ra {
+
+/**
+ * Linear-scan register allocation after Poletto and Sarkar, for functions
+ * too large to color. The instructions are numbered in the order of the
+ * list, instruction i reading its operands at 2i and writing its results at
+ * 2i + 1. Temps and registers are live over ranges of positions, the
+ * caller-saved registers at every call as well. Temps get registers in the
+ * order of their first positions, keeping them up to their last, and only
+ * avoid the ranges of the register in between, e.g. of an epilogue the
+ * traces put in the middle. If none is free, the interval ending last is
+ * spilled whole, without splitting: like the coloring allocator, its temp
+ * is loaded or rematerialized before each use and stored after each def,
+ * through new temps that must not spill again. These get registers in the
+ * next round, which scans the whole code again. A round takes time linear
+ * in the code but for sorting the intervals, and each round but the last
+ * spills at least one temp of the code, so the whole is not near-linear
+ * when many rounds spill.
+ */
+class LinearScanAllocator {
+public:
+  LinearScanAllocator(ctx::CompilerContext *context, frame::Frame *frame,
+                      std::unique_ptr<cg::AssemInstr> assem_instr);
+  std::unique_ptr<Result> TransferResult();
+  void RegAlloc();
+
+private:
+  static constexpr int NONE = -1;
+
+  /* positions where a temp or register is live */
+  struct Range {
+    int start_;
+    int end_;
+  };
+  /* from the first to the last range of a temp, indexed by its key */
+  struct Interval {
+    int start_;
+    int end_;
+    /* the other end of a move, whose register saves the move */
+    int hint_ = NONE;
+    /* index of the register, NONE if it has none */
+    int reg_ = NONE;
+  };
+
+  frame::RegManager *reg_manager_;
+  frame::Frame *frame_;
+  std::unique_ptr<cg::AssemInstr> assem_instr_;
+  /* registers by index, the same as the keys of their nodes */
+  std::vector<temp::Temp *> regs_;
+  int sp_;
+
+  std::unique_ptr<fg::FlowGraphFactory> fg_factory_;
+  std::unique_ptr<live::LiveGraphFactory> lg_factory_;
+  live::IGraph *graph_ = nullptr;
+  std::unique_ptr<SpillRewriter> rewriter_;
+
+  std::vector<Interval> intervals_;
+  /* ranges of each node by start, those of registers fixed by the code */
+  std::vector<std::vector<Range>> ranges_;
+  /* first range of each register not over before the current interval */
+  std::vector<size_t> next_fixed_;
+  std::vector<temp::Temp *> spilled_;
+  /* temps with a greater id were made by spill code */
+  int max_code_temp_ = -1;
+
+  void Liveness();
+  void BuildIntervals();
+  void Scan();
+  void Rewrite();
+
+  [[nodiscard]] bool SpillTemp(int key) const {
+    return max_code_temp_ >= 0 &&
+           graph_->Nodes()[key]->NodeInfo()->Int() > max_code_temp_;
+  }
+  /* whether no range of register r overlaps one of the temp of key, whose
+   * interval starts no earlier than any asked about before */
+  bool Fits(int r, int key);
+  /* start of the next range of register r, the end of the code if none */
+  int FreeUntil(int r) const;
+};
+
+} // namespace ra
+
+#endif // TIGER_REGALLOC_LINEAR_SCAN_H_
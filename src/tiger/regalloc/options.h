@@ -0,0 +1,26 @@
+#ifndef TIGER_REGALLOC_OPTIONS_H_
+#define TIGER_REGALLOC_OPTIONS_H_
+
+namespace ra {
+
+enum class Allocator {
+  /* iterated register coalescing, see RegAllocator */
+  COLORING,
+  /* linear scan, see LinearScanAllocator */
+  LINEAR,
+};
+
+/**
+ * Choice of the register allocator, the same for every function of a
+ * program
+ */
+struct Options {
+  Allocator allocator = Allocator::COLORING;
+  /* functions with more temps than this get linear scan even when coloring
+   * is asked for, 0 for no limit */
+  int max_graph_nodes = 10000;
+};
+
+} // namespace ra
+
+#endif // TIGER_REGALLOC_OPTIONS_H_
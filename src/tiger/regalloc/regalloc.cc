@@ -1,28 +1,77 @@
 #include "tiger/regalloc/regalloc.h"
 
-#include "tiger/output/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-extern frame::RegManager *reg_manager;
+#include "tiger/output/logger.h"
+#include "tiger/regalloc/linear_scan.h"
+#include "tiger/stats/stats.h"
 
 namespace ra {
 
-RegAllocator::RegAllocator(frame::Frame *frame_, std::unique_ptr<cg::AssemInstr> assem_instr):
-  frame_(frame_), assem_instr_(std::move(assem_instr)), 
-  simplifyWorkList(new NodeList()), freezeWorkList(new NodeList()), spillWorkList(new NodeList()), 
-  spilledNodes(new NodeList()), coloredNodes(new NodeList()), coalescedNodes(new NodeList()),
-  selectStack(new NodeList()), workListMoves(new MoveList()), activeMoves(new MoveList()),
-  frozenMoves(new MoveList()), constrainedMoves(new MoveList()), coalescedMoves(new MoveList()),
-  liveGraph(nullptr, nullptr), K(static_cast<int>(reg_manager->Registers()->GetList().size())),
-  result_(std::make_unique<Result>(temp::Map::Empty(), nullptr)) {}
+namespace {
+
+/* number of temps in the code, the nodes its interference graph would have */
+int CountTemps(assem::InstrList *instr_list) {
+  std::vector<bool> seen;
+  int count = 0;
+  auto see = [&](temp::Temp *temp) {
+    size_t id = temp->Int();
+    if (seen.size() <= id)
+      seen.resize(id + 1, false);
+    if (!seen[id]) {
+      seen[id] = true;
+      count++;
+    }
+  };
+  for (auto instr : instr_list->GetList()) {
+    for (auto temp : instr->Def())
+      see(temp);
+    for (auto temp : instr->Use())
+      see(temp);
+  }
+  return count;
+}
+
+} // namespace
+
+std::unique_ptr<Result> Allocate(ctx::CompilerContext *context,
+                                 frame::Frame *frame,
+                                 std::unique_ptr<cg::AssemInstr> assem_instr) {
+  const Options &options = context->GetRegAllocOptions();
+  bool linear = options.allocator == Allocator::LINEAR ||
+                (options.max_graph_nodes > 0 &&
+                 CountTemps(assem_instr->GetInstrList()) >
+                     options.max_graph_nodes);
+  if (linear) {
+    LinearScanAllocator allocator(context, frame, std::move(assem_instr));
+    allocator.RegAlloc();
+    return allocator.TransferResult();
+  }
+  RegAllocator allocator(context, frame, std::move(assem_instr));
+  allocator.RegAlloc();
+  return allocator.TransferResult();
+}
+
+RegAllocator::RegAllocator(ctx::CompilerContext *context, frame::Frame *frame_,
+                           std::unique_ptr<cg::AssemInstr> assem_instr):
+  liveGraph(nullptr, nullptr),
+  result_(std::make_unique<Result>(temp::Map::Empty(), nullptr)),
+  context_(context), reg_manager_(context->GetRegManager()),
+  frame_(frame_), assem_instr_(std::move(assem_instr)),
+  K(static_cast<int>(reg_manager_->Registers()->GetList().size())) {}
 
 std::unique_ptr<Result> RegAllocator::TransferResult() {
   /* construct color-map */
   auto coloring = result_->coloring_;
-  auto temp_map = reg_manager->temp_map_;
-  for (const auto &tempColor : color) {
-    coloring->Enter(tempColor.first->NodeInfo(), temp_map->Look(tempColor.second));
-    if (PreColored(tempColor.first)) {
-      assert(tempColor.first->NodeInfo() == tempColor.second);
+  auto temp_map = reg_manager_->temp_map_;
+  for (auto node : liveGraph.interf_graph->Nodes()) {
+    if (node->Removed()) continue;
+    auto reg = color[node->Key()];
+    coloring->Enter(node->NodeInfo(), temp_map->Look(reg));
+    if (PreColored(node)) {
+      assert(node->NodeInfo() == reg);
     }
   }
   TigerLog("list size is %ld\n", assem_instr_->GetInstrList()->GetList().size());
@@ -31,83 +80,174 @@ std::unique_ptr<Result> RegAllocator::TransferResult() {
 }
 
 void RegAllocator::RegAlloc() {
-    LivenessAnalysis();
-    Build();
-    MakeWorkList();
-    while (!simplifyWorkList->Empty() || !workListMoves->Empty() || 
-        !freezeWorkList->Empty() || !spillWorkList->Empty()) {
-      if (!simplifyWorkList->Empty()) Simplify();
-      else if (!workListMoves->Empty()) Coalesce();
-      else if (!freezeWorkList->Empty()) Freeze();
-      else if (!spillWorkList->Empty()) SelectSpill();
+    /* every spill starts one more round, timed separately */
+    std::string function(frame_->Name()->Name());
+    round_++;
+    {
+      stats::PassTimer timer("RA.Liveness", function, round_);
+      LivenessAnalysis();
+    }
+    {
+      stats::PassTimer timer("RA.Build", function, round_);
+      Build();
+      MakeWorkList();
     }
-    AssignColor();
-    if (!spilledNodes->Empty()) {
-      TigerLog("%ld nodes spilled!\n", spilledNodes->GetList().size());
-      RewriteProgram();
+    {
+      stats::PassTimer simplify("RA.Simplify", function, round_, false);
+      stats::PassTimer coalesce("RA.Coalesce", function, round_, false);
+      stats::PassTimer freeze("RA.Freeze", function, round_, false);
+      stats::PassTimer select_spill("RA.SelectSpill", function, round_, false);
+      while (!nodeSets.Empty(NodeState::SIMPLIFY) ||
+          !moveSets.Empty(MoveState::WORKLIST) ||
+          !nodeSets.Empty(NodeState::FREEZE) ||
+          !nodeSets.Empty(NodeState::SPILL)) {
+        if (!nodeSets.Empty(NodeState::SIMPLIFY)) {
+          simplify.Resume(); Simplify(); simplify.Pause();
+        } else if (!moveSets.Empty(MoveState::WORKLIST)) {
+          coalesce.Resume(); Coalesce(); coalesce.Pause();
+        } else if (!nodeSets.Empty(NodeState::FREEZE)) {
+          freeze.Resume(); Freeze(); freeze.Pause();
+        } else if (!nodeSets.Empty(NodeState::SPILL)) {
+          select_spill.Resume(); SelectSpill(); select_spill.Pause();
+        }
+      }
+    }
+    {
+      stats::PassTimer timer("RA.AssignColor", function, round_);
+      AssignColor();
+    }
+    if (!nodeSets.Empty(NodeState::SPILLED)) {
+      {
+        stats::PassTimer timer("RA.Rewrite", function, round_);
+        RewriteProgram();
+      }
       RegAlloc();
     }
 }
 
 void RegAllocator::LivenessAnalysis() {
-  fg::FlowGraphFactory fgFactory(assem_instr_->GetInstrList());
-  fgFactory.AssemFlowGraph();
-  live::LiveGraphFactory lgFactory(fgFactory.GetFlowGraph());
-  lgFactory.Liveness();
-  liveGraph = lgFactory.GetLiveGraph();
+  if (!lgFactory) {
+    fgFactory = std::make_unique<fg::FlowGraphFactory>(
+        assem_instr_->GetInstrList());
+    fgFactory->AssemFlowGraph();
+    lgFactory = std::make_unique<live::LiveGraphFactory>(
+        fgFactory->GetFlowGraph(), reg_manager_);
+    lgFactory->Liveness();
+    liveGraph = lgFactory->GetLiveGraph();
+    SpillCosts();
+  } else {
+    /* edges added by Combine() stood for coalesced moves, not interference */
+    for (const auto &edge : combinedEdges)
+      liveGraph.interf_graph->RemoveEdge(edge.first, edge.second);
+    combinedEdges.clear();
+    lgFactory->Update(spilledNodes, rewrittenBlocks);
+    liveGraph = lgFactory->GetLiveGraph();
+    /* the nodes since are temps of spill code, which must not spill again */
+    double inf = std::numeric_limits<double>::infinity();
+    spillCost.resize(liveGraph.interf_graph->Nodes().size(),
+                     SpillCost{inf, inf, nullptr});
+  }
+}
+
+void RegAllocator::SpillCosts() {
+  /* every use and def counts 10 ^ (loop depth of its block) */
+  const auto &nodes = liveGraph.interf_graph->Nodes();
+  spillCost.assign(nodes.size(), SpillCost());
+  std::vector<double> useCost(nodes.size(), 0);
+  std::vector<bool> plain(nodes.size(), false);
+  for (const auto &block : fgFactory->GetFlowGraph()->Blocks()) {
+    double weight = std::pow(10.0, block.loop_depth_);
+    for (auto pos = block.begin_; pos != block.End(); ++pos) {
+      for (auto temp : (*pos)->Def()) {
+        int key = liveGraph.interf_graph->Look(temp)->Key();
+        SpillCost &cost = spillCost[key];
+        cost.plain_ += weight;
+        if (!Rematerializable(*pos, reg_manager_) ||
+            (cost.remat_ && !SameValue(cost.remat_, *pos)))
+          plain[key] = true;
+        cost.remat_ = *pos;
+      }
+      for (auto temp : (*pos)->Use()) {
+        int key = liveGraph.interf_graph->Look(temp)->Key();
+        spillCost[key].plain_ += weight;
+        useCost[key] += weight;
+      }
+    }
+  }
+  /* a rematerialized node loses its defs, and computes its value again for
+   * each use at about half the cost of a load */
+  for (size_t key = 0; key < nodes.size(); key++) {
+    SpillCost &cost = spillCost[key];
+    if (cost.remat_ && !plain[key]) {
+      cost.cost_ = useCost[key] / 2;
+    } else {
+      cost.cost_ = cost.plain_;
+      cost.remat_ = nullptr;
+    }
+  }
 }
 
 void RegAllocator::Build() {
-  ClearAll();
-  /* add all moves to workListMoves */
-  workListMoves = liveGraph.moves;
-  /* constrcut move_list */
-  for (auto node : liveGraph.interf_graph->Nodes()->GetList()) {
-    auto temp = node->NodeInfo();
-    
-    if (PreColored(node)) {
-      color[node] = temp;
-      degree[node] = std::numeric_limits<int>::max();
+  const auto &nodes = liveGraph.interf_graph->Nodes();
+  int count = static_cast<int>(nodes.size());
+  /* nodes of the last round must not keep their colors */
+  nodeSets.Reset(count, NodeState::INITIAL);
+  moveList.assign(count, {});
+  moveCount.assign(count, 0);
+  alias.assign(count, nullptr);
+  degree.assign(count, 0);
+  color.assign(count, nullptr);
+  groupCost = spillCost;
+  mark.assign(count, 0);
+  epoch = 0;
+  for (auto node : nodes) {
+    if (node->Removed()) {
+      nodeSets.Move(node->Key(), NodeState::REMOVED);
+    } else if (PreColored(node)) {
+      nodeSets.Move(node->Key(), NodeState::PRECOLORED);
+      color[node->Key()] = node->NodeInfo();
+      degree[node->Key()] = std::numeric_limits<int>::max();
     } else {
-      /* OutDegree == InDegree */
-      degree[node] = node->OutDegree();
+      degree[node->Key()] = node->Degree();
     }
-      
-    /* construct move_list */
-    MoveListPtr moves = new MoveList();
-    for (const auto &move : workListMoves->GetList()) {
-      if (move.first == node || move.second == node) {
-        moves->Append(move.first, move.second);
-      }
+  }
+  /* add all moves to the worklist, each one to the lists of both ends */
+  const auto &liveMoves = liveGraph.moves->GetList();
+  moves.assign(liveMoves.begin(), liveMoves.end());
+  moveSets.Reset(static_cast<int>(moves.size()), MoveState::WORKLIST);
+  for (int m = 0; m < static_cast<int>(moves.size()); m++) {
+    for (auto node : {moves[m].first, moves[m].second}) {
+      moveList[node->Key()].push_back(m);
+      moveCount[node->Key()]++;
     }
-    moveList[node] = moves;
   }
 }
 
 void RegAllocator::MakeWorkList() {
-  for (auto node : liveGraph.interf_graph->Nodes()->GetList()) {
-    if (PreColored(node)) continue;
-    if (node->OutDegree() >= K) 
-      spillWorkList->Append(node);
+  for (auto node : liveGraph.interf_graph->Nodes()) {
+    if (State(node) != NodeState::INITIAL) continue;
+    if (degree[node->Key()] >= K)
+      nodeSets.Move(node->Key(), NodeState::SPILL);
     else if (MoveRelated(node))
-      freezeWorkList->Append(node);
-    else 
-      simplifyWorkList->Append(node);
+      nodeSets.Move(node->Key(), NodeState::FREEZE);
+    else
+      nodeSets.Move(node->Key(), NodeState::SIMPLIFY);
   }
 }
 
 void RegAllocator::Simplify() {
-  NodePtr node = simplifyWorkList->GetOne();
-  simplifyWorkList->DeleteNode(node);
-  selectStack->Push(node);
-  for (auto adjNode : Adjacent(node)->GetList()) {
-    DecrementDegree(adjNode);
+  NodePtr node = NodeOf(nodeSets.Front(NodeState::SIMPLIFY));
+  nodeSets.Move(node->Key(), NodeState::SELECT);
+  for (auto adjNode : node->Adj()) {
+    if (InGraph(adjNode))
+      DecrementDegree(adjNode);
   }
 }
 
 void RegAllocator::Coalesce() {
   /* (frist, second) = (x, y) */
-  auto move = workListMoves->GetOne();
+  int m = moveSets.Front(MoveState::WORKLIST);
+  const Move &move = moves[m];
   Node *u, *v;
   if (PreColored(move.second)) {
     v = GetAlias(move.first);
@@ -116,258 +256,230 @@ void RegAllocator::Coalesce() {
     u = GetAlias(move.first);
     v = GetAlias(move.second);
   }
-  workListMoves->Delete(move.first, move.second);
   if (u == v) {
-    coalescedMoves->Append(move.first, move.second);
+    RetireMove(m, MoveState::COALESCED);
     AddWorkList(u);
-  } else if (PreColored(v) || u->Adj()->Contain(v)) {
-    constrainedMoves->Append(move.first, move.second);
+  } else if (PreColored(v) || liveGraph.interf_graph->Adjacent(u, v)) {
+    RetireMove(m, MoveState::CONSTRAINED);
     AddWorkList(u);
     AddWorkList(v);
-  } else if ((PreColored(u) && OK(u, v)) || 
-    (!PreColored(u) && Conservative(Adjacent(u)->Union(Adjacent(v))))) {
-    coalescedMoves->Append(move.first, move.second);
+  } else if ((PreColored(u) && OK(u, v)) ||
+    (!PreColored(u) && Conservative(u, v))) {
+    RetireMove(m, MoveState::COALESCED);
     Combine(u, v);
     AddWorkList(u);
   } else {
-    activeMoves->Append(move.first, move.second);
+    moveSets.Move(m, MoveState::ACTIVE);
   }
-  
 }
 
 void RegAllocator::Freeze() {
-  auto u = freezeWorkList->GetOne();
-  freezeWorkList->DeleteNode(u);
-  simplifyWorkList->Append(u);
+  auto u = NodeOf(nodeSets.Front(NodeState::FREEZE));
+  nodeSets.Move(u->Key(), NodeState::SIMPLIFY);
   FreezeMoves(u);
 }
 
 void RegAllocator::SelectSpill() {
-  /* should be heuristic */
-  auto m = spillWorkList->GetOne();
-  spillWorkList->DeleteNode(m);
-  simplifyWorkList->Append(m);
+  /* the cheapest, by cost of the spill code over the neighbours it frees */
+  NodePtr m = nullptr;
+  double minCost = 0;
+  for (int n = nodeSets.Front(NodeState::SPILL); n != NodeSets::NONE;
+       n = nodeSets.Next(n)) {
+    double cost = groupCost[n].cost_ / degree[n];
+    if (!m || cost < minCost) {
+      m = NodeOf(n);
+      minCost = cost;
+    }
+  }
+  nodeSets.Move(m->Key(), NodeState::SIMPLIFY);
   FreezeMoves(m);
 }
 
 void RegAllocator::AssignColor() {
-  while (!selectStack->Empty()) {
-    auto n = selectStack->Pop();
+  temp::TempSet okColors;
+  while (!nodeSets.Empty(NodeState::SELECT)) {
+    auto n = NodeOf(nodeSets.Back(NodeState::SELECT));
     assert(!PreColored(n));
-    auto okColors = new temp::TempList(reg_manager->Registers());
-    for (auto w : n->Adj()->GetList()) {
+    okColors = reg_manager_->RegisterSet();
+    for (auto w : n->Adj()) {
       auto aliasW = GetAlias(w);
-      if (coloredNodes->Contain(aliasW) || PreColored(aliasW)) {
-        okColors->Delete(color[aliasW]);
-        // TigerLog("delete color %s for t%d\n", reg_manager->temp_map_->Look(color[aliasW])->c_str(), n->NodeInfo()->Int());
+      if (State(aliasW) == NodeState::COLORED || PreColored(aliasW)) {
+        okColors.Erase(color[aliasW->Key()]);
       }
     }
-    if (okColors->Empty()) {
-      spilledNodes->Append(n);
+    if (okColors.Empty()) {
+      nodeSets.Move(n->Key(), NodeState::SPILLED);
     } else {
-      coloredNodes->Append(n);
-      color[n] = okColors->GetOne();
-      TigerLog("assign color %s for t%d\n", reg_manager->temp_map_->Look(color[n])->c_str(), n->NodeInfo()->Int());
+      nodeSets.Move(n->Key(), NodeState::COLORED);
+      color[n->Key()] = *okColors.begin();
+      TigerLog("assign color %s for t%d\n", reg_manager_->temp_map_->Look(color[n->Key()])->c_str(), n->NodeInfo()->Int());
     }
   }
-  for (auto n : coalescedNodes->GetList()) {
-    color[n] = color[GetAlias(n)];
+  for (int n = nodeSets.Front(NodeState::COALESCED); n != NodeSets::NONE;
+       n = nodeSets.Next(n)) {
+    color[n] = color[GetAlias(NodeOf(n))->Key()];
   }
 }
 
 void RegAllocator::RewriteProgram() {
-  
-  for (auto node : spilledNodes->GetList()) {
-    TigerLog("spill temp: t%d\n", node->NodeInfo()->Int());
-    auto spilledTemp = node->NodeInfo();
-    /* must alloc space in frame */
-    frame_->AllocLocal(true);
-    int offset = frame_->Size();
-    auto instrList = assem_instr_->GetInstrList();
-    std::string fs = tree::fsPlaceHolder(frame_->Name()->Name());
-    auto sp = reg_manager->StackPointer();
-    auto instrItr = instrList->GetList().cbegin();
-    while (instrItr != instrList->GetList().cend()) {
-      auto instr = *instrItr;
-      temp::TempList *src = nullptr;
-      temp::TempList *dst = nullptr;
-      if (typeid(*instr) == typeid(assem::OperInstr)) {
-        src = static_cast<assem::OperInstr*>(instr)->src_;
-        dst = static_cast<assem::OperInstr*>(instr)->dst_;
-      } else if (typeid(*instr) == typeid(assem::MoveInstr)) {
-        src = static_cast<assem::MoveInstr*>(instr)->src_;
-        dst = static_cast<assem::MoveInstr*>(instr)->dst_;
-      }
-
-      if ((src && src->Contain(spilledTemp)) || (dst && dst->Contain(spilledTemp))) {
-        /* create new temp vi for each use / def of spilled temp v */
-        temp::Temp *vi = temp::TempFactory::NewTemp();
-        if (src && src->Contain(spilledTemp)) {
-          /* use spilled temp: insert load-instr before it */
-          char load[77];
-          sprintf(load, "movq (%s - %d)(`s0), `d0", fs.c_str(), offset);
-          assem::Instr *loadFromFrame = new assem::MoveInstr(
-            load, new temp::TempList(vi), new temp::TempList(sp));
-          assem_instr_->GetInstrList()->Insert(instrItr, loadFromFrame);
-          src->Replace(spilledTemp, vi);
-        }
-
-        if (dst && dst->Contain(spilledTemp)) {
-          /* def spilled temp: insert store-instr after it */
-          char store[77];
-          sprintf(store, "movq `s0, (%s - %d)(`s1)", fs.c_str(), offset);
-          assem::Instr *storeToFrame = new assem::MoveInstr(
-            store, nullptr, new temp::TempList({vi, sp}));
-          assem_instr_->GetInstrList()->Insert(std::next(instrItr), storeToFrame);
-          dst->Replace(spilledTemp, vi);
-          ++instrItr;
-        }
-      } 
-      ++instrItr;
-    }
+  spilledNodes.clear();
+  for (int n = nodeSets.Front(NodeState::SPILLED); n != NodeSets::NONE;
+       n = nodeSets.Next(n)) {
+    spilledNodes.push_back(NodeOf(n));
   }
-  spilledNodes->Clear();
-  coloredNodes->Clear();
-  coalescedNodes->Clear();
+  /* temps coalesced into a spilled node go to memory as well, otherwise
+   * they coalesce with its new temps again and spilling never ends */
+  for (int n = nodeSets.Front(NodeState::COALESCED); n != NodeSets::NONE;
+       n = nodeSets.Next(n)) {
+    if (State(GetAlias(NodeOf(n))) == NodeState::SPILLED)
+      spilledNodes.push_back(NodeOf(n));
+  }
+  TigerLog("%ld nodes spilled!\n", spilledNodes.size());
+
+  std::vector<temp::Temp *> temps;
+  for (auto node : spilledNodes)
+    temps.push_back(node->NodeInfo());
+  if (!rewriter) {
+    rewriter = std::make_unique<SpillRewriter>(
+        frame_, reg_manager_, assem_instr_->GetInstrList(),
+        fgFactory->GetFlowGraph());
+  }
+  rewrittenBlocks = rewriter->Rewrite(temps, lgFactory.get());
 }
 
 void RegAllocator::AddEdge(Node *u, Node *v) {
-  if (u->Adj()->Contain(v) || u == v) return;
-  if (!PreColored(u)) {
-    liveGraph.interf_graph->AddEdge(u, v);
-    degree[u]++;
-  } 
-  if (!PreColored(v)) {
-    liveGraph.interf_graph->AddEdge(v, u);
-    degree[v]++;
-  } 
+  if (!liveGraph.interf_graph->AddEdge(u, v)) return;
+  combinedEdges.emplace_back(u, v);
+  if (!PreColored(u)) degree[u->Key()]++;
+  if (!PreColored(v)) degree[v->Key()]++;
 }
 
 bool RegAllocator::MoveRelated(Node *n) {
-  return !NodeMoves(n)->GetList().empty();
-}
-
-MoveListPtr RegAllocator::NodeMoves(Node *n) {
-  return moveList[n]->Intersect(activeMoves->Union(workListMoves));
+  return moveCount[n->Key()] > 0;
 }
 
 bool RegAllocator::PreColored(Node *n) {
-  return reg_manager->Registers()->Contain(n->NodeInfo());
+  return n->Precolored();
 }
 
-NodeListPtr RegAllocator::Adjacent(Node *n) {
-  /* undirect graph: Succ is enough */
-  return n->Adj()->Diff(selectStack->Union(coalescedNodes));
+bool RegAllocator::InGraph(Node *n) {
+  NodeState state = State(n);
+  return state != NodeState::SELECT && state != NodeState::COALESCED;
 }
 
 void RegAllocator::DecrementDegree(Node *n) {
-  int d = degree[n]--;
+  int d = degree[n->Key()]--;
   if (d == K) {
-    NodeListPtr nl = new NodeList(); nl->Append(n);
-    EnableMoves(Adjacent(n)->Union(nl));
-    delete nl;
-    spillWorkList->DeleteNode(n);
+    EnableMoves(n);
+    for (auto m : n->Adj()) {
+      if (InGraph(m))
+        EnableMoves(m);
+    }
     if (MoveRelated(n)) {
-      freezeWorkList->Append(n);
+      nodeSets.Move(n->Key(), NodeState::FREEZE);
     } else {
-      simplifyWorkList->Append(n);
+      nodeSets.Move(n->Key(), NodeState::SIMPLIFY);
     }
   }
 }
 
-void RegAllocator::EnableMoves(NodeList *nl) {
-  for (auto node : nl->GetList()) {
-    for (auto move : NodeMoves(node)->GetList()) {
-      if (activeMoves->Contain(move.first, move.second)) {
-        activeMoves->Delete(move.first, move.second);
-        workListMoves->Append(move.first, move.second);
-      }
-    }
+void RegAllocator::EnableMoves(Node *n) {
+  for (int m : moveList[n->Key()]) {
+    if (moveSets.Of(m) == MoveState::ACTIVE)
+      moveSets.Move(m, MoveState::WORKLIST);
   }
 }
 
-void RegAllocator::ClearAll() {
-  /* clear work_list */
-  simplifyWorkList->Clear();
-  freezeWorkList->Clear();
-  spillWorkList->Clear();
-  spilledNodes->Clear();
-  coalescedNodes->Clear();
-  coloredNodes->Clear();
-  selectStack->Clear();
-  /* clear other */
-  moveList.clear();
-  degree.clear();
-  alias.clear();
+void RegAllocator::RetireMove(int m, MoveState state) {
+  /* the move has an entry in the lists of both ends, wherever they went */
+  moveSets.Move(m, state);
+  moveCount[GetAlias(moves[m].first)->Key()]--;
+  moveCount[GetAlias(moves[m].second)->Key()]--;
 }
 
 NodePtr RegAllocator::GetAlias(Node *n) {
-  if (coalescedNodes->Contain(n)) 
-    return GetAlias(alias[n]);
+  while (State(n) == NodeState::COALESCED)
+    n = alias[n->Key()];
   return n;
 }
 
 void RegAllocator::AddWorkList(Node *n) {
-  if (!PreColored(n) && !MoveRelated(n) && degree[n] < K) {
-    freezeWorkList->DeleteNode(n);
-    simplifyWorkList->Append(n);
+  if (!PreColored(n) && !MoveRelated(n) && degree[n->Key()] < K) {
+    nodeSets.Move(n->Key(), NodeState::SIMPLIFY);
   }
 }
 
 /* ok with george's rule */
 bool RegAllocator::OK(Node *u, Node *v) {
-  for (auto t : Adjacent(v)->GetList()) {
-    if (!(degree[t] < K || PreColored(t) || t->Adj()->Contain(u)))
+  for (auto t : v->Adj()) {
+    if (!InGraph(t)) continue;
+    if (!(degree[t->Key()] < K || PreColored(t) ||
+          liveGraph.interf_graph->Adjacent(t, u)))
       return false;
   }
   return true;
 }
 
-bool RegAllocator::Conservative(NodeList *nodes) {
+/* briggs's rule on the neighbours of u and v together */
+bool RegAllocator::Conservative(Node *u, Node *v) {
+  /* a node adjacent to both is counted once, by its mark */
+  epoch++;
   int k = 0;
-  for (auto n : nodes->GetList()) {
-    if (degree[n] >= K) k++;
+  for (auto n : {u, v}) {
+    for (auto t : n->Adj()) {
+      if (!InGraph(t) || mark[t->Key()] == epoch) continue;
+      mark[t->Key()] = epoch;
+      if (degree[t->Key()] >= K) k++;
+    }
   }
   return k < K;
 }
 
 void RegAllocator::Combine(Node *u, Node *v) {
-  if (freezeWorkList->Contain(v)) {
-    freezeWorkList->DeleteNode(v);
+  nodeSets.Move(v->Key(), NodeState::COALESCED);
+  alias[v->Key()] = u;
+  auto &uMoves = moveList[u->Key()];
+  const auto &vMoves = moveList[v->Key()];
+  uMoves.insert(uMoves.end(), vMoves.begin(), vMoves.end());
+  moveCount[u->Key()] += moveCount[v->Key()];
+  /* v is spilled along with u, see RewriteProgram(); the two are only
+   * rematerialized together if they compute the same value */
+  SpillCost &uCost = groupCost[u->Key()];
+  const SpillCost &vCost = groupCost[v->Key()];
+  if (uCost.remat_ && vCost.remat_ && SameValue(uCost.remat_, vCost.remat_)) {
+    uCost.cost_ += vCost.cost_;
   } else {
-    spillWorkList->DeleteNode(v);
+    uCost.cost_ = uCost.plain_ + vCost.plain_;
+    uCost.remat_ = nullptr;
   }
-  coalescedNodes->Append(v);
-  alias[v] = u;
-  moveList[u]->UnionWith(moveList[v]);
-  NodeListPtr vnl = new NodeList(); vnl->Append(v);
-  EnableMoves(vnl);
-  delete vnl;
-  for (auto t : Adjacent(v)->GetList()) {
+  uCost.plain_ += vCost.plain_;
+  EnableMoves(v);
+  for (auto t : v->Adj()) {
+    if (!InGraph(t)) continue;
     AddEdge(t, u);
     DecrementDegree(t);
   }
-  if (degree[u] >= K && freezeWorkList->Contain(u)) {
-    freezeWorkList->DeleteNode(u);
-    simplifyWorkList->Append(u);
+  if (degree[u->Key()] >= K && State(u) == NodeState::FREEZE) {
+    nodeSets.Move(u->Key(), NodeState::SPILL);
   }
 }
 
 void RegAllocator::FreezeMoves(Node *u) {
-  for (auto move : NodeMoves(u)->GetList()) {
+  for (int m : moveList[u->Key()]) {
+    MoveState state = moveSets.Of(m);
+    if (state != MoveState::WORKLIST && state != MoveState::ACTIVE) continue;
+    const Move &move = moves[m];
     NodePtr v;
     if (GetAlias(move.second) == GetAlias(u)) {
       v = GetAlias(move.first);
     } else {
       v = GetAlias(move.second);
     }
-    activeMoves->Delete(move.first, move.second);
-    frozenMoves->Append(move.first, move.second);
-    if (NodeMoves(v)->Empty() && degree[v] < K) {
-      freezeWorkList->DeleteNode(v);
-      simplifyWorkList->Append(v);
+    RetireMove(m, MoveState::FROZEN);
+    if (!MoveRelated(v) && degree[v->Key()] < K) {
+      nodeSets.Move(v->Key(), NodeState::SIMPLIFY);
     }
   }
 }
 
-} // namespace ra
\ No newline at end of file
+} // namespace ra
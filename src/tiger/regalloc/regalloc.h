@@ -7,26 +7,46 @@
 #include "tiger/frame/temp.h"
 #include "tiger/liveness/liveness.h"
 #include "tiger/regalloc/color.h"
-#include "tiger/util/graph.h"
+#include "tiger/regalloc/spill.h"
+#include "tiger/regalloc/worklist.h"
 
-#include <set>
-#include <stack>
-#include <map>
+#include <vector>
 
 namespace ra {
 
-using Node = graph::Node<temp::Temp>;
-using NodePtr = graph::Node<temp::Temp>*;
-using NodeList = graph::NodeList<temp::Temp>;
-using NodeListPtr = graph::NodeList<temp::Temp>*;
-using MoveList = live::MoveList;
-using MoveListPtr = live::MoveList*;
+using Node = live::INode;
+using NodePtr = live::INode*;
 using LiveGraph = live::LiveGraph;
+using Move = std::pair<NodePtr, NodePtr>;
+
+/* the worklist or set of a node, from Appel's iterated register coalescing */
+enum class NodeState : uint8_t {
+  PRECOLORED,
+  INITIAL,
+  SIMPLIFY,
+  FREEZE,
+  SPILL,
+  SPILLED,
+  COALESCED,
+  COLORED,
+  SELECT,
+  /* spilled in an earlier round, its temp is no longer in the code */
+  REMOVED,
+  COUNT
+};
+
+/* the set of a move, only WORKLIST and ACTIVE moves may still coalesce */
+enum class MoveState : uint8_t {
+  WORKLIST,
+  ACTIVE,
+  FROZEN,
+  CONSTRAINED,
+  COALESCED,
+  COUNT
+};
 
-using NodeMoveMap = std::map<Node*, MoveList*>;
-using DegreeMap = std::map<NodePtr, int>;
-using AliasMap = std::map<NodePtr, NodePtr>;
-using ColorMap = std::map<NodePtr, temp::Temp*>;
+using NodeSets = WorkLists<NodeState, static_cast<size_t>(NodeState::COUNT)>;
+using MoveSets = WorkLists<MoveState, static_cast<size_t>(MoveState::COUNT)>;
 
 class Result {
 public:
@@ -45,7 +65,8 @@ public:
 
 class RegAllocator {
 public:
-  RegAllocator(frame::Frame *frame_, std::unique_ptr<cg::AssemInstr> assem_instr);
+  RegAllocator(ctx::CompilerContext *context, frame::Frame *frame_,
+               std::unique_ptr<cg::AssemInstr> assem_instr);
   std::unique_ptr<Result> TransferResult();
   void RegAlloc();
 
@@ -60,55 +81,91 @@ private:
   void SelectSpill();
   void AssignColor();
   void RewriteProgram();
+  void SpillCosts();
 
   void AddEdge(Node *u, Node *v);
   bool MoveRelated(Node *n);
-  MoveListPtr NodeMoves(Node *n);
   bool PreColored(Node *n);
-  NodeListPtr Adjacent(Node *n);
+  /* not removed from the graph, i.e. neither on selectStack nor coalesced */
+  bool InGraph(Node *n);
   void DecrementDegree(Node *n);
-  void EnableMoves(NodeList *nl);
-  void ClearAll();
+  void EnableMoves(Node *n);
+  /* take a move out of the worklist or activeMoves for good */
+  void RetireMove(int m, MoveState state);
   NodePtr GetAlias(Node *n);
   void AddWorkList(Node *n);
   bool OK(Node *u, Node *v);
-  bool Conservative(NodeList *nl);
+  bool Conservative(Node *u, Node *v);
   void Combine(Node *u, Node *v);
   void FreezeMoves(Node *u);
 
-  /* Node set: except precolored & inital */
-  NodeListPtr simplifyWorkList;
-  NodeListPtr freezeWorkList;
-  NodeListPtr spillWorkList;
-  NodeListPtr spilledNodes;
-  NodeListPtr coloredNodes;
-  NodeListPtr coalescedNodes;
-  NodeListPtr selectStack;
-
-  MoveListPtr workListMoves;
-  MoveListPtr activeMoves;
-  MoveListPtr frozenMoves;
-  MoveListPtr constrainedMoves;
-  MoveListPtr coalescedMoves;
-
-  NodeMoveMap moveList;
-  AliasMap alias;
-  DegreeMap degree;
-  ColorMap color;
-
+  NodeState State(Node *n) { return nodeSets.Of(n->Key()); }
+  NodePtr NodeOf(int key) { return liveGraph.interf_graph->Nodes()[key]; }
+
+  /* every node is in exactly one list, nodes are indexed by their keys */
+  NodeSets nodeSets;
+  /* every move is in exactly one list, moves are indexed by their position */
+  MoveSets moveSets;
+  std::vector<Move> moves;
+
+  /* moves of each node, including those of the nodes coalesced into it */
+  std::vector<std::vector<int>> moveList;
+  /* entries of moveList[n] still in the worklist or activeMoves */
+  std::vector<int> moveCount;
+  std::vector<NodePtr> alias;
+  std::vector<int> degree;
+  std::vector<temp::Temp *> color;
+  /* of spilling a node, its uses and defs weighted by loop depth */
+  struct SpillCost {
+    /* infinite for the temps of spill code */
+    double cost_ = 0;
+    /* with a load or store at each reference, as if not rematerialized */
+    double plain_ = 0;
+    /* the def computing the value again at each use, nullptr if loaded */
+    assem::Instr *remat_ = nullptr;
+  };
+  /* of each node alone, kept across rounds */
+  std::vector<SpillCost> spillCost;
+  /* of each node with the nodes coalesced into it in this round */
+  std::vector<SpillCost> groupCost;
+  /* nodes seen by the current Conservative(), marked with its epoch */
+  std::vector<uint32_t> mark;
+  uint32_t epoch = 0;
+
+  /* kept across rounds, which patch them after spilling */
+  std::unique_ptr<fg::FlowGraphFactory> fgFactory;
+  std::unique_ptr<live::LiveGraphFactory> lgFactory;
   LiveGraph liveGraph;
+  /* edges added while coalescing, undone before the next round */
+  std::vector<Move> combinedEdges;
+  /* what the last RewriteProgram() changed */
+  std::vector<NodePtr> spilledNodes;
+  std::vector<int> rewrittenBlocks;
+  std::unique_ptr<SpillRewriter> rewriter;
 
 
   
   std::unique_ptr<Result> result_;
+  ctx::CompilerContext *context_;
+  frame::RegManager *reg_manager_;
   frame::Frame *frame_;
   std::unique_ptr<cg::AssemInstr> assem_instr_;
   int K;
+  int round_ = 0; // rounds of RegAlloc so far, one more after every spill
   
 
 
 };
 
+/**
+ * Allocate the registers of a function with the allocator the options of
+ * the context ask for, falling back to linear scan for a function with more
+ * temps than they allow to color
+ */
+std::unique_ptr<Result> Allocate(ctx::CompilerContext *context,
+                                 frame::Frame *frame,
+                                 std::unique_ptr<cg::AssemInstr> assem_instr);
+
 } // namespace ra
 
 #endif
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include "tiger/regalloc/spill.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "tiger/output/logger.h"
+
+namespace ra {
+
+bool Rematerializable(const assem::Instr *instr,
+                      frame::RegManager *reg_manager) {
+  if (instr->Def().Size() != 1)
+    return false;
+  if (typeid(*instr) == typeid(assem::MoveInstr)) {
+    auto move = static_cast<const assem::MoveInstr *>(instr);
+    /* movq $imm, t from ConstExp */
+    if (move->op_ == assem::Opcode::MOVQ &&
+        move->operands_[0].kind_ == assem::Operand::IMM)
+      return move->Use().Empty();
+    /* leaq fs(%rsp), t from the frame pointer of TempExp */
+    if (move->op_ == assem::Opcode::LEAQ &&
+        move->operands_[0].kind_ == assem::Operand::FRAME)
+      return move->Use().Size() == 1 &&
+             move->Use()[0] == reg_manager->StackPointer();
+  } else if (typeid(*instr) == typeid(assem::OperInstr)) {
+    /* leaq name(%rip), t from NameExp */
+    auto oper = static_cast<const assem::OperInstr *>(instr);
+    return oper->op_ == assem::Opcode::LEAQ &&
+           oper->operands_[0].kind_ == assem::Operand::RIP &&
+           oper->Use().Empty();
+  }
+  return false;
+}
+
+bool SameValue(const assem::Instr *a, const assem::Instr *b) {
+  if (typeid(*a) != typeid(*b))
+    return false;
+  const assem::Operand *x, *y;
+  if (typeid(*a) == typeid(assem::MoveInstr)) {
+    auto moveA = static_cast<const assem::MoveInstr *>(a);
+    auto moveB = static_cast<const assem::MoveInstr *>(b);
+    if (moveA->op_ != moveB->op_)
+      return false;
+    x = &moveA->operands_[0];
+    y = &moveB->operands_[0];
+  } else {
+    auto operA = static_cast<const assem::OperInstr *>(a);
+    auto operB = static_cast<const assem::OperInstr *>(b);
+    if (operA->op_ != operB->op_)
+      return false;
+    x = &operA->operands_[0];
+    y = &operB->operands_[0];
+  }
+  /* the base of a frame address is %rsp in both */
+  return x->kind_ == y->kind_ && x->disp_ == y->disp_ &&
+         x->label_ == y->label_;
+}
+
+assem::Instr *SpillRewriter::Clone(const assem::Instr *def,
+                                   temp::Temp *temp) {
+  if (typeid(*def) == typeid(assem::MoveInstr)) {
+    auto move = static_cast<const assem::MoveInstr *>(def);
+    auto src = move->Use().Empty()
+                   ? nullptr
+                   : new temp::TempList(move->Use()[0]);
+    return new assem::MoveInstr(move->op_, move->operands_[0],
+                                move->operands_[1], new temp::TempList(temp),
+                                src);
+  }
+  auto oper = static_cast<const assem::OperInstr *>(def);
+  return new assem::OperInstr(oper->op_, oper->operands_[0],
+                              oper->operands_[1], new temp::TempList(temp),
+                              nullptr, nullptr);
+}
+
+void SpillRewriter::Classify(const std::vector<temp::Temp *> &spilled) {
+  size_t ids = 0;
+  for (auto temp : spilled)
+    ids = std::max(ids, static_cast<size_t>(temp->Int()) + 1);
+  offsets_.assign(ids, 0);
+  remat_.assign(ids, nullptr);
+  /* spilled temps, then cleared for those with a def not to recompute */
+  std::vector<bool> candidate(ids, false);
+  for (auto temp : spilled)
+    candidate[temp->Int()] = true;
+  for (const auto &block : flowgraph_->Blocks()) {
+    for (auto pos = block.begin_; pos != block.End(); ++pos) {
+      for (auto temp : (*pos)->Def()) {
+        size_t id = temp->Int();
+        if (id >= ids || !candidate[id])
+          continue;
+        if (!Rematerializable(*pos, reg_manager_) ||
+            (remat_[id] && !SameValue(remat_[id], *pos))) {
+          candidate[id] = false;
+          remat_[id] = nullptr;
+        } else {
+          remat_[id] = *pos;
+        }
+      }
+    }
+  }
+
+  /* must alloc space in frame */
+  for (auto temp : spilled) {
+    if (remat_[temp->Int()]) {
+      TigerLog("rematerialize temp: t%d\n", temp->Int());
+      continue;
+    }
+    TigerLog("spill temp: t%d\n", temp->Int());
+    frame_->AllocLocal(true);
+    offsets_[temp->Int()] = frame_->Size();
+  }
+}
+
+void SpillRewriter::Erase(fg::Block &block, fg::InstrPos pos) {
+  assert(block.begin_ != block.last_);
+  if (block.begin_ == pos)
+    block.begin_ = std::next(pos);
+  else if (block.last_ == pos)
+    block.last_ = std::prev(pos);
+  instr_list_->Erase(pos);
+}
+
+temp::Temp *SpillRewriter::NewTemp() {
+  temp::Temp *temp = temp::TempFactory::NewTemp();
+  if (made_.size() <= static_cast<size_t>(temp->Int()))
+    made_.resize(temp->Int() + 1, false);
+  made_[temp->Int()] = true;
+  return temp;
+}
+
+void SpillRewriter::EndBlock(fg::Block &block, int b) {
+  auto graph = liveness_->GetLiveGraph().interf_graph;
+  for (auto temp : touched_) {
+    Local &local = local_[temp->Int()];
+    if (local.pending_ && !liveness_->Out(b).Test(graph->Look(temp)->Key()))
+      Erase(block, local.store_);
+    local = Local();
+  }
+  touched_.clear();
+}
+
+std::vector<int>
+SpillRewriter::Rewrite(const std::vector<temp::Temp *> &spilled,
+                       live::LiveGraphFactory *liveness) {
+  liveness_ = liveness;
+  Classify(spilled);
+  local_.assign(offsets_.size(), Local());
+  touched_.clear();
+
+  /* one pass over the blocks, which learn about the instructions inserted
+   * at their ends */
+  auto sp = reg_manager_->StackPointer();
+  auto &blocks = flowgraph_->Blocks();
+  std::vector<temp::Temp *> temps;
+  std::vector<int> rewritten;
+  for (int b = 0; b < static_cast<int>(blocks.size()); b++) {
+    auto &block = blocks[b];
+    for (auto instrItr = block.begin_; instrItr != block.End();) {
+      auto instr = *instrItr;
+      temps.clear();
+      for (auto temp : instr->Use()) {
+        if ((Offset(temp) || Remat(temp)) &&
+            std::find(temps.begin(), temps.end(), temp) == temps.end())
+          temps.push_back(temp);
+      }
+      for (auto temp : instr->Def()) {
+        if ((Offset(temp) || Remat(temp)) &&
+            std::find(temps.begin(), temps.end(), temp) == temps.end())
+          temps.push_back(temp);
+      }
+      if (temps.empty()) {
+        /* the values held in caller-saved registers would be lost */
+        if (instr->IsCall()) {
+          for (auto temp : touched_)
+            local_[temp->Int()].temp_ = nullptr;
+        }
+        ++instrItr;
+        continue;
+      }
+      if (rewritten.empty() || rewritten.back() != b)
+        rewritten.push_back(b);
+
+      /* the operand lists of the instruction are rewritten in place */
+      temp::TempList *src = nullptr;
+      temp::TempList *dst = nullptr;
+      if (typeid(*instr) == typeid(assem::OperInstr)) {
+        src = static_cast<assem::OperInstr *>(instr)->src_;
+        dst = static_cast<assem::OperInstr *>(instr)->dst_;
+      } else if (typeid(*instr) == typeid(assem::MoveInstr)) {
+        src = static_cast<assem::MoveInstr *>(instr)->src_;
+        dst = static_cast<assem::MoveInstr *>(instr)->dst_;
+      }
+
+      /* a def of a rematerialized temp is all the instruction does */
+      if (instr->Def().Size() == 1 && Remat(instr->Def()[0])) {
+        if (block.begin_ == block.last_) {
+          /* keep the block from getting empty, the def is dead */
+          dst->Replace(temps[0], NewTemp());
+          ++instrItr;
+          continue;
+        }
+        auto next = std::next(instrItr);
+        Erase(block, instrItr);
+        instrItr = next;
+        continue;
+      }
+
+      /* the last of the instruction and its stores */
+      auto last = instrItr;
+      for (auto spilledTemp : temps) {
+        Local &local = local_[spilledTemp->Int()];
+        if (!local.touched_) {
+          local.touched_ = true;
+          touched_.push_back(spilledTemp);
+        }
+        int offset = Offset(spilledTemp);
+        assem::Instr *def = Remat(spilledTemp);
+        bool uses = instr->Use().Contain(spilledTemp);
+        bool defs = instr->Def().Contain(spilledTemp);
+        /* an instruction reading and writing the temp keeps it in one
+         * register, as in addq */
+        temp::Temp *vi = uses ? local.temp_ : nullptr;
+        if (!vi) {
+          vi = NewTemp();
+          if (uses) {
+            /* use spilled temp: insert load-instr, or the def, before it */
+            assem::Instr *loadFromFrame =
+                def ? Clone(def, vi)
+                    : new assem::MoveInstr(
+                          assem::Opcode::MOVQ,
+                          assem::Operand::Frame(frame_->Name(), -offset, 0),
+                          assem::Operand::Dst(0), new temp::TempList(vi),
+                          new temp::TempList(sp));
+            auto load = instr_list_->Insert(instrItr, loadFromFrame);
+            if (block.begin_ == instrItr)
+              block.begin_ = load;
+            local.pending_ = false;
+          }
+        }
+        if (uses)
+          src->Replace(spilledTemp, vi);
+
+        if (defs) {
+          /* the slot is written again before anything reads it */
+          if (local.pending_)
+            Erase(block, local.store_);
+          /* def spilled temp: insert store-instr after it */
+          assem::Instr *storeToFrame = new assem::MoveInstr(
+              assem::Opcode::MOVQ, assem::Operand::Src(0),
+              assem::Operand::Frame(frame_->Name(), -offset, 1), nullptr,
+              new temp::TempList({vi, sp}));
+          auto store = instr_list_->Insert(std::next(last), storeToFrame);
+          if (block.last_ == last)
+            block.last_ = store;
+          last = store;
+          dst->Replace(spilledTemp, vi);
+          local.store_ = store;
+          local.pending_ = true;
+        }
+        /* reusing a temp of spill code could spill it forever */
+        local.temp_ = Made(spilledTemp) ? nullptr : vi;
+      }
+      instrItr = std::next(last);
+    }
+    EndBlock(block, b);
+  }
+  return rewritten;
+}
+
+} // namespace ra
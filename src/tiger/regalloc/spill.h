@@ -0,0 +1,115 @@
+#ifndef TIGER_REGALLOC_SPILL_H_
+#define TIGER_REGALLOC_SPILL_H_
+
+#include <vector>
+
+#include "tiger/codegen/assem.h"
+#include "tiger/frame/frame.h"
+#include "tiger/frame/temp.h"
+#include "tiger/liveness/flowgraph.h"
+#include "tiger/liveness/liveness.h"
+
+namespace ra {
+
+/**
+ * Whether instr only computes its one def from constants, i.e. an
+ * immediate, the address of a label or an address in the frame, which
+ * stays the same as %rsp never moves within a function
+ */
+bool Rematerializable(const assem::Instr *instr,
+                      frame::RegManager *reg_manager);
+
+/* whether two rematerializable instructions compute the same value */
+bool SameValue(const assem::Instr *a, const assem::Instr *b);
+
+/**
+ * Spill code of the temps moved to the frame, one block at a time. The
+ * first use of a spilled temp in a block loads its slot into a new temp
+ * right before the instruction, and the uses after it read that temp until
+ * a call, which would need it in a callee-saved register. Each def writes a
+ * new temp, which later uses read as well, and stores it right after the
+ * instruction. A store goes away if the block writes the slot again before
+ * reading it, or if the temp is dead at the end of the block and nothing
+ * reads the slot before. The new temps never live out of their block.
+ * Temps of spill code going to memory again get a load for each use, so
+ * spilling them shortens their live ranges for sure.
+ *
+ * A temp whose defs all compute the same value that is Rematerializable()
+ * takes no slot: its defs go away and the first use after a call or at the
+ * start of a block computes the value again instead of loading it. The
+ * blocks of the flow graph learn about the instructions inserted and
+ * erased at their ends. The same rewriter serves every round of an
+ * allocator, to know the temps it made.
+ */
+class SpillRewriter {
+public:
+  SpillRewriter(frame::Frame *frame, frame::RegManager *reg_manager,
+                assem::InstrList *instr_list, fg::FlowGraph *flowgraph)
+      : frame_(frame), reg_manager_(reg_manager), instr_list_(instr_list),
+        flowgraph_(flowgraph) {}
+
+  /**
+   * Give every spilled temp a slot of its own and rewrite the code
+   * @param liveness of the code as it is before the rewrite
+   * @return indices of the blocks with spill code, increasing
+   */
+  std::vector<int> Rewrite(const std::vector<temp::Temp *> &spilled,
+                           live::LiveGraphFactory *liveness);
+
+private:
+  frame::Frame *frame_;
+  frame::RegManager *reg_manager_;
+  assem::InstrList *instr_list_;
+  fg::FlowGraph *flowgraph_;
+  live::LiveGraphFactory *liveness_ = nullptr;
+
+  /* frame offset of each spilled temp by id, 0 if it has no slot */
+  std::vector<int> offsets_;
+  /* def of each rematerialized temp by id, nullptr for the others */
+  std::vector<assem::Instr *> remat_;
+
+  /* what the block rewritten so far knows of a spilled temp */
+  struct Local {
+    /* holding its value, nullptr if the next use must load it */
+    temp::Temp *temp_ = nullptr;
+    /* the last store to its slot, which nothing has read yet */
+    fg::InstrPos store_;
+    bool pending_ = false;
+    /* in touched_ */
+    bool touched_ = false;
+  };
+  /* by id, only those of the temps in touched_ are not blank */
+  std::vector<Local> local_;
+  std::vector<temp::Temp *> touched_;
+  /* the temps of spill code by id */
+  std::vector<bool> made_;
+
+  [[nodiscard]] bool Made(temp::Temp *temp) const {
+    size_t id = temp->Int();
+    return id < made_.size() && made_[id];
+  }
+  temp::Temp *NewTemp();
+
+  [[nodiscard]] int Offset(temp::Temp *temp) const {
+    size_t id = temp->Int();
+    return id < offsets_.size() ? offsets_[id] : 0;
+  }
+  [[nodiscard]] assem::Instr *Remat(temp::Temp *temp) const {
+    size_t id = temp->Int();
+    return id < remat_.size() ? remat_[id] : nullptr;
+  }
+
+  /* find the temps to rematerialize, and slots for the others */
+  void Classify(const std::vector<temp::Temp *> &spilled);
+  /* the rematerialized def, writing temp instead */
+  static assem::Instr *Clone(const assem::Instr *def, temp::Temp *temp);
+  /* erase an instruction the code no longer needs from a block with
+   * others */
+  void Erase(fg::Block &block, fg::InstrPos pos);
+  /* the end of block b: drop the stores of temps dead after it */
+  void EndBlock(fg::Block &block, int b);
+};
+
+} // namespace ra
+
+#endif // TIGER_REGALLOC_SPILL_H_
@@ -0,0 +1,100 @@
+#ifndef TIGER_REGALLOC_WORKLIST_H_
+#define TIGER_REGALLOC_WORKLIST_H_
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace ra {
+
+/**
+ * Partition of the elements 0 ... n - 1 into one list per state, doubly
+ * linked through per-element arrays. Each element is in the list of its
+ * state, so asking for the state, or moving the element to the back of
+ * another list, takes constant time.
+ */
+template <typename State, size_t STATES> class WorkLists {
+public:
+  static constexpr int NONE = -1;
+
+  /* n elements, all in the list of `initial` in increasing order */
+  void Reset(int n, State initial);
+
+  [[nodiscard]] State Of(int i) const { return state_[i]; }
+  [[nodiscard]] bool Empty(State s) const { return Head(s).front_ == NONE; }
+  [[nodiscard]] int Front(State s) const { return Head(s).front_; }
+  [[nodiscard]] int Back(State s) const { return Head(s).back_; }
+  /* the element after i in its list, NONE at the end */
+  [[nodiscard]] int Next(int i) const { return link_[i].next_; }
+
+  /* unlink i and append it to the list of s */
+  void Move(int i, State s);
+
+private:
+  struct Link {
+    int prev_;
+    int next_;
+  };
+  struct List {
+    int front_ = NONE;
+    int back_ = NONE;
+  };
+
+  std::vector<Link> link_;
+  std::vector<State> state_;
+  std::array<List, STATES> lists_;
+
+  List &Head(State s) { return lists_[static_cast<size_t>(s)]; }
+  const List &Head(State s) const { return lists_[static_cast<size_t>(s)]; }
+  void Unlink(int i);
+  void Append(int i, State s);
+};
+
+template <typename State, size_t STATES>
+void WorkLists<State, STATES>::Reset(int n, State initial) {
+  lists_.fill(List());
+  link_.resize(n);
+  state_.assign(n, initial);
+  for (int i = 0; i < n; i++) {
+    link_[i] = {i - 1, i + 1 < n ? i + 1 : NONE};
+  }
+  if (n > 0)
+    Head(initial) = {0, n - 1};
+}
+
+template <typename State, size_t STATES>
+void WorkLists<State, STATES>::Move(int i, State s) {
+  Unlink(i);
+  Append(i, s);
+}
+
+template <typename State, size_t STATES>
+void WorkLists<State, STATES>::Unlink(int i) {
+  List &list = Head(state_[i]);
+  Link &link = link_[i];
+  if (link.prev_ == NONE)
+    list.front_ = link.next_;
+  else
+    link_[link.prev_].next_ = link.next_;
+  if (link.next_ == NONE)
+    list.back_ = link.prev_;
+  else
+    link_[link.next_].prev_ = link.prev_;
+}
+
+template <typename State, size_t STATES>
+void WorkLists<State, STATES>::Append(int i, State s) {
+  List &list = Head(s);
+  link_[i] = {list.back_, NONE};
+  if (list.back_ == NONE)
+    list.front_ = i;
+  else
+    link_[list.back_].next_ = i;
+  list.back_ = i;
+  state_[i] = s;
+}
+
+} // namespace ra
+
+#endif // TIGER_REGALLOC_WORKLIST_H_
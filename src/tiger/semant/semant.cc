@@ -20,7 +20,7 @@ type::Ty *SimpleVar::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
   if (entry && typeid(*entry) == typeid(env::VarEntry)) {
     return static_cast<env::VarEntry*>(entry)->ty_->ActualTy();
   } else {
-    errormsg->Error(pos_, "undefined variable %s", sym_->Name().c_str());
+    errormsg->Error(pos_, "undefined variable %s", sym_->Name().data());
     return type::IntTy::Instance();
   }
 }
@@ -33,13 +33,13 @@ type::Ty *FieldVar::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
     return type::IntTy::Instance();
   }
   type::FieldList *fieldList = static_cast<type::RecordTy*>(lvalueType)->fields_;
-  std::string symName = sym_->Name();
   for (const type::Field *field : fieldList->GetList()) {
-    if (!symName.compare(field->name_->Name())) {
+    /* symbols are interned, equal names are the same symbol */
+    if (field->name_ == sym_) {
       return field->ty_->ActualTy();
     }
   }
-  errormsg->Error(pos_, "field %s doesn't exist", sym_->Name().c_str());
+  errormsg->Error(pos_, "field %s doesn't exist", sym_->Name().data());
   return type::IntTy::Instance();
 }
 
@@ -83,7 +83,7 @@ type::Ty *CallExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
                               int labelcount, err::ErrorMsg *errormsg) const {
   env::EnvEntry *entry = venv->Look(func_);
   if (!entry || typeid(*entry) != typeid(env::FunEntry)) {
-    errormsg->Error(pos_, "undefined function %s", func_->Name().c_str());
+    errormsg->Error(pos_, "undefined function %s", func_->Name().data());
     return type::IntTy::Instance();
   }
   env::FunEntry *funcEntry = static_cast<env::FunEntry*>(entry);
@@ -95,7 +95,7 @@ type::Ty *CallExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
   while (formalItr != formalList.cend()) {
     /* actuals ends: too little args */
     if (actualItr == actualList.cend()) {
-      errormsg->Error(pos_, "too little params in function %s", func_->Name().c_str());
+      errormsg->Error(pos_, "too little params in function %s", func_->Name().data());
       return type::IntTy::Instance();
     }
     type::Ty *actualType = (*actualItr)->SemAnalyze(venv, tenv, labelcount, errormsg);
@@ -107,7 +107,7 @@ type::Ty *CallExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
   }
   /* actuals not end: too many args */
   if (actualItr != actualList.cend()) {
-    errormsg->Error(pos_, "too many params in function %s", func_->Name().c_str());
+    errormsg->Error(pos_, "too many params in function %s", func_->Name().data());
     return type::IntTy::Instance();
   }
 
@@ -142,7 +142,7 @@ type::Ty *RecordExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
                                 int labelcount, err::ErrorMsg *errormsg) const {
   type::Ty *rType = tenv->Look(typ_);
   if (!rType || typeid(*rType) != typeid(type::RecordTy)) {
-    errormsg->Error(pos_, "undefined type %s", typ_->Name().c_str());
+    errormsg->Error(pos_, "undefined type %s", typ_->Name().data());
     return type::IntTy::Instance();
   }
 
@@ -158,8 +158,8 @@ type::Ty *RecordExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
       return type::IntTy::Instance();
     }
     /* field name mismatch */
-    if ((*fieldItr)->name_->Name().compare((*eFieldItr)->name_->Name())) {
-      errormsg->Error(pos_, "undefined field %s", (*eFieldItr)->name_->Name().c_str());
+    if ((*fieldItr)->name_ != (*eFieldItr)->name_) {
+      errormsg->Error(pos_, "undefined field %s", (*eFieldItr)->name_->Name().data());
       return type::IntTy::Instance();
     }
     /* exp type mismatch */
@@ -297,14 +297,14 @@ type::Ty *ArrayExp::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv,
                                int labelcount, err::ErrorMsg *errormsg) const {
   type::Ty *arrType = tenv->Look(typ_);
   if (!arrType) {
-    errormsg->Error(pos_, "undefined type %s", typ_->Name().c_str());
+    errormsg->Error(pos_, "undefined type %s", typ_->Name().data());
     return type::IntTy::Instance();
   }
   while (typeid(*arrType) == typeid(type::NameTy)) {
     arrType = static_cast<type::NameTy*>(arrType)->ty_;
   }
   if (typeid(*arrType) != typeid(type::ArrayTy)) {
-    errormsg->Error(pos_, "%s is not an array", typ_->Name().c_str());
+    errormsg->Error(pos_, "%s is not an array", typ_->Name().data());
     return type::IntTy::Instance();
   }
   type::ArrayTy *arrayType = static_cast<type::ArrayTy*>(arrType);
@@ -374,7 +374,7 @@ void VarDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
   if (typ_) {
     type::Ty *varType = tenv->Look(typ_);
     if (!varType) {
-      errormsg->Error(pos_, "undefined type %s", typ_->Name().c_str());
+      errormsg->Error(pos_, "undefined type %s", typ_->Name().data());
       return;
     }
     if (!initType->IsSameType(varType)) {
@@ -431,7 +431,7 @@ void TypeDec::SemAnalyze(env::VEnvPtr venv, env::TEnvPtr tenv, int labelcount,
 type::Ty *NameTy::SemAnalyze(env::TEnvPtr tenv, err::ErrorMsg *errormsg) const {
   type::Ty *ty = tenv->Look(name_);
   if (!ty) {
-    errormsg->Error(pos_, "undefined type %s", name_->Name().c_str());
+    errormsg->Error(pos_, "undefined type %s", name_->Name().data());
     return type::IntTy::Instance();
   }
   return new type::NameTy(name_, tenv->Look(name_));
@@ -446,7 +446,7 @@ type::Ty *ArrayTy::SemAnalyze(env::TEnvPtr tenv,
                               err::ErrorMsg *errormsg) const {
   type::Ty *ty = tenv->Look(array_);
   if (!ty) {
-    errormsg->Error(pos_, "undefined array %s", array_->Name().c_str());
+    errormsg->Error(pos_, "undefined array %s", array_->Name().data());
     return type::IntTy::Instance();
   }
   return new type::ArrayTy(ty);
@@ -0,0 +1,311 @@
+#include "tiger/stats/stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> time_enabled{false};
+std::atomic<bool> mem_enabled{false};
+std::atomic<uint64_t> start_sequence{0};
+
+/* allocations made by the current thread, counted by operator new below */
+thread_local uint64_t alloc_count = 0;
+thread_local uint64_t alloc_bytes = 0;
+
+struct Entry {
+  std::string pass;
+  std::string function;
+  int round;
+  uint64_t order;
+  uint64_t calls;
+  uint64_t ns;
+  uint64_t allocs;
+  uint64_t bytes;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<Entry> entries;
+  std::map<std::tuple<std::string, std::string, int>, size_t> index;
+  std::chrono::steady_clock::time_point enable_time;
+};
+
+Registry &GetRegistry() {
+  static Registry *registry = new Registry();
+  return *registry;
+}
+
+void Record(const std::string &pass, const std::string &function, int round,
+            uint64_t order, uint64_t calls, uint64_t ns, uint64_t allocs,
+            uint64_t bytes) {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto key = std::make_tuple(pass, function, round);
+  auto it = registry.index.find(key);
+  if (it == registry.index.end()) {
+    it = registry.index.emplace(key, registry.entries.size()).first;
+    registry.entries.push_back({pass, function, round, order, 0, 0, 0, 0});
+  }
+  Entry &entry = registry.entries[it->second];
+  entry.order = std::min(entry.order, order);
+  entry.calls += calls;
+  entry.ns += ns;
+  entry.allocs += allocs;
+  entry.bytes += bytes;
+}
+
+void PrintJsonString(FILE *out, std::string_view str) {
+  fputc('"', out);
+  for (char c : str) {
+    if (c == '"' || c == '\\')
+      fputc('\\', out);
+    fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+void PrintJsonEntry(FILE *out, const Entry &entry, bool with_function) {
+  fprintf(out, "    {\"pass\": ");
+  PrintJsonString(out, entry.pass);
+  if (with_function) {
+    fprintf(out, ", \"function\": ");
+    PrintJsonString(out, entry.function);
+    fprintf(out, ", \"round\": %d", entry.round);
+  }
+  fprintf(out, ", \"calls\": %llu", (unsigned long long)entry.calls);
+  if (time_enabled)
+    fprintf(out, ", \"time_ns\": %llu", (unsigned long long)entry.ns);
+  if (mem_enabled)
+    fprintf(out, ", \"allocs\": %llu, \"bytes\": %llu",
+            (unsigned long long)entry.allocs, (unsigned long long)entry.bytes);
+  fprintf(out, "}");
+}
+
+void PrintRow(FILE *out, const char *name, const Entry &entry,
+              uint64_t wall_ns) {
+  fprintf(out, "  %-36s %8llu", name, (unsigned long long)entry.calls);
+  if (time_enabled)
+    fprintf(out, " %12.3f %6.1f%%", entry.ns / 1e6,
+            wall_ns ? 100.0 * entry.ns / wall_ns : 0.0);
+  if (mem_enabled)
+    fprintf(out, " %10llu %12llu", (unsigned long long)entry.allocs,
+            (unsigned long long)entry.bytes);
+  fprintf(out, "\n");
+}
+
+void PrintHeader(FILE *out, const char *title) {
+  fprintf(out, "  %-36s %8s", title, "Calls");
+  if (time_enabled)
+    fprintf(out, " %12s %7s", "Time (ms)", "Wall");
+  if (mem_enabled)
+    fprintf(out, " %10s %12s", "Allocs", "Bytes");
+  fprintf(out, "\n");
+}
+
+/* entries sorted by start, passes nest and record when they end */
+std::vector<Entry> SortedEntries(const Registry &registry) {
+  std::vector<Entry> entries = registry.entries;
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const Entry &a, const Entry &b) {
+                     return a.order < b.order;
+                   });
+  return entries;
+}
+
+/* sum over functions and rounds, in pipeline order */
+std::vector<Entry> SumPasses(const std::vector<Entry> &entries) {
+  std::vector<Entry> totals;
+  std::map<std::string, size_t> total_index;
+  for (const auto &entry : entries) {
+    auto it = total_index.find(entry.pass);
+    if (it == total_index.end()) {
+      it = total_index.emplace(entry.pass, totals.size()).first;
+      totals.push_back({entry.pass, "", 0, entry.order, 0, 0, 0, 0});
+    }
+    Entry &total = totals[it->second];
+    total.calls += entry.calls;
+    total.ns += entry.ns;
+    total.allocs += entry.allocs;
+    total.bytes += entry.bytes;
+  }
+  return totals;
+}
+
+} // namespace
+
+/**
+ * Count heap allocations for --mem-passes. Counting is a pair of increments
+ * of thread-local variables, cheap enough to stay on all the time.
+ */
+void *operator new(size_t size) {
+  alloc_count++;
+  alloc_bytes += size;
+  if (void *p = malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+/* std::pmr::new_delete_resource() allocates through the aligned forms */
+void *operator new(size_t size, std::align_val_t align) {
+  alloc_count++;
+  alloc_bytes += size;
+  size_t alignment = static_cast<size_t>(align);
+  // aligned_alloc wants a size which is a multiple of the alignment
+  size_t rounded = (size + alignment - 1) / alignment * alignment;
+  if (void *p = aligned_alloc(alignment, rounded ? rounded : alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p, std::align_val_t) noexcept { free(p); }
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept { free(p); }
+
+namespace stats {
+
+void Enable(bool time, bool mem) {
+  GetRegistry().enable_time = std::chrono::steady_clock::now();
+  time_enabled = time;
+  mem_enabled = mem;
+}
+
+bool Enabled() { return time_enabled || mem_enabled; }
+
+void Report(FILE *out, bool json) {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  uint64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() -
+                         registry.enable_time)
+                         .count();
+
+  std::vector<Entry> entries = SortedEntries(registry);
+  std::vector<Entry> totals = SumPasses(entries);
+  std::vector<std::string> functions;
+  std::map<std::string, bool> function_seen;
+  for (const auto &entry : entries) {
+    if (!entry.function.empty() && !function_seen[entry.function]) {
+      function_seen[entry.function] = true;
+      functions.push_back(entry.function);
+    }
+  }
+
+  if (json) {
+    fprintf(out, "{\n  \"wall_ns\": %llu,\n  \"passes\": [\n",
+            (unsigned long long)wall_ns);
+    for (size_t i = 0; i < totals.size(); i++) {
+      PrintJsonEntry(out, totals[i], false);
+      fprintf(out, i + 1 < totals.size() ? ",\n" : "\n");
+    }
+    fprintf(out, "  ],\n  \"functions\": [\n");
+    bool first = true;
+    for (const auto &function : functions) {
+      for (const auto &entry : entries) {
+        if (entry.function != function)
+          continue;
+        fprintf(out, first ? "" : ",\n");
+        PrintJsonEntry(out, entry, true);
+        first = false;
+      }
+    }
+    fprintf(out, "%s  ]\n}\n", first ? "" : "\n");
+    return;
+  }
+
+  fprintf(out, "===---------------------------------------------------===\n");
+  fprintf(out, "                    Pass statistics\n");
+  fprintf(out, "===---------------------------------------------------===\n");
+  if (time_enabled)
+    fprintf(out, "  Total wall time: %.3f ms\n\n", wall_ns / 1e6);
+  PrintHeader(out, "Pass");
+  for (const auto &total : totals)
+    PrintRow(out, total.pass.data(), total, wall_ns);
+
+  for (const auto &function : functions) {
+    fprintf(out, "\n");
+    PrintHeader(out, function.data());
+    for (const auto &entry : entries) {
+      if (entry.function != function)
+        continue;
+      std::string name = entry.pass;
+      if (entry.round > 0)
+        name += " (round " + std::to_string(entry.round) + ")";
+      PrintRow(out, name.data(), entry, wall_ns);
+    }
+  }
+}
+
+std::vector<PassTotal> Totals() {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<PassTotal> totals;
+  for (const auto &total : SumPasses(SortedEntries(registry)))
+    totals.push_back(
+        {total.pass, total.calls, total.ns, total.allocs, total.bytes});
+  return totals;
+}
+
+void Reset() {
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.entries.clear();
+  registry.index.clear();
+  registry.enable_time = std::chrono::steady_clock::now();
+}
+
+PassTimer::PassTimer(std::string_view pass, std::string_view function,
+                     int round, bool start)
+    : active_(Enabled()), round_(round) {
+  if (!active_)
+    return;
+  pass_ = pass;
+  function_ = function;
+  if (start)
+    Resume();
+}
+
+PassTimer::~PassTimer() {
+  if (!active_)
+    return;
+  Pause();
+  // never resumed
+  if (calls_ == 0)
+    return;
+  Record(pass_, function_, round_, order_, calls_,
+         std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed_)
+             .count(),
+         allocs_, bytes_);
+}
+
+void PassTimer::Pause() {
+  if (!active_ || !running_)
+    return;
+  running_ = false;
+  elapsed_ += Clock::now() - start_;
+  allocs_ += alloc_count - start_allocs_;
+  bytes_ += alloc_bytes - start_bytes_;
+}
+
+void PassTimer::Resume() {
+  if (!active_ || running_)
+    return;
+  running_ = true;
+  if (calls_++ == 0)
+    order_ = start_sequence++;
+  start_allocs_ = alloc_count;
+  start_bytes_ = alloc_bytes;
+  start_ = Clock::now();
+}
+
+} // namespace stats
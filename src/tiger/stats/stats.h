@@ -0,0 +1,97 @@
+#ifndef TIGER_STATS_STATS_H_
+#define TIGER_STATS_STATS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stats {
+
+/**
+ * Turn on pass statistics, see --time-passes and --mem-passes. Must be
+ * called before compiling, passes run before it are not recorded.
+ * @param time record execution time of passes
+ * @param mem record heap allocations made by passes
+ */
+void Enable(bool time, bool mem);
+
+[[nodiscard]] bool Enabled();
+
+/**
+ * Print every recorded pass, summed over functions and then function by
+ * function (and round by round for the register allocator)
+ * @param json print JSON instead of a table
+ */
+void Report(FILE *out, bool json);
+
+/**
+ * A pass summed over functions and rounds
+ */
+struct PassTotal {
+  std::string pass_;
+  uint64_t calls_;
+  uint64_t ns_;
+  uint64_t allocs_;
+  uint64_t bytes_;
+};
+
+/**
+ * Totals of the recorded passes, in pipeline order
+ */
+[[nodiscard]] std::vector<PassTotal> Totals();
+
+/**
+ * Forget the recorded passes, e.g. between the runs of a benchmark
+ */
+void Reset();
+
+/**
+ * Record the time and heap allocations of a pass while in scope. Costs two
+ * flag checks when statistics are off.
+ */
+class PassTimer {
+public:
+  /**
+   * Start timing right away
+   * @param pass name of the pass
+   * @param function function the pass works on, empty for the whole program
+   * @param round round of an iterative pass, 0 if it runs once
+   * @param start false to start paused, see Resume()
+   */
+  explicit PassTimer(std::string_view pass, std::string_view function = {},
+                     int round = 0, bool start = true);
+  PassTimer(const PassTimer &timer) = delete;
+  PassTimer &operator=(const PassTimer &timer) = delete;
+  ~PassTimer();
+
+  /**
+   * For passes running in many short pieces, e.g. inside a work-list loop:
+   * pause between the pieces, every resume counts as one more call
+   */
+  void Pause();
+  void Resume();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  bool active_;
+  bool running_ = false;
+  std::string pass_;
+  std::string function_;
+  int round_;
+  uint64_t calls_ = 0;
+  uint64_t order_ = 0; // when the pass first started, to report in order
+  Clock::duration elapsed_{};
+  Clock::time_point start_;
+  uint64_t allocs_ = 0;
+  uint64_t bytes_ = 0;
+  uint64_t start_allocs_ = 0;
+  uint64_t start_bytes_ = 0;
+};
+
+} // namespace stats
+
+#endif // TIGER_STATS_STATS_H_
@@ -1,30 +1,139 @@
 #include "tiger/symbol/symbol.h"
 
-namespace {
+#include <cstdio>
+#include <cstring>
+
+#include "tiger/context/context.h"
 
-constexpr unsigned int HASH_TABSIZE = 109;
-sym::Symbol *hashtable[HASH_TABSIZE];
+namespace {
 
-unsigned int Hash(std::string_view str) {
-  unsigned int h = 0;
-  for (const char *s = str.data(); *s; s++)
-    h = h * 65599 + *s;
+/* FNV-1a */
+uint32_t Hash(std::string_view str) {
+  uint32_t h = 2166136261u;
+  for (char c : str)
+    h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
   return h;
 }
 
+/* a label numbered by temp::LabelFactory::NewLabel(), named when printed */
+class UnnamedLabel : public sym::Symbol {
+public:
+  UnnamedLabel(sym::SymbolPool *pool, int scope, int number)
+      : Symbol(nullptr, 0, 0), pool_(pool), scope_(scope), number_(number) {}
+
+  sym::SymbolPool *pool_;
+  int scope_;
+  int number_;
+};
+
+constexpr size_t kInitialSlots = 256;
+
+sym::SymbolPool *CurrentPool() {
+  /* symbols made outside of any compilation, e.g. by static initializers */
+  static sym::SymbolPool *global_pool = new sym::SymbolPool();
+
+  ctx::CompilerContext *context = ctx::CompilerContext::Current();
+  return context ? context->GetSymbolPool() : global_pool;
+}
+
 } // namespace
 
 namespace sym {
 
 Symbol *Symbol::UniqueSymbol(std::string_view name) {
-  unsigned int index = Hash(name) % HASH_TABSIZE;
-  Symbol *syms = hashtable[index], *sym;
-  for (sym = syms; sym; sym = sym->next_)
-    if (sym->name_ == name)
-      return sym;
-  sym = new Symbol(static_cast<std::string>(name), syms);
-  hashtable[index] = sym;
+  return CurrentPool()->Intern(name);
+}
+
+Symbol *Symbol::AnonymousSymbol(int scope, int number) {
+  return CurrentPool()->NewAnonymous(scope, number);
+}
+
+std::string_view Symbol::NameAnonymous() const {
+  auto anonymous = static_cast<const UnnamedLabel *>(this);
+  SymbolPool *pool = anonymous->pool_;
+  std::lock_guard<std::mutex> lock(pool->mutex_);
+  // Another thread may have named it while this one waited for the lock
+  const char *name = name_.load(std::memory_order_relaxed);
+  if (!name) {
+    char buf[32];
+    int length = anonymous->scope_ >= 0
+                     ? snprintf(buf, sizeof(buf), "L%d_%d", anonymous->scope_,
+                                anonymous->number_)
+                     : snprintf(buf, sizeof(buf), "L%d", anonymous->number_);
+    length_ = length;
+    name = pool->CopyName(std::string_view(buf, length));
+    name_.store(name, std::memory_order_release);
+  }
+  return std::string_view(name, length_);
+}
+
+SymbolPool::SymbolPool() {
+  tables_.push_back(std::make_unique<Slots>(kInitialSlots));
+  slots_ = tables_.back().get();
+}
+
+Symbol *SymbolPool::Intern(std::string_view name) {
+  uint32_t hash = Hash(name);
+  if (Symbol *sym = Find(slots_.load(std::memory_order_acquire), name, hash))
+    return sym;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // The table may have grown or got the name since the lookup above
+  Slots *slots = slots_.load(std::memory_order_relaxed);
+  if (Symbol *sym = Find(slots, name, hash))
+    return sym;
+
+  if ((count_ + 1) * 4 > (slots->mask_ + 1) * 3) {
+    tables_.push_back(std::make_unique<Slots>((slots->mask_ + 1) * 2));
+    Slots *grown = tables_.back().get();
+    for (size_t i = 0; i <= slots->mask_; i++) {
+      if (Symbol *sym = slots->symbols_[i].load(std::memory_order_relaxed))
+        Insert(grown, sym);
+    }
+    slots_.store(grown, std::memory_order_release);
+    slots = grown;
+  }
+
+  const char *copy = CopyName(name);
+  void *memory = arena_.Allocate(sizeof(Symbol), alignof(Symbol));
+  auto sym = new (memory)
+      Symbol(copy, static_cast<uint32_t>(name.size()), hash);
+  Insert(slots, sym);
+  count_++;
   return sym;
 }
 
+Symbol *SymbolPool::NewAnonymous(int scope, int number) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  void *memory = arena_.Allocate(sizeof(UnnamedLabel), alignof(UnnamedLabel));
+  return new (memory) UnnamedLabel(this, scope, number);
+}
+
+Symbol *SymbolPool::Find(const Slots *slots, std::string_view name,
+                         uint32_t hash) {
+  for (size_t i = hash & slots->mask_;; i = (i + 1) & slots->mask_) {
+    Symbol *sym = slots->symbols_[i].load(std::memory_order_acquire);
+    if (!sym)
+      return nullptr;
+    if (sym->hash_ == hash && sym->length_ == name.size() &&
+        memcmp(sym->name_.load(std::memory_order_relaxed), name.data(),
+               name.size()) == 0)
+      return sym;
+  }
+}
+
+void SymbolPool::Insert(Slots *slots, Symbol *sym) {
+  size_t i = sym->hash_ & slots->mask_;
+  while (slots->symbols_[i].load(std::memory_order_relaxed))
+    i = (i + 1) & slots->mask_;
+  slots->symbols_[i].store(sym, std::memory_order_release);
+}
+
+const char *SymbolPool::CopyName(std::string_view name) {
+  auto copy = static_cast<char *>(arena_.Allocate(name.size() + 1, 1));
+  memcpy(copy, name.data(), name.size());
+  copy[name.size()] = '\0';
+  return copy;
+}
+
 } // namespace sym
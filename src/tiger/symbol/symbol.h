@@ -1,8 +1,14 @@
 #ifndef TIGER_SYMBOL_SYMBOL_H_
 #define TIGER_SYMBOL_SYMBOL_H_
 
-#include <string>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
 
+#include "tiger/util/arena.h"
 #include "tiger/util/table.h"
 
 /**
@@ -17,41 +23,94 @@ class Ty;
 
 namespace sym {
 class Symbol {
-  template <typename ValueType> friend class Table;
+  friend class SymbolPool;
 
 public:
+  /**
+   * Intern a name in the symbol pool of the current compiler context
+   */
   static Symbol *UniqueSymbol(std::string_view);
-  [[nodiscard]] std::string Name() const { return name_; }
+  /**
+   * Make a label of the current pool named `L<scope>_<number>`, or
+   * `L<number>` with a negative scope. It is not interned, and its name is
+   * only written out the first time it is asked for.
+   */
+  static Symbol *AnonymousSymbol(int scope, int number);
+
+  /* the name, NUL-terminated so that data() can be printed with %s */
+  [[nodiscard]] std::string_view Name() const {
+    const char *name = name_.load(std::memory_order_acquire);
+    return name ? std::string_view(name, length_) : NameAnonymous();
+  }
+  [[nodiscard]] uint32_t Hash() const { return hash_; }
+
+protected:
+  Symbol(const char *name, uint32_t length, uint32_t hash)
+      : name_(name), length_(length), hash_(hash) {}
 
 private:
-  Symbol(std::string name, Symbol *next)
-      : name_(std::move(name)), next_(next) {}
+  /* only null for an anonymous label, until NameAnonymous() names it */
+  mutable std::atomic<const char *> name_;
+  mutable uint32_t length_;
+  uint32_t hash_;
 
-  std::string name_;
-  Symbol *next_;
+  std::string_view NameAnonymous() const;
 };
 
-template <typename ValueType>
-class Table : public tab::Table<Symbol, ValueType> {
+/**
+ * Interned symbols of one compilation, names are unique inside a pool.
+ * Symbols of different pools must never be mixed.
+ *
+ * The table is open-addressed and grows; lookups of names already in it
+ * take no lock, only adding a symbol does. Symbols and names live in an
+ * arena of the pool, so a name never moves once handed out.
+ */
+class SymbolPool {
+  friend class Symbol;
+
 public:
-  Table() : tab::Table<Symbol, ValueType>() {}
-  void BeginScope();
-  void EndScope();
+  SymbolPool();
+  SymbolPool(const SymbolPool &pool) = delete;
+  SymbolPool &operator=(const SymbolPool &pool) = delete;
+
+  Symbol *Intern(std::string_view name);
+  Symbol *NewAnonymous(int scope, int number);
 
 private:
-  Symbol marksym_ = {"<mark>", nullptr};
-};
+  /* a power of two of slots, probed linearly from the hash */
+  struct Slots {
+    size_t mask_;
+    std::unique_ptr<std::atomic<Symbol *>[]> symbols_;
 
-template <typename ValueType> void Table<ValueType>::BeginScope() {
-  this->Enter(&marksym_, nullptr);
-}
+    explicit Slots(size_t size)
+        : mask_(size - 1), symbols_(new std::atomic<Symbol *>[size]()) {}
+  };
 
-template <typename ValueType> void Table<ValueType>::EndScope() {
-  Symbol *s;
-  do
-    s = this->Pop();
-  while (s != &marksym_);
-}
+  /* the table lookups start from; replaced by one twice the size when
+   * three quarters full. Old ones are kept in tables_, since a lookup
+   * without the lock may still be probing them. */
+  std::atomic<Slots *> slots_;
+  std::vector<std::unique_ptr<Slots>> tables_;
+  size_t count_ = 0;
+  util::Arena arena_;
+  /* labels are interned concurrently by the parallel backend */
+  std::mutex mutex_;
+
+  static Symbol *Find(const Slots *slots, std::string_view name,
+                      uint32_t hash);
+  void Insert(Slots *slots, Symbol *sym);
+  /* a NUL-terminated copy of a name in the arena */
+  const char *CopyName(std::string_view name);
+};
+
+/**
+ * Scoped table keyed by symbols, e.g. the variable and type environments
+ */
+template <typename ValueType>
+class Table : public tab::Table<Symbol, ValueType> {
+public:
+  Table() : tab::Table<Symbol, ValueType>() {}
+};
 
 } // namespace sym
 
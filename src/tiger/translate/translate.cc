@@ -1,5 +1,7 @@
 #include "tiger/translate/translate.h"
 
+#include <vector>
+
 #include <tiger/absyn/absyn.h>
 
 #include "tiger/env/env.h"
@@ -8,9 +10,6 @@
 #include "tiger/frame/temp.h"
 #include "tiger/frame/frame.h"
 
-extern frame::Frags *frags;
-extern frame::RegManager *reg_manager;
-
 namespace tr {
 
 Access *Access::AllocLocal(Level *level, bool escape) {
@@ -18,7 +17,8 @@ Access *Access::AllocLocal(Level *level, bool escape) {
 }
 
 Level *Level::NewLevel(Level *parent, temp::Label *name, std::list<bool> formals) {
-  frame::Frame *newFrame = frame::NewFrame(name, formals);
+  frame::Frame *newFrame =
+    frame::NewFrame(parent->frame_->Context(), name, formals);
   return new Level(newFrame, parent);
 }
 
@@ -118,9 +118,13 @@ public:
 void ProgTr::Translate() {
   FillBaseTEnv();
   FillBaseVEnv();
+  util::ProcObject::Scope arena_scope(main_arena_.get());
+  temp::TempFactory::Scope temp_scope(main_level_->frame_->Temps());
   tr::ExpAndTy *ret = absyn_tree_->Translate(
     venv_.get(), tenv_.get(), main_level_.get(), nullptr, errormsg_.get());
-  frags->PushBack(new frame::ProcFrag(ret->exp_->UnNx(), main_level_.get()->frame_));
+  context_->GetFrags()->PushBack(
+    new frame::ProcFrag(ret->exp_->UnNx(), main_level_.get()->frame_,
+                        std::move(main_arena_)));
 }
 
 } // namespace tr
@@ -141,7 +145,8 @@ tr::ExpAndTy *SimpleVar::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                    tr::Level *level, temp::Label *label,
                                    err::ErrorMsg *errormsg) const {
   env::VarEntry *entry = static_cast<env::VarEntry*>(venv->Look(sym_));
-  tree::Exp *framePtr = new tree::TempExp(reg_manager->FramePointer());
+  tree::Exp *framePtr =
+    new tree::TempExp(level->Context()->GetRegManager()->FramePointer());
   tr::Level *curLevel = level, *targetLevel = entry->access_->level_;
   while (curLevel != targetLevel) {
     /* walk up through static link */
@@ -165,7 +170,7 @@ tr::ExpAndTy *FieldVar::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   auto fieldEnd = ty->fields_->GetList().cend();
   uint32_t byteOffset = 0;
   while (fieldItr != fieldEnd) {
-    if ((*fieldItr)->name_->Name() == sym_->Name()) {
+    if ((*fieldItr)->name_ == sym_) {
       tree::Exp *resExp = new tree::MemExp(new tree::BinopExp(
         tree::PLUS_OP, varRes->exp_->UnEx(), new tree::ConstExp(byteOffset)));
       return new tr::ExpAndTy(new tr::ExExp(resExp), (*fieldItr)->ty_);
@@ -218,7 +223,7 @@ tr::ExpAndTy *StringExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                    tr::Level *level, temp::Label *label,
                                    err::ErrorMsg *errormsg) const {
   temp::Label *strLabel = temp::LabelFactory::NewLabel();
-  frags->PushBack(new frame::StringFrag(strLabel, str_));
+  level->Context()->GetFrags()->PushBack(new frame::StringFrag(strLabel, std::string(str_)));
   return new tr::ExpAndTy(
     new tr::ExExp(new tree::NameExp(strLabel)), type::StringTy::Instance()
   );
@@ -239,7 +244,8 @@ tr::ExpAndTy *CallExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 
   if (funcEntry->level_->parent_ != nullptr) {
     /* self defined function: find static link */
-    tree::Exp *staticLink = new tree::TempExp(reg_manager->FramePointer());
+    tree::Exp *staticLink =
+      new tree::TempExp(level->Context()->GetRegManager()->FramePointer());
     tr::Level *funcParentLevel = level;
     while (funcParentLevel != nullptr && funcParentLevel != funcEntry->level_->parent_) {
       staticLink = new tree::MemExp(
@@ -491,6 +497,7 @@ tr::ExpAndTy *ForExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   tenv->BeginScope();
 
   /* loop variable can't escape, and is readonly */
+  frame::RegManager *rm = level->Context()->GetRegManager();
   tr::Access *loopVar = tr::Access::AllocLocal(level, false);
   venv->Enter(var_, new env::VarEntry(loopVar, type::IntTy::Instance(), true));
 
@@ -500,17 +507,17 @@ tr::ExpAndTy *ForExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   tr::ExpAndTy *bodyRes = body_->Translate(venv, tenv, level, doneLabel, errormsg);
 
   tree::Stm *lessOrEqualTest = new tree::CjumpStm(tree::LE_OP, 
-    AccessToExp(loopVar, reg_manager), highRes->exp_->UnEx(), bodyLabel, doneLabel);
+    AccessToExp(loopVar, rm), highRes->exp_->UnEx(), bodyLabel, doneLabel);
   tree::Stm *lessThanTest = new tree::CjumpStm(tree::LT_OP, 
-    AccessToExp(loopVar, reg_manager), highRes->exp_->UnEx(), incrLabel, doneLabel);
+    AccessToExp(loopVar, rm), highRes->exp_->UnEx(), incrLabel, doneLabel);
 
   tree::Stm *selfIncr = new tree::MoveStm(
-    AccessToExp(loopVar, reg_manager),
-    new tree::BinopExp(tree::PLUS_OP, AccessToExp(loopVar, reg_manager), new tree::ConstExp(1)));
+    AccessToExp(loopVar, rm),
+    new tree::BinopExp(tree::PLUS_OP, AccessToExp(loopVar, rm), new tree::ConstExp(1)));
 
   /* prevent from overflow */
   tree::Stm *stmSeq = 
-    new tree::SeqStm(new tree::MoveStm(AccessToExp(loopVar, reg_manager), lowRes->exp_->UnEx()),
+    new tree::SeqStm(new tree::MoveStm(AccessToExp(loopVar, rm), lowRes->exp_->UnEx()),
     new tree::SeqStm(lessOrEqualTest,
     new tree::SeqStm(new tree::LabelStm(bodyLabel),
     new tree::SeqStm(bodyRes->exp_->UnNx(),
@@ -609,8 +616,12 @@ tr::ExpAndTy *VoidExp::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 tr::Exp *FunctionDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
                                 tr::Level *level, temp::Label *label,
                                 err::ErrorMsg *errormsg) const {
+  /* every function gets an arena for its IR, the frame has some already */
+  std::vector<std::unique_ptr<util::Arena>> arenas;
   /* add function dec into venv, left body */
   for (auto funDec : functions_->GetList()) {
+    arenas.push_back(std::make_unique<util::Arena>());
+    util::ProcObject::Scope arena_scope(arenas.back().get());
     temp::Label *funcName = temp::LabelFactory::NamedLabel(funDec->name_->Name());
     /* first arg is always escape: static link */
     auto escapeList = std::list<bool>({ true });
@@ -629,9 +640,12 @@ tr::Exp *FunctionDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
     venv->Enter(funDec->name_, funEntry);
   }
   /* translate the body */
+  auto arena = arenas.begin();
   for (auto funDec : functions_->GetList()) {
+    util::ProcObject::Scope arena_scope(arena->get());
     auto formalList = funDec->params_->MakeFieldList(tenv, errormsg);
     auto funEntry = static_cast<env::FunEntry*>(venv->Look(funDec->name_));
+    temp::TempFactory::Scope temp_scope(funEntry->level_->frame_->Temps());
     /* first access is static-link */
     auto accessItr = ++funEntry->level_->frame_->Formals().begin();
     // assert(funEntry->level_->frame_->Formals().size() == formalList->GetList().size());
@@ -649,10 +663,13 @@ tr::Exp *FunctionDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
 
     /* Epilogue_7 */
     tree::Stm *bodyStm = new tree::MoveStm(
-      new tree::TempExp(reg_manager->ReturnValue()), bodyRes->exp_->UnEx()); 
+      new tree::TempExp(level->Context()->GetRegManager()->ReturnValue()),
+      bodyRes->exp_->UnEx());
     /* after procEntryExit1, Prologue_4 -> Epilogue_8 have done */
     bodyStm = frame::ProcEntryExit1(funEntry->level_->frame_, bodyStm);
-    frags->PushBack(new frame::ProcFrag(bodyStm, funEntry->level_->frame_));
+    level->Context()->GetFrags()->PushBack(
+      new frame::ProcFrag(bodyStm, funEntry->level_->frame_,
+                          std::move(*arena++)));
   }
 
   return new tr::ExExp(new tree::ConstExp(114514));
@@ -669,7 +686,8 @@ tr::Exp *VarDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
   venv->Enter(var_, new env::VarEntry(valAccess, realTy));
   /* move value from init to access */
   return new tr::NxExp(new tree::MoveStm(
-    AccessToExp(valAccess, reg_manager), initRes->exp_->UnEx()));
+    AccessToExp(valAccess, level->Context()->GetRegManager()),
+    initRes->exp_->UnEx()));
 }
 
 tr::Exp *TypeDec::Translate(env::VEnvPtr venv, env::TEnvPtr tenv,
@@ -5,6 +5,7 @@
 #include <memory>
 
 #include "tiger/absyn/absyn.h"
+#include "tiger/context/context.h"
 #include "tiger/env/env.h"
 #include "tiger/errormsg/errormsg.h"
 #include "tiger/frame/frame.h"
@@ -32,15 +33,19 @@ public:
   Level *parent_;
 
   Level(frame::Frame *f, Level *p): frame_(f), parent_(p) {}
+  ctx::CompilerContext *Context() const { return frame_->Context(); }
   static Level* NewLevel(Level *parent, temp::Label *name, std::list<bool> formals);
 };
 
 class ProgTr {
 public:
-  ProgTr(std::unique_ptr<absyn::AbsynTree> absyn_tree, std::unique_ptr<err::ErrorMsg> errormsg)
-    : absyn_tree_(std::move(absyn_tree)), errormsg_(std::move(errormsg)) {
+  ProgTr(ctx::CompilerContext *context, std::unique_ptr<absyn::AbsynTree> absyn_tree,
+         std::unique_ptr<err::ErrorMsg> errormsg)
+    : context_(context), absyn_tree_(std::move(absyn_tree)), errormsg_(std::move(errormsg)),
+      main_arena_(std::make_unique<util::Arena>()) {
+      util::ProcObject::Scope arena_scope(main_arena_.get());
       main_level_ = std::make_unique<Level>(
-        frame::NewFrame(temp::LabelFactory::NamedLabel("tigermain"), {}), nullptr);
+        frame::NewFrame(context, temp::LabelFactory::NamedLabel("tigermain"), {}), nullptr);
       tenv_ = std::make_unique<env::TEnv>();
       venv_ = std::make_unique<env::VEnv>();
     }
@@ -60,8 +65,11 @@ public:
 
 
 private:
+  ctx::CompilerContext *context_;
   std::unique_ptr<absyn::AbsynTree> absyn_tree_;
   std::unique_ptr<err::ErrorMsg> errormsg_;
+  /* IR of tigermain, handed over to its fragment */
+  std::unique_ptr<util::Arena> main_arena_;
   std::unique_ptr<Level> main_level_;
   std::unique_ptr<env::TEnv> tenv_;
   std::unique_ptr<env::VEnv> venv_;
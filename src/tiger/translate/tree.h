@@ -5,9 +5,11 @@
 #include <cassert>
 #include <cstdio>
 #include <list>
+#include <memory_resource>
 #include <string>
 
 #include "tiger/frame/temp.h"
+#include "tiger/util/arena.h"
 
 // Forward Declarations
 namespace canon {
@@ -66,13 +68,14 @@ enum RelOp {
  * Statements
  */
 
-class Stm {
+class Stm : public util::ProcObject {
 public:
   virtual ~Stm() = default;
 
   virtual void Print(FILE *out, int d) const = 0;
   virtual Stm *Canon() = 0;
-  virtual void Munch(assem::InstrList &instr_list, std::string_view fs) = 0;
+  virtual void Munch(assem::InstrList &instr_list, temp::Label *fs,
+                     frame::RegManager *rm) = 0;
   // Used for Canon
   bool IsNop();
   static Stm *Seq(Stm *x, Stm *y);
@@ -88,7 +91,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
-  void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Munch(assem::InstrList &instr_list, temp::Label *fs,
+             frame::RegManager *rm) override;
 };
 
 class LabelStm : public Stm {
@@ -100,7 +104,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
-  void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Munch(assem::InstrList &instr_list, temp::Label *fs,
+             frame::RegManager *rm) override;
 };
 
 class JumpStm : public Stm {
@@ -115,7 +120,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
-  void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Munch(assem::InstrList &instr_list, temp::Label *fs,
+             frame::RegManager *rm) override;
 };
 
 class CjumpStm : public Stm {
@@ -132,7 +138,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
-  void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Munch(assem::InstrList &instr_list, temp::Label *fs,
+             frame::RegManager *rm) override;
 };
 
 class MoveStm : public Stm {
@@ -144,7 +151,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
-  void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Munch(assem::InstrList &instr_list, temp::Label *fs,
+             frame::RegManager *rm) override;
 };
 
 class ExpStm : public Stm {
@@ -156,20 +164,22 @@ public:
 
   void Print(FILE *out, int d) const override;
   Stm *Canon() override;
-  void Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  void Munch(assem::InstrList &instr_list, temp::Label *fs,
+             frame::RegManager *rm) override;
 };
 
 /**
  *Expressions
  */
 
-class Exp {
+class Exp : public util::ProcObject {
 public:
   virtual ~Exp() = default;
 
   virtual void Print(FILE *out, int d) const = 0;
   virtual canon::StmAndExp Canon() = 0;
-  virtual temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) = 0;
+  virtual temp::Temp *Munch(assem::InstrList &instr_list, temp::Label *fs,
+                            frame::RegManager *rm) = 0;
 };
 
 class BinopExp : public Exp {
@@ -183,7 +193,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
-  temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  temp::Temp *Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) override;
 };
 
 class MemExp : public Exp {
@@ -195,7 +206,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
-  temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  temp::Temp *Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) override;
 };
 
 class TempExp : public Exp {
@@ -207,7 +219,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
-  temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  temp::Temp *Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) override;
 };
 
 class EseqExp : public Exp {
@@ -220,7 +233,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
-  temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  temp::Temp *Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) override;
 };
 
 class NameExp : public Exp {
@@ -232,7 +246,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
-  temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  temp::Temp *Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) override;
 };
 
 class ConstExp : public Exp {
@@ -244,7 +259,8 @@ public:
 
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
-  temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  temp::Temp *Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) override;
 };
 
 class CallExp : public Exp {
@@ -257,36 +273,38 @@ public:
 
   void Print(FILE *out, int d) const override;
   canon::StmAndExp Canon() override;
-  temp::Temp *Munch(assem::InstrList &instr_list, std::string_view fs) override;
+  temp::Temp *Munch(assem::InstrList &instr_list, temp::Label *fs,
+                    frame::RegManager *rm) override;
 };
 
-class ExpList {
+class ExpList : public util::ProcObject {
 public:
   ExpList() = default;
-  ExpList(std::initializer_list<Exp *> list) : exp_list_(list) {}
+  ExpList(std::initializer_list<Exp *> list) : exp_list_(list, Resource()) {}
 
   void Append(Exp *exp) { exp_list_.push_back(exp); }
   void Insert(Exp *exp) { exp_list_.push_front(exp); }
-  std::list<Exp *> &GetNonConstList() { return exp_list_; }
-  const std::list<Exp *> &GetList() { return exp_list_; }
-  temp::TempList *MunchArgs(assem::InstrList &instr_list, std::string_view fs);
+  std::pmr::list<Exp *> &GetNonConstList() { return exp_list_; }
+  const std::pmr::list<Exp *> &GetList() { return exp_list_; }
+  temp::TempList *MunchArgs(assem::InstrList &instr_list, temp::Label *fs,
+                            frame::RegManager *rm);
 
 private:
-  std::list<Exp *> exp_list_;
+  std::pmr::list<Exp *> exp_list_{Resource()};
 };
 
-class StmList {
+class StmList : public util::ProcObject {
   friend class canon::Canon;
 
 public:
   StmList() = default;
 
-  const std::list<Stm *> &GetList() { return stm_list_; }
+  const std::pmr::list<Stm *> &GetList() { return stm_list_; }
   void Linear(Stm *stm);
   void Print(FILE *out) const;
 
 private:
-  std::list<Stm *> stm_list_;
+  std::pmr::list<Stm *> stm_list_{Resource()};
 };
 
 RelOp NotRel(RelOp);  // a op b == not(a NotRel(op) b)
@@ -0,0 +1,136 @@
+#ifndef TIGER_UTIL_ARENA_H_
+#define TIGER_UTIL_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace util {
+
+/**
+ * A bump allocator. Memory is carved out of large chunks and is only given
+ * back when the arena is released, all at once; nothing allocated in it
+ * has its destructor run.
+ */
+class Arena : public std::pmr::memory_resource {
+public:
+  explicit Arena(size_t chunk_size = 64 * 1024) : chunk_size_(chunk_size) {}
+  Arena(const Arena &arena) = delete;
+  Arena &operator=(const Arena &arena) = delete;
+  ~Arena() override { Release(); }
+
+  void *Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    auto pos = (reinterpret_cast<uintptr_t>(pos_) + align - 1) & ~(align - 1);
+    if (pos_ == nullptr || pos + size > reinterpret_cast<uintptr_t>(end_))
+      pos = reinterpret_cast<uintptr_t>(NewChunk(size + align));
+    pos = (pos + align - 1) & ~(align - 1);
+    pos_ = reinterpret_cast<char *>(pos + size);
+    return reinterpret_cast<void *>(pos);
+  }
+
+  /* free every chunk, the arena can be reused afterwards */
+  void Release() {
+    for (auto chunk : chunks_)
+      ::operator delete(chunk);
+    chunks_.clear();
+    pos_ = end_ = nullptr;
+    used_ = 0;
+  }
+
+  /* bytes taken from the system */
+  [[nodiscard]] size_t Used() const { return used_; }
+
+private:
+  size_t chunk_size_;
+  std::vector<void *> chunks_;
+  char *pos_ = nullptr, *end_ = nullptr;
+  size_t used_ = 0;
+
+  char *NewChunk(size_t min_size) {
+    size_t size = min_size > chunk_size_ ? min_size : chunk_size_;
+    auto chunk = static_cast<char *>(::operator new(size));
+    chunks_.push_back(chunk);
+    used_ += size;
+    pos_ = chunk;
+    end_ = chunk + size;
+    return chunk;
+  }
+
+  void *do_allocate(size_t bytes, size_t align) override {
+    return Allocate(bytes, align);
+  }
+  void do_deallocate(void *, size_t, size_t) override {}
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+/**
+ * The phases whose objects live in arenas: the abstract syntax tree, and
+ * the tree IR, instructions and graphs of one procedure
+ */
+enum class ArenaKind { ABSYN, PROC };
+
+/**
+ * Base of the classes allocated in an arena. `new` takes memory from the
+ * arena of the same kind made current on the calling thread by a Scope, or
+ * from the heap if there is none; `delete` of an object in an arena only
+ * runs its destructor. Containers held by such objects should allocate
+ * from Resource() so that they are released with the arena too.
+ */
+template <ArenaKind kind> class ArenaObject {
+public:
+  static void *operator new(size_t size) {
+    Arena *arena = current_;
+    void *block = arena ? arena->Allocate(size + kHeader, kHeader)
+                        : std::pmr::new_delete_resource()->allocate(
+                              size + kHeader);
+    *static_cast<Arena **>(block) = arena;
+    return static_cast<char *>(block) + kHeader;
+  }
+
+  /* the size is that of the object allocated, as objects are deleted
+   * through virtual destructors */
+  static void operator delete(void *p, size_t size) {
+    if (p == nullptr)
+      return;
+    void *block = static_cast<char *>(p) - kHeader;
+    if (*static_cast<Arena **>(block) == nullptr)
+      std::pmr::new_delete_resource()->deallocate(block, size + kHeader);
+  }
+
+  /**
+   * Make an arena current on this thread until the scope ends, nullptr
+   * makes the heap current
+   */
+  class Scope {
+  public:
+    explicit Scope(Arena *arena) : saved_(current_) { current_ = arena; }
+    Scope(const Scope &scope) = delete;
+    Scope &operator=(const Scope &scope) = delete;
+    ~Scope() { current_ = saved_; }
+
+  private:
+    Arena *saved_;
+  };
+
+  static Arena *Current() { return current_; }
+  static std::pmr::memory_resource *Resource() {
+    return current_ ? current_ : std::pmr::new_delete_resource();
+  }
+
+private:
+  /* the arena an object came from is kept in front of it */
+  static constexpr size_t kHeader = sizeof(Arena *);
+  static inline thread_local Arena *current_ = nullptr;
+};
+
+using AbsynObject = ArenaObject<ArenaKind::ABSYN>;
+using ProcObject = ArenaObject<ArenaKind::PROC>;
+
+} // namespace util
+
+#endif // TIGER_UTIL_ARENA_H_
@@ -0,0 +1,101 @@
+#ifndef TIGER_UTIL_BIT_VECTOR_H_
+#define TIGER_UTIL_BIT_VECTOR_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace util {
+
+/**
+ * Set of the integers below its size, one bit each. Set operations go a
+ * whole word at a time, in loops plain enough for the compiler to
+ * vectorize. Both operands of a set operation have the same size.
+ */
+class BitVector {
+public:
+  BitVector() = default;
+  explicit BitVector(size_t size) : words_(Words(size), 0), size_(size) {}
+
+  [[nodiscard]] size_t Size() const { return size_; }
+  /* bits beyond the old size are clear */
+  void Resize(size_t size) {
+    words_.resize(Words(size), 0);
+    if (size < size_ && size % 64)
+      words_.back() &= (uint64_t(1) << (size % 64)) - 1;
+    size_ = size;
+  }
+
+  [[nodiscard]] bool Test(size_t i) const {
+    assert(i < size_);
+    return words_[i / 64] >> (i % 64) & 1;
+  }
+  void Set(size_t i) {
+    assert(i < size_);
+    words_[i / 64] |= uint64_t(1) << (i % 64);
+  }
+  void Reset(size_t i) {
+    assert(i < size_);
+    words_[i / 64] &= ~(uint64_t(1) << (i % 64));
+  }
+  void Clear() {
+    for (auto &word : words_)
+      word = 0;
+  }
+
+  void UnionWith(const BitVector &other) {
+    assert(size_ == other.size_);
+    for (size_t w = 0; w < words_.size(); w++)
+      words_[w] |= other.words_[w];
+  }
+  void DiffWith(const BitVector &other) {
+    assert(size_ == other.size_);
+    for (size_t w = 0; w < words_.size(); w++)
+      words_[w] &= ~other.words_[w];
+  }
+
+  /**
+   * Become a | (b & ~c), the dataflow equation of liveness
+   * @return whether a bit changed
+   */
+  bool AssignUnionDiff(const BitVector &a, const BitVector &b,
+                       const BitVector &c) {
+    assert(size_ == a.size_ && size_ == b.size_ && size_ == c.size_);
+    uint64_t changed = 0;
+    for (size_t w = 0; w < words_.size(); w++) {
+      uint64_t word = a.words_[w] | (b.words_[w] & ~c.words_[w]);
+      changed |= word ^ words_[w];
+      words_[w] = word;
+    }
+    return changed != 0;
+  }
+
+  /* call f on the members in increasing order */
+  template <typename F> void ForEach(F f) const { ForEachFrom(0, f); }
+  /* the same for the members no less than first */
+  template <typename F> void ForEachFrom(size_t first, F f) const {
+    for (size_t w = first / 64; w < words_.size(); w++) {
+      uint64_t word = words_[w];
+      if (w == first / 64)
+        word &= ~uint64_t(0) << (first % 64);
+      for (; word; word &= word - 1)
+        f(w * 64 + __builtin_ctzll(word));
+    }
+  }
+
+  bool operator==(const BitVector &other) const {
+    return size_ == other.size_ && words_ == other.words_;
+  }
+  bool operator!=(const BitVector &other) const { return !(*this == other); }
+
+private:
+  std::vector<uint64_t> words_;
+  size_t size_ = 0;
+
+  static size_t Words(size_t size) { return (size + 63) / 64; }
+};
+
+} // namespace util
+
+#endif // TIGER_UTIL_BIT_VECTOR_H_
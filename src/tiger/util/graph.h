@@ -1,6 +1,10 @@
 #ifndef TIGER_UTIL_GRAPH_H_
 #define TIGER_UTIL_GRAPH_H_
 
+#include <list>
+#include <memory_resource>
+
+#include "tiger/util/arena.h"
 #include "tiger/util/table.h"
 
 namespace graph {
@@ -8,7 +12,7 @@ namespace graph {
 template <typename T> class Node;
 template <typename T> class NodeList;
 
-template <typename T> class Graph {
+template <typename T> class Graph : public util::ProcObject {
 public:
   // Make a new graph
   Graph() : nodecount_(0), my_nodes_(new NodeList<T>()) {}
@@ -36,7 +40,7 @@ private:
   NodeList<T> *my_nodes_;
 };
 
-template <typename T> class Node {
+template <typename T> class Node : public util::ProcObject {
   template <typename NodeType> friend class Graph;
 
 public:
@@ -87,7 +91,7 @@ private:
         info_(nullptr) {}
 };
 
-template <typename T> class NodeList {
+template <typename T> class NodeList : public util::ProcObject {
   friend class Graph<T>;
   friend class Node<T>;
 
@@ -122,12 +126,12 @@ public:
     return res;
   }
 
-  [[nodiscard]] const std::list<Node<T> *> &GetList() const {
+  [[nodiscard]] const std::pmr::list<Node<T> *> &GetList() const {
     return node_list_;
   }
 
 private:
-  std::list<Node<T> *> node_list_{};
+  std::pmr::list<Node<T> *> node_list_{Resource()};
 };
 
 // Generic creation of Node<tree>
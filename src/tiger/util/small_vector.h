@@ -0,0 +1,142 @@
+#ifndef TIGER_UTIL_SMALL_VECTOR_H_
+#define TIGER_UTIL_SMALL_VECTOR_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+
+/**
+ * Vector of trivially copyable elements keeping the first N of them inline.
+ * Larger buffers come from a memory resource, e.g. the arena of the
+ * procedure, and are never shrunk.
+ */
+template <typename T, uint32_t N> class SmallVector {
+  static_assert(std::is_trivially_copyable_v<T>, "elements are memcpy'd");
+
+public:
+  explicit SmallVector(
+      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : data_(inline_), resource_(resource) {}
+  SmallVector(const SmallVector &other) : SmallVector(other.resource_) {
+    *this = other;
+  }
+  SmallVector(SmallVector &&other) noexcept : SmallVector(other.resource_) {
+    *this = std::move(other);
+  }
+  SmallVector &operator=(const SmallVector &other);
+  SmallVector &operator=(SmallVector &&other) noexcept;
+  ~SmallVector() { Release(); }
+
+  T *begin() { return data_; }
+  T *end() { return data_ + size_; }
+  const T *begin() const { return data_; }
+  const T *end() const { return data_ + size_; }
+  T *Data() { return data_; }
+  const T *Data() const { return data_; }
+  T &operator[](uint32_t i) { return data_[i]; }
+  const T &operator[](uint32_t i) const { return data_[i]; }
+
+  [[nodiscard]] uint32_t Size() const { return size_; }
+  [[nodiscard]] bool Empty() const { return size_ == 0; }
+  [[nodiscard]] uint32_t Capacity() const { return capacity_; }
+
+  void Clear() { size_ = 0; }
+  void Reserve(uint32_t capacity);
+  /* new elements are left uninitialized, for the caller to overwrite */
+  void Resize(uint32_t size) {
+    Reserve(size);
+    size_ = size;
+  }
+  void PushBack(const T &value) {
+    if (size_ == capacity_)
+      Reserve(capacity_ * 2);
+    data_[size_++] = value;
+  }
+  void Insert(uint32_t pos, const T &value);
+  void Erase(uint32_t pos);
+
+private:
+  T *data_;
+  uint32_t size_ = 0;
+  uint32_t capacity_ = N;
+  std::pmr::memory_resource *resource_;
+  T inline_[N];
+
+  bool Inline() const { return data_ == inline_; }
+  void Release() {
+    if (!Inline())
+      resource_->deallocate(data_, capacity_ * sizeof(T), alignof(T));
+  }
+};
+
+template <typename T, uint32_t N>
+SmallVector<T, N> &SmallVector<T, N>::operator=(const SmallVector &other) {
+  if (this != &other) {
+    Reserve(other.size_);
+    if (other.size_)
+      memcpy(data_, other.data_, other.size_ * sizeof(T));
+    size_ = other.size_;
+  }
+  return *this;
+}
+
+template <typename T, uint32_t N>
+SmallVector<T, N> &
+SmallVector<T, N>::operator=(SmallVector &&other) noexcept {
+  if (this == &other)
+    return *this;
+  if (other.Inline() || *resource_ != *other.resource_) {
+    *this = static_cast<const SmallVector &>(other);
+    other.size_ = 0;
+    return *this;
+  }
+  /* take over the buffer of the other vector */
+  Release();
+  data_ = other.data_;
+  size_ = other.size_;
+  capacity_ = other.capacity_;
+  other.data_ = other.inline_;
+  other.size_ = 0;
+  other.capacity_ = N;
+  return *this;
+}
+
+template <typename T, uint32_t N>
+void SmallVector<T, N>::Reserve(uint32_t capacity) {
+  if (capacity <= capacity_)
+    return;
+  capacity = std::max(capacity, capacity_ * 2);
+  auto data = static_cast<T *>(
+      resource_->allocate(capacity * sizeof(T), alignof(T)));
+  if (size_)
+    memcpy(data, data_, size_ * sizeof(T));
+  Release();
+  data_ = data;
+  capacity_ = capacity;
+}
+
+template <typename T, uint32_t N>
+void SmallVector<T, N>::Insert(uint32_t pos, const T &value) {
+  assert(pos <= size_);
+  if (size_ == capacity_)
+    Reserve(capacity_ * 2);
+  memmove(data_ + pos + 1, data_ + pos, (size_ - pos) * sizeof(T));
+  data_[pos] = value;
+  size_++;
+}
+
+template <typename T, uint32_t N> void SmallVector<T, N>::Erase(uint32_t pos) {
+  assert(pos < size_);
+  memmove(data_ + pos, data_ + pos + 1, (size_ - pos - 1) * sizeof(T));
+  size_--;
+}
+
+} // namespace util
+
+#endif // TIGER_UTIL_SMALL_VECTOR_H_
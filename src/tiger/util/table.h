@@ -2,92 +2,181 @@
 #define TIGER_UTIL_TABLE_H_
 
 #include <cassert>
+#include <cstdint>
 #include <functional>
+#include <vector>
 
 namespace tab {
+
+/**
+ * Table from pointers to pointers where entering a key again hides its
+ * previous binding until the new one is popped.
+ *
+ * Bindings are kept in a vector in the order they were entered, which is
+ * also the undo log of Pop() and EndScope(). Keys find their visible
+ * binding through an open-addressed index of power-of-two size, probed
+ * linearly from a multiplicative hash of the pointer. Entering a binding
+ * allocates nothing beyond the amortized growth of the two vectors.
+ */
 template <typename KeyType, typename ValueType> class Table {
 public:
-  Table() : top_(nullptr), table_() {}
+  Table() = default;
   void Enter(KeyType *key, ValueType *value);
   ValueType *Look(KeyType *key);
   void Set(KeyType *key, ValueType *value);
   KeyType *Pop();
   void Dump(std::function<void(KeyType *, ValueType *)> show);
 
-protected:
-  static const unsigned long TABSIZE = 127;
-  struct Binder {
-  public:
+  /* bindings entered after BeginScope() are popped by the matching
+   * EndScope() */
+  void BeginScope() { scopes_.push_back(bindings_.size()); }
+  void EndScope();
+
+  /* number of bindings, hidden ones included */
+  [[nodiscard]] size_t Size() const { return bindings_.size(); }
+
+private:
+  static constexpr uint32_t NONE = UINT32_MAX;
+  static constexpr size_t MIN_SLOTS = 16;
+
+  struct Binding {
     KeyType *key;
     ValueType *value;
-    Binder *next;
-    KeyType *prevtop;
+    uint32_t hidden; // the binding of the same key it hides, or NONE
+  };
 
-    Binder(KeyType *key, ValueType *value, Binder *next, KeyType *prevtop)
-        : key(key), value(value), next(next), prevtop(prevtop) {}
+  struct Slot {
+    KeyType *key; // nullptr if the slot is free
+    uint32_t binding;
   };
 
-  Binder *table_[TABSIZE];
-  KeyType *top_;
+  std::vector<Binding> bindings_;
+  std::vector<Slot> slots_;
+  size_t keys_ = 0;
+  int shift_ = 64;
+  std::vector<size_t> scopes_;
+
+  /* Fibonacci hashing, the top bits of the product spread aligned pointers */
+  size_t Home(KeyType *key) const {
+    return (reinterpret_cast<uintptr_t>(key) * 0x9e3779b97f4a7c15ULL) >>
+           shift_;
+  }
+  /* slot of a key, or the free slot where it would go */
+  size_t Probe(KeyType *key) const;
+  Slot *Find(KeyType *key);
+  void Erase(size_t slot);
+  void Grow();
 };
 
 template <typename KeyType, typename ValueType>
 void Table<KeyType, ValueType>::Enter(KeyType *key, ValueType *value) {
-  unsigned long index = reinterpret_cast<unsigned long>(key) % TABSIZE;
-  table_[index] = new Binder(key, value, table_[index], top_);
-  top_ = key;
+  assert(key);
+  if ((keys_ + 1) * 4 > slots_.size() * 3)
+    Grow();
+  Slot &slot = slots_[Probe(key)];
+  uint32_t hidden = NONE;
+  if (slot.key) {
+    hidden = slot.binding;
+  } else {
+    slot.key = key;
+    keys_++;
+  }
+  slot.binding = static_cast<uint32_t>(bindings_.size());
+  bindings_.push_back({key, value, hidden});
 }
 
 template <typename KeyType, typename ValueType>
 ValueType *Table<KeyType, ValueType>::Look(KeyType *key) {
   assert(key);
-  unsigned long index = reinterpret_cast<unsigned long>(key) % TABSIZE;
-  Binder *b;
-  for (b = table_[index]; b; b = b->next)
-    if (b->key == key)
-      return b->value;
-  return nullptr;
+  Slot *slot = Find(key);
+  return slot ? bindings_[slot->binding].value : nullptr;
 }
 
 template <typename KeyType, typename ValueType>
 void Table<KeyType, ValueType>::Set(KeyType *key, ValueType *value) {
   assert(key);
-  unsigned long index = reinterpret_cast<unsigned long>(key) % TABSIZE;
-  Binder *b;
-  for (b = table_[index]; b; b = b->next)
-    if (b->key == key) {
-      b->value = value;
-      return;
-    }
+  if (Slot *slot = Find(key))
+    bindings_[slot->binding].value = value;
 }
 
 template <typename KeyType, typename ValueType>
 KeyType *Table<KeyType, ValueType>::Pop() {
-  KeyType *k = top_;
-  assert(k);
-  unsigned long index = reinterpret_cast<unsigned long>(k) % TABSIZE;
-  Binder *b = table_[index];
-  assert(b);
-  table_[index] = b->next;
-  top_ = b->prevtop;
-  return b->key;
+  assert(!bindings_.empty());
+  Binding binding = bindings_.back();
+  bindings_.pop_back();
+  size_t slot = Probe(binding.key);
+  assert(slots_[slot].key == binding.key);
+  if (binding.hidden != NONE)
+    slots_[slot].binding = binding.hidden;
+  else
+    Erase(slot);
+  return binding.key;
 }
 
 template <typename KeyType, typename ValueType>
 void Table<KeyType, ValueType>::Dump(
     std::function<void(KeyType *, ValueType *)> show) {
-  KeyType *k = top_;
-  unsigned long index = reinterpret_cast<unsigned long>(k) % TABSIZE;
-  Binder *b = table_[index];
-  if (b == nullptr)
-    return;
-  table_[index] = b->next;
-  top_ = b->prevtop;
-  show(b->key, b->value);
-  Dump(show);
-  assert(top_ == b->prevtop && table_[index] == b->next);
-  top_ = k;
-  table_[index] = b;
+  /* latest binding first, like popping them all */
+  for (size_t i = bindings_.size(); i-- > 0;)
+    show(bindings_[i].key, bindings_[i].value);
+}
+
+template <typename KeyType, typename ValueType>
+void Table<KeyType, ValueType>::EndScope() {
+  assert(!scopes_.empty());
+  size_t mark = scopes_.back();
+  scopes_.pop_back();
+  while (bindings_.size() > mark)
+    Pop();
+}
+
+template <typename KeyType, typename ValueType>
+size_t Table<KeyType, ValueType>::Probe(KeyType *key) const {
+  size_t mask = slots_.size() - 1;
+  size_t i = Home(key);
+  while (slots_[i].key && slots_[i].key != key)
+    i = (i + 1) & mask;
+  return i;
+}
+
+template <typename KeyType, typename ValueType>
+typename Table<KeyType, ValueType>::Slot *
+Table<KeyType, ValueType>::Find(KeyType *key) {
+  if (keys_ == 0)
+    return nullptr;
+  Slot &slot = slots_[Probe(key)];
+  return slot.key ? &slot : nullptr;
+}
+
+template <typename KeyType, typename ValueType>
+void Table<KeyType, ValueType>::Erase(size_t slot) {
+  /* shift the rest of the cluster back, so that probes need no tombstones */
+  size_t mask = slots_.size() - 1;
+  slots_[slot].key = nullptr;
+  keys_--;
+  for (size_t i = (slot + 1) & mask; slots_[i].key; i = (i + 1) & mask) {
+    size_t home = Home(slots_[i].key);
+    if (((i - home) & mask) >= ((i - slot) & mask)) {
+      slots_[slot] = slots_[i];
+      slots_[i].key = nullptr;
+      slot = i;
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType>
+void Table<KeyType, ValueType>::Grow() {
+  std::vector<Slot> old;
+  old.swap(slots_);
+  size_t size = old.empty() ? MIN_SLOTS : old.size() * 2;
+  slots_.assign(size, Slot{nullptr, NONE});
+  shift_ = 64;
+  for (size_t s = size; s > 1; s >>= 1)
+    shift_--;
+  for (const Slot &slot : old) {
+    if (slot.key)
+      slots_[Probe(slot.key)] = slot;
+  }
 }
 
 } // namespace tab
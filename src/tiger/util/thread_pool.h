@@ -0,0 +1,160 @@
+#ifndef TIGER_UTIL_THREAD_POOL_H_
+#define TIGER_UTIL_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * A small work-stealing thread pool. Every worker owns a task deque: it pops
+ * its own tasks from the back and steals from the front of other workers'
+ * deques when it runs dry, so long-running tasks do not starve the rest.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(int worker_count);
+  ThreadPool(const ThreadPool &pool) = delete;
+  ThreadPool &operator=(const ThreadPool &pool) = delete;
+  ~ThreadPool();
+
+  /**
+   * Queue a task. Tasks submitted from a worker go to its own deque, others
+   * are spread over the workers round-robin.
+   */
+  void Submit(std::function<void()> task);
+
+  /**
+   * Block until every submitted task has finished
+   */
+  void Wait();
+
+  [[nodiscard]] int WorkerCount() const {
+    return static_cast<int>(workers_.size());
+  }
+
+private:
+  struct Worker {
+    std::mutex mutex_;
+    std::deque<std::function<void()>> tasks_;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  int queued_ = 0;  // tasks sitting in some deque
+  int pending_ = 0; // tasks submitted but not finished
+  int next_ = 0;    // round-robin cursor for outside submissions
+  bool stop_ = false;
+
+  static inline thread_local ThreadPool *owner_ = nullptr;
+  static inline thread_local int self_ = -1;
+
+  bool TryPop(int self, std::function<void()> &task);
+  void Run(int self);
+};
+
+inline ThreadPool::ThreadPool(int worker_count) {
+  if (worker_count < 1)
+    worker_count = 1;
+  for (int i = 0; i < worker_count; i++)
+    workers_.push_back(std::make_unique<Worker>());
+  for (int i = 0; i < worker_count; i++)
+    threads_.emplace_back([this, i] { Run(i); });
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto &thread : threads_)
+    thread.join();
+}
+
+inline void ThreadPool::Submit(std::function<void()> task) {
+  int target;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++pending_;
+    if (owner_ == this) {
+      target = self_;
+    } else {
+      target = next_;
+      next_ = (next_ + 1) % static_cast<int>(workers_.size());
+    }
+  }
+  {
+    Worker &worker = *workers_[target];
+    std::lock_guard<std::mutex> lock(worker.mutex_);
+    worker.tasks_.push_back(std::move(task));
+  }
+  {
+    /* counted once it can be popped, so a worker woken for it finds it;
+     * a worker popping it first takes the count to -1 for a moment */
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++queued_;
+  }
+  wake_.notify_one();
+}
+
+inline void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] { return pending_ == 0; });
+}
+
+inline bool ThreadPool::TryPop(int self, std::function<void()> &task) {
+  int count = static_cast<int>(workers_.size());
+  for (int i = 0; i < count; i++) {
+    Worker &worker = *workers_[(self + i) % count];
+    std::lock_guard<std::mutex> lock(worker.mutex_);
+    if (worker.tasks_.empty())
+      continue;
+    if (i == 0) {
+      /* own deque: LIFO */
+      task = std::move(worker.tasks_.back());
+      worker.tasks_.pop_back();
+    } else {
+      /* steal the oldest task of a victim */
+      task = std::move(worker.tasks_.front());
+      worker.tasks_.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+inline void ThreadPool::Run(int self) {
+  owner_ = this;
+  self_ = self;
+  while (true) {
+    std::function<void()> task;
+    if (TryPop(self, task)) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --queued_;
+      }
+      task();
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--pending_ == 0)
+        idle_.notify_all();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+    if (stop_ && queued_ <= 0)
+      return;
+  }
+}
+
+} // namespace util
+
+#endif // TIGER_UTIL_THREAD_POOL_H_